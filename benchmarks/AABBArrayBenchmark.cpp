@@ -0,0 +1,92 @@
+// AABBArrayBenchmark.cpp - Microbenchmark of the AABB overlap kernel (see AABBArray) against the loop of
+// sf::FloatRect::intersects calls it replaces. Only needs the SFML headers. Build it with optimizations, e.g.:
+//
+//   c++ -std=c++11 -O2 -Iinclude benchmarks/AABBArrayBenchmark.cpp src/X-GSD/AABBArray.cpp            (SSE)
+//   c++ -std=c++11 -O2 -mavx2 -Iinclude benchmarks/AABBArrayBenchmark.cpp src/X-GSD/AABBArray.cpp     (AVX2)
+
+#include <X-GSD/AABBArray.hpp>
+
+#include <SFML/Graphics/Rect.hpp>
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+
+using namespace xgsd;
+
+namespace {
+    
+    typedef std::chrono::high_resolution_clock Clock;
+    
+    // Every box is tested against all the following ones, as the brute force broadphase does
+    std::size_t countOverlapsScalar(const std::vector<sf::FloatRect>& boxes)
+    {
+        std::size_t overlaps = 0;
+        
+        for (std::size_t i = 0; i < boxes.size(); ++i)
+            for (std::size_t j = i + 1; j < boxes.size(); ++j)
+                if (boxes[i].intersects(boxes[j]))
+                    ++overlaps;
+        
+        return overlaps;
+    }
+    
+    std::size_t countOverlapsKernel(const std::vector<sf::FloatRect>& boxes, const AABBArray& packedBoxes, std::vector<std::uint32_t>& results)
+    {
+        std::size_t overlaps = 0;
+        
+        for (std::size_t i = 0; i < boxes.size(); ++i)
+            overlaps += packedBoxes.findOverlaps(boxes[i], i + 1, packedBoxes.size(), results);
+        
+        return overlaps;
+    }
+    
+    template <typename Function>
+    double measurePairsPerSecond(std::size_t pairs, int repetitions, std::size_t& overlaps, Function function)
+    {
+        auto start = Clock::now();
+        
+        for (int i = 0; i < repetitions; ++i)
+            overlaps = function();
+        
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        return pairs * repetitions / elapsed.count();
+    }
+    
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    std::size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4096;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 10;
+    
+    // Random boxes of 8 to 64 pixels in a 1920x1080 world, similar to the sprites of a game
+    std::default_random_engine randomEngine(42);
+    std::uniform_real_distribution<float> position(0.f, 1920.f);
+    std::uniform_real_distribution<float> size(8.f, 64.f);
+    
+    std::vector<sf::FloatRect> boxes;
+    AABBArray packedBoxes;
+    
+    for (std::size_t i = 0; i < count; ++i) {
+        boxes.push_back(sf::FloatRect(position(randomEngine), position(randomEngine) * 1080.f / 1920.f, size(randomEngine), size(randomEngine)));
+        packedBoxes.push_back(boxes.back());
+    }
+    
+    std::vector<std::uint32_t> results;
+    std::size_t pairs = count * (count - 1) / 2;
+    std::size_t scalarOverlaps = 0, kernelOverlaps = 0;
+    
+    double scalar = measurePairsPerSecond(pairs, repetitions, scalarOverlaps, [&] { return countOverlapsScalar(boxes); });
+    double kernel = measurePairsPerSecond(pairs, repetitions, kernelOverlaps, [&] { return countOverlapsKernel(boxes, packedBoxes, results); });
+    
+    std::cout << count << " boxes, " << pairs << " pairs, kernel width " << AABBArray::KernelWidth << std::endl;
+    std::cout << "sf::FloatRect::intersects: " << scalar / 1e6 << " Mpairs/s (" << scalarOverlaps << " overlaps)" << std::endl;
+    std::cout << "AABBArray::findOverlaps:   " << kernel / 1e6 << " Mpairs/s (" << kernelOverlaps << " overlaps)" << std::endl;
+    std::cout << "Speedup: " << kernel / scalar << "x" << std::endl;
+    
+    // Both must find exactly the same pairs
+    return scalarOverlaps == kernelOverlaps ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ Collision layers of the example game. Set them as the category and mask bits of the ComponentColliders
+ (the ones of the player and the prefabs are set in GameScene.json, so they must match these values).
+ */
+namespace CollisionCategories {
+	
+	const std::uint16_t Player		= 0x0001;
+	const std::uint16_t Bullet		= 0x0002;
+	const std::uint16_t Asteroid	= 0x0004;
+	
+} // namespace CollisionCategories
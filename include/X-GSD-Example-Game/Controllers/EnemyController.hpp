@@ -14,9 +14,10 @@ public:
 	EnemyController();
 	~EnemyController();
 	
+	unsigned			getCallbacks() const override;
 	void				onEntityAttach() override;
     void                update(const HiResDuration &dt) override;
-	void				collisionHandler(Entity *theOtherEntity, sf::FloatRect collision) override;
+	void				onCollisionEnter(Entity *theOtherEntity, sf::FloatRect collision) override;
 		
 	// Variables (member / properties)
 private:
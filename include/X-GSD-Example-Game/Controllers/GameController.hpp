@@ -16,15 +16,17 @@ public:
 	GameController();
 	~GameController();
 	
+	unsigned				getCallbacks() const override;
 	void					onEntityAttach() override;
 	void					update(const xgsd::HiResDuration& dt) override;
-	void					draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+	void					draw(xgsd::RenderCommandList& target, sf::RenderStates states) const override;
 	void					handleEvent(const Event& event) override;
 	
 private:
 	void					pause();
 	void					gameOver();
 	void					spawnAsteroid();
+	void					centerText(sf::Text& text);
 	
 	// Variables (member / properties)
 private:
@@ -50,6 +52,7 @@ private:
 	sf::Text				mCentralText;
 	bool					mPaused;
 	bool					mStopped;
+	const Prefab*			mAsteroidPrefabs[3];
 		
 	std::default_random_engine			randomEngine;
 	std::uniform_int_distribution<int>	randomasteroidScaleValues;
@@ -14,10 +14,11 @@ public:
 	PlayerController();
 	~PlayerController();
 	
+	unsigned			getCallbacks() const override;
 	void				onEntityAttach() override;
 	void				update(const HiResDuration& dt) override;
 	void				handleEvent(const Event& event) override;
-	void				collisionHandler(Entity* theOtherEntity, sf::FloatRect collision) override;
+	void				onCollisionEnter(Entity* theOtherEntity, sf::FloatRect collision) override;
 		
 private:
 	void				handleRealTimeInput(const HiResDuration& dt);
@@ -31,6 +32,7 @@ private:
 	sf::Sound			mShootingSound;
 	sf::Sound			mDieSound;
     int                 mNumShots;
+	const Prefab*		mBulletPrefab;
     
 	ComponentRigidBody* rigidBody;
 	ComponentSprite*	sprite;
@@ -18,9 +18,10 @@ public:
 	TitleMenuController();
 	~TitleMenuController();
 	
+	unsigned				getCallbacks() const override;
 	void					onEntityAttach() override;
 	void					update(const HiResDuration& dt) override;
-	void					draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+	void					draw(xgsd::RenderCommandList& target, sf::RenderStates states) const override;
 	void					handleEvent(const Event& event) override;
 	
 	// Variables (member / properties)
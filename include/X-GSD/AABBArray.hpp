@@ -0,0 +1,51 @@
+#pragma once
+
+#include <SFML/Graphics/Rect.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cassert>
+
+namespace xgsd {
+    
+    /*
+     AABBArray class. Packed array of axis-aligned bounding boxes, stored as four separate arrays (min x,
+     min y, max x and max y) so that one box can be tested against several boxes at once with SIMD
+     instructions: 8 boxes per instruction with AVX2, 4 with SSE, or one by one with the scalar fallback when
+     none of them is available (see KernelWidth).
+     
+     The overlap test gives the same result as sf::FloatRect::intersects: boxes which only touch, or have no
+     area, do not overlap. The arrays are padded with empty boxes, so the kernel never needs a scalar loop
+     for the remaining boxes of a range.
+     */
+    class AABBArray
+    {
+        // Typedefs and enumerations
+    public:
+        static const std::size_t KernelWidth; // Boxes tested at once
+        
+        // Methods
+    public:
+        AABBArray();
+        
+        void                    clear();
+        void                    push_back(const sf::FloatRect& bounds);
+        void                    set(std::size_t index, const sf::FloatRect& bounds);
+        void                    swapAndPop(std::size_t index);
+        std::size_t             size() const;
+        
+        std::size_t             findOverlaps(const sf::FloatRect& bounds, std::size_t begin, std::size_t end, std::vector<std::uint32_t>& overlaps) const;
+    
+    private:
+        unsigned                overlapMask(std::size_t index, const float* bounds) const;
+        
+        // Variables (member / properties)
+    private:
+        std::vector<float>      mMinX;
+        std::vector<float>      mMinY;
+        std::vector<float>      mMaxX;
+        std::vector<float>      mMaxY;
+        std::size_t             mSize;
+    };
+    
+} // namespace xgsd
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <SFML/Graphics/Rect.hpp>
+
+#include <vector>
+#include <cassert>
+
+namespace xgsd {
+    
+    // Forward declaration
+    class ComponentCollider;
+    
+    /*
+     AABBTree class. Dynamic bounding volume hierarchy of axis-aligned bounding boxes, used by the
+     PhysicsEngine to store colliders which rarely move (static colliders). Each collider is a leaf of the
+     tree (a proxy), and every internal node holds the union of the bounds of its children, so a query only
+     visits the branches overlapping the queried bounds: O(log n) instead of testing every collider.
+     
+     The tree is kept balanced with AVL-like rotations when proxies are inserted or removed. The bounds of the
+     leaves are enlarged by a margin, so that small movements of a collider do not require any update of the
+     tree (see move). rebuild builds an optimal tree from scratch, which is useful after loading a scene.
+     */
+    class AABBTree
+    {
+        // Typedefs and enumerations
+    public:
+        static const int NullNode = -1;
+    
+    private:
+        struct Node
+        {
+            bool                isLeaf() const { return child1 == NullNode; }
+            
+            sf::FloatRect       bounds;     // Enlarged bounds of the leaf, or union of the children bounds
+            ComponentCollider*  collider;   // Only for leaves
+            int                 parent;     // Next free node when the node is in the free list
+            int                 child1;
+            int                 child2;
+            int                 height;     // Leaves have height 0, free nodes -1
+        };
+        
+        // Methods
+    public:
+        AABBTree(float margin = 2.f);
+        
+        int                     insert(const sf::FloatRect& bounds, ComponentCollider* collider);
+        void                    remove(int proxy);
+        bool                    move(int proxy, const sf::FloatRect& bounds);
+        void                    rebuild();
+        void                    clear();
+        
+        template <typename Callback>
+        void                    query(const sf::FloatRect& bounds, Callback callback) const;
+        
+        ComponentCollider*      getCollider(int proxy) const;
+        const sf::FloatRect&    getFatBounds(int proxy) const;
+        int                     getHeight() const;
+        std::size_t             getProxyCount() const;
+    
+    private:
+        int                     allocateNode();
+        void                    freeNode(int index);
+        void                    insertLeaf(int leaf);
+        void                    removeLeaf(int leaf);
+        int                     balance(int index);
+        int                     buildTopDown(int* leaves, int count);
+        
+        // Variables (member / properties)
+    private:
+        std::vector<Node>       mNodes;
+        int                     mRoot;
+        int                     mFreeList;
+        std::size_t             mProxyCount;
+        float                   mMargin;
+    };
+    
+    
+    
+    /////////////////////////////
+    // Template implementation //
+    /////////////////////////////
+    
+    /* Calls callback(ComponentCollider*) for every proxy whose enlarged bounds overlap the given bounds.
+     The callback must perform the exact intersection test if needed. It is safe to call query from several
+     threads at the same time, as long as the tree is not modified meanwhile. */
+    template <typename Callback>
+    void AABBTree::query(const sf::FloatRect& bounds, Callback callback) const
+    {
+        if (mRoot == NullNode)
+            return;
+        
+        // The tree is balanced, so its height is logarithmic and this stack is never exhausted
+        int stack[256];
+        int stackSize = 0;
+        stack[stackSize++] = mRoot;
+        
+        while (stackSize > 0) {
+            const Node& node = mNodes[stack[--stackSize]];
+            
+            // Skip the branch if its bounds do not overlap
+            if (node.bounds.left > bounds.left + bounds.width || bounds.left > node.bounds.left + node.bounds.width ||
+                node.bounds.top > bounds.top + bounds.height || bounds.top > node.bounds.top + node.bounds.height)
+                continue;
+            
+            if (node.isLeaf()) {
+                callback(node.collider);
+            }
+            else {
+                assert(stackSize + 2 <= 256);
+                stack[stackSize++] = node.child1;
+                stack[stackSize++] = node.child2;
+            }
+        }
+    }
+    
+} // namespace xgsd
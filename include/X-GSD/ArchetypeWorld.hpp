@@ -0,0 +1,278 @@
+#pragma once
+
+#include <X-GSD/Time.hpp>
+
+#include <SFML/System/NonCopyable.hpp>
+
+#include <vector>
+#include <array>
+#include <bitset>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+
+namespace xgsd {
+    
+    /*
+     ArchetypeWorld class. Optional data oriented storage for entities, alongside the scene graph. A world
+     entity is just an id holding plain values (columns) of any type: e.g. a struct with a velocity. All the
+     entities with the same set of column types (their archetype) are packed together, one contiguous array per
+     column type, so that systems iterate over them linearly with forEach instead of visiting the scene graph:
+     
+     world.forEach<Position, Velocity>([dt] (ArchetypeWorld::EntityId id, Position& position, Velocity& velocity) {
+         ...
+     });
+     
+     Systems are functions registered with addSystem, called on every update of the Scene owning the world
+     (see Scene::getWorld). Components and controllers keep working as usual: they can move their hot data to
+     the world of the scene through the id of their Entity (see Entity::getWorldEntity), which also stores the
+     Entity* as a column so that systems can reach the scene graph.
+     
+     Adding or removing a column moves the entity to another archetype. Entities must not be created,
+     destroyed, or have columns added or removed while forEach iterates over them.
+     */
+    class ArchetypeWorld : private sf::NonCopyable
+    {
+        // Typedefs and enumerations
+    public:
+        typedef std::uint32_t   EntityId;
+        typedef std::uint8_t    ColumnTypeId;
+        typedef std::function<void(ArchetypeWorld& world, const HiResDuration& dt)> System;
+        
+        static const std::size_t    MaxColumnTypes = 64;
+        static const EntityId       InvalidEntity = 0xFFFFFFFF;
+    
+    private:
+        typedef std::bitset<MaxColumnTypes> Signature;
+        
+        // How to handle the values of a column type without knowing it
+        struct ColumnType
+        {
+            std::size_t size;
+            void        (*moveConstruct)(void* destination, void* source);
+            void        (*destroy)(void* value);
+        };
+        
+        // Packed values of one column type, for all the entities of an archetype
+        class Column
+        {
+        public:
+            explicit Column(ColumnTypeId typeId);
+            Column(Column&& other);
+            ~Column();
+            
+            void*               at(std::size_t row);
+            void*               pushBack(); // Memory for a new value at the end, which must be constructed by the caller
+            void                pushBackMoved(void* value);
+            void                swapAndPop(std::size_t row);
+        
+        private:
+            void                reserve(std::size_t capacity);
+        
+        private:
+            ColumnType          mType;
+            unsigned char*      mData;
+            std::size_t         mSize;
+            std::size_t         mCapacity;
+        };
+        
+        // All the entities with the same set of column types
+        struct Archetype
+        {
+            Signature                               signature;
+            std::vector<ColumnTypeId>               types;
+            std::array<int, MaxColumnTypes>         columnIndices; // Index in columns of every ColumnTypeId, -1 if not in the archetype
+            std::vector<Column>                     columns;
+            std::vector<EntityId>                   entities; // Entity of every row
+        };
+        
+        struct EntityRecord
+        {
+            Archetype*      archetype; // nullptr if the id is free
+            std::size_t     row;
+        };
+        
+        // Methods
+    public:
+        ArchetypeWorld();
+        
+        EntityId                create();
+        void                    destroy(EntityId entity);
+        bool                    isAlive(EntityId entity) const;
+        void                    clear();
+        
+        template <typename T>
+        T&                      add(EntityId entity, T value = T());
+        template <typename T>
+        void                    remove(EntityId entity);
+        template <typename T>
+        T*                      get(EntityId entity);
+        template <typename T>
+        bool                    has(EntityId entity) const;
+        
+        template <typename... Ts, typename Function>
+        void                    forEach(Function function);
+        
+        void                    addSystem(System system);
+        void                    update(const HiResDuration& dt);
+        
+        std::size_t             getEntityCount() const;
+        std::size_t             getArchetypeCount() const;
+        
+        template <typename T>
+        static ColumnTypeId     getColumnTypeId();
+    
+    private:
+        Archetype*              findOrCreateArchetype(const Signature& signature);
+        void                    moveEntity(EntityId entity, Archetype* destination);
+        void                    removeRow(Archetype* archetype, std::size_t row);
+        
+        template <typename T>
+        T*                      getColumnData(Archetype& archetype);
+        
+        template <typename Function, typename... Ts>
+        static void             forEachRow(const std::vector<EntityId>& entities, Function& function, Ts*... columns);
+        
+        static ColumnTypeId     registerColumnType(const ColumnType& type);
+        static const ColumnType& getColumnType(ColumnTypeId typeId);
+        static std::vector<ColumnType>& getColumnTypes();
+        
+        template <typename T>
+        static void             moveConstructValue(void* destination, void* source);
+        template <typename T>
+        static void             destroyValue(void* value);
+        
+        // Variables (member / properties)
+    private:
+        std::vector<std::unique_ptr<Archetype>>             mArchetypes; // The first one is the empty archetype
+        std::unordered_map<unsigned long long, Archetype*>  mArchetypesBySignature;
+        std::vector<EntityRecord>                           mRecords; // Indexed by EntityId
+        std::vector<EntityId>                               mFreeIds;
+        std::size_t                                         mEntityCount;
+        std::vector<System>                                 mSystems;
+        int                                                 mIterating; // Nested forEach calls running
+    };
+    
+    
+    
+    /////////////////////////////
+    // Template implementation //
+    /////////////////////////////
+    
+    template <typename T>
+    T& ArchetypeWorld::add(EntityId entity, T value)
+    {
+        assert(isAlive(entity) && mIterating == 0);
+        
+        ColumnTypeId typeId = getColumnTypeId<T>();
+        EntityRecord& record = mRecords[entity];
+        
+        // Already in its archetype, just replace the value
+        if (record.archetype->signature.test(typeId)) {
+            T* current = get<T>(entity);
+            *current = std::move(value);
+            return *current;
+        }
+        
+        Signature signature = record.archetype->signature;
+        Archetype* destination = findOrCreateArchetype(signature.set(typeId));
+        moveEntity(entity, destination);
+        
+        // The other columns already have the value of the entity at the end
+        Column& column = destination->columns[destination->columnIndices[typeId]];
+        return *new (column.pushBack()) T(std::move(value));
+    }
+    
+    template <typename T>
+    void ArchetypeWorld::remove(EntityId entity)
+    {
+        assert(isAlive(entity) && mIterating == 0);
+        
+        ColumnTypeId typeId = getColumnTypeId<T>();
+        Signature signature = mRecords[entity].archetype->signature;
+        
+        if (!signature.test(typeId))
+            return;
+        
+        // The value is destroyed when the entity leaves its current archetype
+        moveEntity(entity, findOrCreateArchetype(signature.reset(typeId)));
+    }
+    
+    template <typename T>
+    T* ArchetypeWorld::get(EntityId entity)
+    {
+        assert(isAlive(entity));
+        
+        const EntityRecord& record = mRecords[entity];
+        int column = record.archetype->columnIndices[getColumnTypeId<T>()];
+        
+        return column >= 0 ? static_cast<T*>(record.archetype->columns[column].at(record.row)) : nullptr;
+    }
+    
+    template <typename T>
+    bool ArchetypeWorld::has(EntityId entity) const
+    {
+        assert(isAlive(entity));
+        return mRecords[entity].archetype->signature.test(getColumnTypeId<T>());
+    }
+    
+    /* Calls function(EntityId, Ts&...) for every entity which has all the given column types. The archetypes
+     are visited one by one, and the rows of each one in order, so the values are read sequentially. */
+    template <typename... Ts, typename Function>
+    void ArchetypeWorld::forEach(Function function)
+    {
+        Signature required;
+        
+        for (ColumnTypeId typeId : { getColumnTypeId<Ts>()... })
+            required.set(typeId);
+        
+        ++mIterating;
+        
+        for (auto& archetype : mArchetypes)
+            if ((archetype->signature & required) == required && !archetype->entities.empty())
+                forEachRow(archetype->entities, function, getColumnData<Ts>(*archetype)...);
+        
+        --mIterating;
+    }
+    
+    template <typename T>
+    T* ArchetypeWorld::getColumnData(Archetype& archetype)
+    {
+        return static_cast<T*>(archetype.columns[archetype.columnIndices[getColumnTypeId<T>()]].at(0));
+    }
+    
+    template <typename Function, typename... Ts>
+    void ArchetypeWorld::forEachRow(const std::vector<EntityId>& entities, Function& function, Ts*... columns)
+    {
+        for (std::size_t row = 0; row < entities.size(); ++row)
+            function(entities[row], columns[row]...);
+    }
+    
+    template <typename T>
+    ArchetypeWorld::ColumnTypeId ArchetypeWorld::getColumnTypeId()
+    {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "ArchetypeWorld columns do not support over-aligned types");
+        
+        // Registered only once per type, then every call is just a read
+        static const ColumnTypeId typeId = registerColumnType({ sizeof(T), &moveConstructValue<T>, &destroyValue<T> });
+        return typeId;
+    }
+    
+    template <typename T>
+    void ArchetypeWorld::moveConstructValue(void* destination, void* source)
+    {
+        new (destination) T(std::move(*static_cast<T*>(source)));
+    }
+    
+    template <typename T>
+    void ArchetypeWorld::destroyValue(void* value)
+    {
+        static_cast<T*>(value)->~T();
+    }
+    
+} // namespace xgsd
@@ -3,9 +3,15 @@
 #include <X-GSD/Time.hpp>
 #include <X-GSD/Debug.hpp>
 #include <X-GSD/Event.hpp>
+#include <X-GSD/PoolAllocator.hpp>
+#include <X-GSD/RenderCommandList.hpp>
 
 #include <SFML/System/NonCopyable.hpp>
-#include <SFML/Graphics/RenderTarget.hpp>
+
+#include <typeindex>
+#include <typeinfo>
+#include <type_traits>
+#include <cstdint>
 
 namespace xgsd {
     
@@ -17,18 +23,54 @@ namespace xgsd {
      add functionality. It also serves as base class to be inherited from user-defined controllers (the name
      "controller" refers to Components created by a user of X-GSD and added to any Entity to give it custom
      behaviour. It is the "scripting" part of X-GSD).
+     
+     Every Component type gets a small integer TypeId the first time it is used, so that Entities can store
+     their components in a table indexed by it (see Entity::getComponent). Components are allocated by the
+     PoolAllocator, like entities.
+     
+     Components declare the callbacks they actually use with getCallbacks, so that Entities only call those.
+     By default a component gets all of them. Derived classes can override it to return
+     getOverriddenCallbacks<T>(), which detects at compile time the callbacks overridden by T:
+     
+     unsigned getCallbacks() const override { return getOverriddenCallbacks<MyController>(); }
+     
+     The mask only applies to components whose dynamic type is T: classes derived from one that does so get
+     all the callbacks (as if they did not override getCallbacks), unless they override it again with their
+     own type. So a callback is never skipped just because a base class did not know about it.
      */
     class Component : sf::NonCopyable
     {
         // Typedefs and enumerations
     public:
         typedef std::unique_ptr<Component> Ptr;
+        typedef std::uint16_t              TypeId;
+        
+        // Callbacks a component can be interested in (see getCallbacks)
+        enum Callbacks
+        {
+            NoCallbacks         = 0,
+            UpdateCallback      = 1 << 0,
+            DrawCallback        = 1 << 1,
+            HandleEventCallback = 1 << 2,
+            PauseCallback       = 1 << 3,
+            CollisionCallbacks  = 1 << 4, // collisionHandler, onCollisionEnter, onCollisionStay and onCollisionExit
+            AllCallbacks        = UpdateCallback | DrawCallback | HandleEventCallback | PauseCallback | CollisionCallbacks
+        };
         
         // Methods
     public:
         Component();
         virtual ~Component();
         
+        static void*            operator new(std::size_t size);
+        static void             operator delete(void* pointer, std::size_t size);
+        
+        template <typename T>
+        static TypeId           getTypeId();
+        static TypeId           getTypeId(const std::type_index& type);
+        
+        virtual unsigned        getCallbacks() const;
+        
         virtual void            attachedToEntity();
         virtual void            detachedFromEntity();
         
@@ -37,11 +79,18 @@ namespace xgsd {
         virtual void            onPause(const HiResDuration& dt);
         
         virtual void            update(const HiResDuration& dt);
-        virtual void            draw(sf::RenderTarget& target, sf::RenderStates states) const;
+        virtual void            draw(RenderCommandList& target, sf::RenderStates states) const;
         virtual void            handleEvent(const Event& event);
         
         // Callbacks for other common components
         virtual void            collisionHandler(Entity* theOtherEntity, sf::FloatRect collision);
+        virtual void            onCollisionEnter(Entity* theOtherEntity, sf::FloatRect collision);
+        virtual void            onCollisionStay(Entity* theOtherEntity, sf::FloatRect collision);
+        virtual void            onCollisionExit(Entity* theOtherEntity);
+    
+    protected:
+        template <typename T>
+        unsigned                getOverriddenCallbacks() const;
         
         // Variables (member / properties)
     public:
@@ -49,4 +98,50 @@ namespace xgsd {
         
     };
     
+    
+    
+    /////////////////////////////
+    // Template implementation //
+    /////////////////////////////
+    
+    template <typename T>
+    Component::TypeId Component::getTypeId()
+    {
+        // Looked up only once per type, then every call is just a read
+        static const TypeId typeId = getTypeId(std::type_index(typeid(T)));
+        return typeId;
+    }
+    
+    /* Callbacks overridden by T or any of its bases, if this component is exactly a T (all of them otherwise,
+     see the class description). When T does not override a method, &T::method is still a pointer to a member
+     of Component, so the check is done on the types. Only the type of the component is checked at runtime,
+     when it is added to an entity. */
+    template <typename T>
+    unsigned Component::getOverriddenCallbacks() const
+    {
+        static_assert(std::is_base_of<Component, T>::value, "T must derive from Component");
+        
+        // A class derived from T, which may override callbacks that T does not
+        if (typeid(*this) != typeid(T))
+            return AllCallbacks;
+        
+        unsigned callbacks = NoCallbacks;
+        
+        if (!std::is_same<decltype(&T::update), decltype(&Component::update)>::value)
+            callbacks |= UpdateCallback;
+        if (!std::is_same<decltype(&T::draw), decltype(&Component::draw)>::value)
+            callbacks |= DrawCallback;
+        if (!std::is_same<decltype(&T::handleEvent), decltype(&Component::handleEvent)>::value)
+            callbacks |= HandleEventCallback;
+        if (!std::is_same<decltype(&T::onPause), decltype(&Component::onPause)>::value)
+            callbacks |= PauseCallback;
+        if (!std::is_same<decltype(&T::collisionHandler), decltype(&Component::collisionHandler)>::value
+            || !std::is_same<decltype(&T::onCollisionEnter), decltype(&Component::onCollisionEnter)>::value
+            || !std::is_same<decltype(&T::onCollisionStay), decltype(&Component::onCollisionStay)>::value
+            || !std::is_same<decltype(&T::onCollisionExit), decltype(&Component::onCollisionExit)>::value)
+            callbacks |= CollisionCallbacks;
+        
+        return callbacks;
+    }
+    
 } // namespace xgsd
@@ -7,6 +7,8 @@
 #include <SFML/Graphics/Rect.hpp>
 #include <SFML/Graphics/RectangleShape.hpp>
 
+#include <cstdint>
+
 namespace xgsd {
     
     // Forward declarations
@@ -26,6 +28,11 @@ namespace xgsd {
      The main use of Dynamic Colliders is for moving elements of the game, such as the player, the enemies,
      bullets, etc. The PhysicsEngine will check collisions between Dynamic Colliders (e.g. a bullet hit the
      player), and between these and Static Colliders (e.g. the player touches a wall).
+     
+     Colliders can be filtered with collision layers: each collider belongs to the categories set in its
+     category bits, and only collides with the categories set in its mask bits. Two colliders are only tested
+     if each one's category is accepted by the other's mask, so pairs that never matter (e.g. bullet-bullet)
+     are discarded by the broadphase. By default colliders belong to the first category and collide with all.
      */
     class ComponentCollider : public Component
     {
@@ -34,9 +41,11 @@ namespace xgsd {
         ComponentCollider(sf::FloatRect rectBounds = sf::FloatRect());
         ~ComponentCollider();
         
+        unsigned            getCallbacks() const override;
         void                onEntityAttach() override;
+        void                onEntityDetach() override;
         void                update(const HiResDuration& dt) override;
-        void                draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+        void                draw(RenderCommandList& target, sf::RenderStates states) const override;
         void                handleEvent(const Event& event) override;
         
         void                collisionHandler(Entity* theOtherEntity, sf::FloatRect collision) override;
@@ -45,10 +54,26 @@ namespace xgsd {
         void                setRectBounds(sf::FloatRect rect);
         sf::FloatRect       getRectBounds();
         
+        void                setCategoryBits(std::uint16_t categoryBits);
+        std::uint16_t       getCategoryBits() const;
+        void                setMaskBits(std::uint16_t maskBits);
+        std::uint16_t       getMaskBits() const;
+        
+        // Called from the broadphase hot loops, so they are defined here to be inlined
+        bool                canCollide() const { return mCategoryBits != 0 && mMaskBits != 0; }
+        bool                canCollideWith(const ComponentCollider& other) const { return (mCategoryBits & other.mMaskBits) != 0 && (other.mCategoryBits & mMaskBits) != 0; }
+        
+        void                updateWorldBounds();
+        const sf::FloatRect& getWorldBounds() const;
+        
         // Variables (member / properties)
     private:
         bool                mStatic;
+        bool                mRegistered; // If it has been added to the PhysicsEngine
         sf::FloatRect       mRectBounds;
+        sf::FloatRect       mWorldBounds; // mRectBounds transformed to world coordinates, updated once per step by the PhysicsEngine
+        std::uint16_t       mCategoryBits; // Categories this collider belongs to
+        std::uint16_t       mMaskBits;     // Categories this collider collides with
         
 #ifdef DEBUG
         Entity*             mLastCollidedEntity;
@@ -2,9 +2,9 @@
 
 #include <X-GSD/Component.hpp>
 #include <X-GSD/Entity.hpp> // Completes forward declaration in Component
-#include <X-GSD/PhysicState.hpp>
+#include <X-GSD/RigidBodyStore.hpp>
 
-#include <SFML/Graphics/Transformable.hpp>
+#include <SFML/System/Vector2.hpp>
 
 namespace xgsd {
     
@@ -14,6 +14,9 @@ namespace xgsd {
      trigger collisions. If the ComponentRigidBody is set as Kinematic, the Entity will not get its position
      automatically updated, but it will still trigger collisions.
      
+     The physics state is not stored in the component but in the RigidBodyStore of the PhysicsEngine, which
+     integrates all the bodies at once on every step. The component only holds the id of its body.
+     
      Note: This component does not offer automatic physics-based collision reactions (i.e. preventing the
      player from falling through the floor, or making a ball to bounce). The desired reactions must be
      implemented in a custom Component (a controller), or extend the functionality of this class to provide
@@ -26,27 +29,36 @@ namespace xgsd {
         ComponentRigidBody(bool isKinematic);
         ~ComponentRigidBody();
             
+        unsigned            getCallbacks() const override;
         void                onEntityAttach() override;
-        void                update(const HiResDuration& dt) override;
+        void                onEntityDetach() override;
         
         void                returnToLastPhysicsState();
         // TODO: override collisionHandler method for a physics automatic collision response (modify the physics state accordingly to that collision)
         
-        // TODO: Add setters and getters regarding the mPhysics and use them at JSON scene loading
-        PhysicState&        getPhysicsState();
+        // TODO: Use them at JSON scene loading
+        void                setVelocity(sf::Vector2f velocity);
+        sf::Vector2f        getVelocity() const;
+        void                setForce(sf::Vector2f force);
+        sf::Vector2f        getForce() const;
+        void                setMass(float mass);
+        float               getMass() const;
         
         void                pausePhysics();
         void                resumePhysics();
+    
+    private:
+        void                updateSimulated();
         
         // Variables (member / properties)
     private:
         
         bool                mKinematic;
         bool                mPausedPhysics;
+        bool                mAttached;
         
-        PhysicState         mPhysics;
-        PhysicState         mLastPhysicsState;
-        sf::Transformable   mLastTransformable;
+        RigidBodyStore&     mStore;
+        int                 mBody; // Id of the body in mStore
         
         // TODO: More member variables such as "affectedByGravity", "friction", "airFriction" or "bounceRatio"
     };
@@ -9,7 +9,10 @@ namespace xgsd {
     /*
      ComponentSprite class. Add this component to an entity to give it a sprite (basic visual representation
      of a texture). Specify a texture rectangle (with the overloaded constructor or the setter) in order to
-     use a portion of the texture instead of the whole.
+     use a portion of the texture instead of the whole. Textures packed in an atlas (see
+     TextureManager::loadAtlas) are drawn from their page, but texture rects are still relative to the texture.
+     Finding the page takes a lookup, so code creating many sprites of the same texture (see Prefab) can do it
+     once with resolveTexture.
      
      Attention: This class is in very basic state and functionality, totally subject to change.
      */
@@ -17,13 +20,26 @@ namespace xgsd {
     // TODO: Transform this component in something more generic (i.e. ComponentRenderer) which hold a sf::Shape, text, a sf::Sprite... any sf::Drawable derived class.
     class ComponentSprite : public Component
     {
+        // Typedefs and enumerations
+    public:
+        // A texture with its atlas page and texture rect already looked up
+        struct ResolvedTexture
+        {
+            const sf::Texture*  texture;        // As given
+            const sf::Texture*  drawnTexture;   // Its atlas page, or the texture itself if it is not packed
+            sf::Vector2i        atlasOffset;    // Position of the texture in its atlas page, if any
+            sf::IntRect         textureRect;    // Relative to the texture
+        };
+        
         // Methods
     public:
         ComponentSprite(const sf::Texture& texture);
         ComponentSprite(const sf::Texture& texture, sf::IntRect textureRect);
+        explicit ComponentSprite(const ResolvedTexture& resolvedTexture);
         ~ComponentSprite();
         
-        void                    draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+        unsigned                getCallbacks() const override;
+        void                    draw(RenderCommandList& target, sf::RenderStates states) const override;
         
         sf::FloatRect           getGlobalBounds();
         sf::Color               getColor();
@@ -34,10 +50,17 @@ namespace xgsd {
         void                    setTexture(sf::Texture& texture);
         void                    setTextureRect(sf::IntRect textureRect);
         
+        static ResolvedTexture  resolveTexture(const sf::Texture& texture);
+        static ResolvedTexture  resolveTexture(const sf::Texture& texture, sf::IntRect textureRect);
+    
+    private:
+        void                    applyTexture(const ResolvedTexture& resolvedTexture);
         
         // Variables (member / properties)
     private:
         sf::Sprite              mSprite;
+        const sf::Texture*      mTexture;       // As given, mSprite may use its atlas page instead
+        sf::Vector2i            mAtlasOffset;   // Position of the texture in its atlas page, if any
     };
     
 } // namespace xgsd
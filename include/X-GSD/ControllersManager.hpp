@@ -3,6 +3,7 @@
 #include <X-GSD/Component.hpp>
 
 #include <unordered_map>
+#include <functional>
 #include <stdexcept>
 
 namespace xgsd {
@@ -11,20 +12,26 @@ namespace xgsd {
      ControllersManager class. This utility class contains methods to register and create
      ControllerComponents in a dynamic manner. Use registerController method to store a pointer to the
      constructor of that type of controller associated with a name (std::string). Then, use
-     getController(std::string controllerName) to create controllers of the desired type.
+     getController(std::string controllerName) to create controllers of the desired type, or keep the factory
+     given by getControllerFactory to create them without looking it up every time (e.g. in a Prefab).
      */
     class ControllersManager
     {
+        // Typedefs and enumerations
+    public:
+        typedef std::function<Component::Ptr()> Factory;
+        
         // Methods
     public:
         template <typename T>
         void            registerController(std::string controllerName);
         
         Component::Ptr  getController(std::string controllerName);
+        const Factory&  getControllerFactory(std::string controllerName);
         
         // Variables (member / properties)
     private:
-        std::unordered_map<std::string, std::function<Component::Ptr()>> mControllerFactories;
+        std::unordered_map<std::string, Factory> mControllerFactories;
     };
     
     
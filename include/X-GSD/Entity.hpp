@@ -3,17 +3,16 @@
 #include <X-GSD/SceneGraphNode.hpp>
 #include <X-GSD/Event.hpp>
 #include <X-GSD/Component.hpp>
+#include <X-GSD/ArchetypeWorld.hpp>
+#include <X-GSD/EntityRegistry.hpp>
 
 // Include all built-in components
 #include <X-GSD/ComponentSprite.hpp>
 #include <X-GSD/ComponentRigidBody.hpp>
 #include <X-GSD/ComponentCollider.hpp>
 
-#include <SFML/Graphics/RenderTarget.hpp> // Completes the RenderTarget forward declaration in Drawable, inherited from SceneGrahpNode
-
-#include <map>
-#include <unordered_map>
-#include <typeindex>
+#include <vector>
+#include <algorithm>
 #include <cassert>
 
 namespace xgsd {
@@ -21,9 +20,20 @@ namespace xgsd {
     /*
      Entity class. Entities are the basic and fundamental units of X-GSD. An Entity is a SceneGraphNode
      (an element of a Scene, with all the required scene graph behaviour and properties such as a Transform,
-     a reference to a parent node and a collection of children nodes) with added functionality and a unique
-     name which identifies it. Entities can hold Components, which add more specific functionality and
-     properties.
+     a reference to a parent node and a collection of children nodes) with added functionality. Entities can
+     hold Components, which add more specific functionality and properties.
+     
+     Every Entity registers itself in the EntityRegistry of the current scene when created, which gives it an
+     EntityHandle: store handles instead of pointers to refer to entities which may be destroyed, and resolve
+     them with getEntity. Names are optional, but must be unique within the scene.
+     
+     An Entity holds at most one Component of each type. Components are kept in the order they were added,
+     and a table indexed by their TypeId (see Component::getTypeId) makes getComponent a single lookup.
+     Update, draw, pause, event and collision callbacks are only called on the components interested in them
+     (see Component::getCallbacks), through one list per callback kept in the same order.
+     
+     An Entity can also have an id in the ArchetypeWorld of the scene (see getWorldEntity), so that its
+     components can keep data in the world, to be processed by systems.
      */
     class Entity : public SceneGraphNode
     {
@@ -33,7 +43,7 @@ namespace xgsd {
         
         // Methods
     public:
-        Entity(std::string name);
+        Entity(const std::string& name = "");
         ~Entity();
         
         void                    onAttachThis() override;
@@ -41,7 +51,7 @@ namespace xgsd {
         void                    onPauseThis(const HiResDuration &dt) override;
 
         void                    updateThis(const HiResDuration& dt) override;
-        void                    drawThis(sf::RenderTarget& target, sf::RenderStates states) const override;
+        void                    drawThis(RenderCommandList& target, sf::RenderStates states) const override;
         void                    handleEventThis(const Event& event) override;
         
         void                    addComponent(Component::Ptr component);
@@ -51,16 +61,34 @@ namespace xgsd {
         T*                      getComponent();
         
         void                    collisionHandler(Entity* theOtherEntity, sf::FloatRect collision);
+        void                    collisionEnter(Entity* theOtherEntity, sf::FloatRect collision);
+        void                    collisionStay(Entity* theOtherEntity, sf::FloatRect collision);
+        void                    collisionExit(Entity* theOtherEntity);
         
-        std::string             getName();
-        static Entity*          getEntityNamed(std::string name);
+        const std::string&      getName() const;
+        EntityHandle            getHandle() const;
+        static Entity*          getEntityNamed(const std::string& name);
+        static Entity*          getEntity(EntityHandle handle);
         
-        // Variables (member / properties)
+        ArchetypeWorld::EntityId getWorldEntity();
+    
     private:
-        std::map<std::type_index, Component::Ptr>       mComponents;
-        std::string                                     mName;
+        void                    updateCallbackLists();
         
-        static std::unordered_map<std::string, Entity*> entities; // TODO: Make it non-static. Maybe inside Scene class, so that each scene has a collection of pointers to entities
+        // Variables (member / properties)
+    private:
+        PooledVector<Component::Ptr>                    mComponents;        // In the order they were added
+        PooledVector<Component*>                        mComponentSlots;    // Component of every TypeId, nullptr if the entity has none
+        PooledVector<Component*>                        mUpdateComponents;  // Components interested in each callback, in the order of mComponents
+        PooledVector<Component*>                        mDrawComponents;
+        PooledVector<Component*>                        mEventComponents;
+        PooledVector<Component*>                        mPauseComponents;
+        PooledVector<Component*>                        mCollisionComponents;
+        EntityRegistry::NameId                          mName;
+        EntityRegistry*                                 mRegistry;          // Registry of the scene where the entity was created
+        EntityHandle                                    mHandle;
+        ArchetypeWorld*                                 mWorld;             // World of mWorldEntity, nullptr until it is created
+        ArchetypeWorld::EntityId                        mWorldEntity;
     };
     
     
@@ -72,19 +100,23 @@ namespace xgsd {
     template <typename T>
     std::unique_ptr<T> Entity::removeComponent()
     {
-        // Retrieve the type_index of T
-        std::type_index index(typeid(T));
+        // Retrieve the TypeId of T
+        Component::TypeId typeId = Component::getTypeId<T>();
         
         // Ensure that a component with type T exists in the collection
-        assert(mComponents.count(std::type_index(typeid(T))) != 0);
+        assert(typeId < mComponentSlots.size() && mComponentSlots[typeId]);
         
-        // Retrieve it from the collection and cast it back to the T polymorphic type
-        T *tmp = static_cast<T*>(mComponents[index].get());
+        // Find it in the collection and cast it back to the T polymorphic type
+        Component* component = mComponentSlots[typeId];
+        auto found = std::find_if(mComponents.begin(), mComponents.end(), [component] (const Component::Ptr& ptr) {
+            return ptr.get() == component;
+        });
         
         // Remove it from the collection and return it
-        std::unique_ptr<T> removedComponent(tmp);
-        mComponents[index].release();
-        mComponents.erase(index);
+        std::unique_ptr<T> removedComponent(static_cast<T*>(found->release()));
+        mComponents.erase(found);
+        mComponentSlots[typeId] = nullptr;
+        updateCallbackLists();
         removedComponent->detachedFromEntity();
         
         return removedComponent;
@@ -93,16 +125,10 @@ namespace xgsd {
     template <typename T>
     T* Entity::getComponent()
     {
-        // Retrieve the type_index of T
-        std::type_index index(typeid(T));
+        // Retrieve the TypeId of T
+        Component::TypeId typeId = Component::getTypeId<T>();
         
-        // If it exists in the collection, retrieve it, cast it back to the T polymorphic type and return it
-        if (mComponents.count(std::type_index(typeid(T))) != 0) {
-            return static_cast<T*>(mComponents[index].get());
-        }
-        // Otherwise, a nullptr is returned
-        else {
-            return nullptr;
-        }
+        // If it exists in the table, cast it back to the T polymorphic type and return it. Otherwise, a nullptr is returned
+        return typeId < mComponentSlots.size() ? static_cast<T*>(mComponentSlots[typeId]) : nullptr;
     }
 } // namespace xgsd
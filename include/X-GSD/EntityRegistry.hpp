@@ -0,0 +1,79 @@
+#pragma once
+
+#include <SFML/System/NonCopyable.hpp>
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+#include <cassert>
+
+namespace xgsd {
+    
+    // Forward declaration
+    class Entity;
+    
+    /*
+     EntityHandle struct. Identifies an Entity of a Scene (see EntityRegistry). It is just an index and a
+     generation packed in 64 bits, so it can be copied, stored and compared freely. When the entity is
+     destroyed its slot gets a new generation, so old handles stop resolving instead of dangling. A default
+     constructed handle is null.
+     */
+    struct EntityHandle
+    {
+        std::uint32_t   index = 0;
+        std::uint32_t   generation = 0; // Generations start at 1, so 0 means null
+        
+        bool            isNull() const { return generation == 0; }
+    };
+    
+    bool operator==(const EntityHandle& left, const EntityHandle& right);
+    bool operator!=(const EntityHandle& left, const EntityHandle& right);
+    
+    /*
+     EntityRegistry class. Slot map holding the entities of a Scene, which register themselves when created.
+     Creating, destroying and resolving a handle are O(1) and never hash anything.
+     
+     Names are optional. They are interned: every different name is stored once for the whole program and
+     identified by a NameId, so entities only hold an integer and named lookups hash the string once. Names
+     must be unique within a registry.
+     */
+    class EntityRegistry : private sf::NonCopyable
+    {
+        // Typedefs and enumerations
+    public:
+        typedef std::uint32_t   NameId;
+        
+        static const NameId     NoName = 0;
+    
+    private:
+        struct Slot
+        {
+            Entity*         entity;     // nullptr if the slot is free
+            std::uint32_t   generation;
+            std::uint32_t   nextFree;   // Next slot in the free list, if free
+            NameId          name;
+        };
+        
+        // Methods
+    public:
+        EntityRegistry();
+        
+        EntityHandle            add(Entity* entity, NameId name = NoName);
+        void                    remove(EntityHandle handle);
+        Entity*                 get(EntityHandle handle) const;
+        Entity*                 getNamed(const std::string& name) const;
+        std::size_t             getEntityCount() const;
+        
+        static NameId           internName(const std::string& name);
+        static const std::string& getInternedName(NameId name);
+        
+        // Variables (member / properties)
+    private:
+        std::vector<Slot>                           mSlots;
+        std::uint32_t                               mFirstFree;
+        std::unordered_map<NameId, EntityHandle>    mNamedEntities;
+        std::size_t                                 mEntityCount;
+    };
+    
+} // namespace xgsd
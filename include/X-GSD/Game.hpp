@@ -3,14 +3,21 @@
 #include <X-GSD/Scene.hpp>
 #include <X-GSD/ResourceManager.hpp>
 #include <X-GSD/PhysicsEngine.hpp>
+#include <X-GSD/PoolAllocator.hpp>
+#include <X-GSD/SpriteBatch.hpp>
+#include <X-GSD/RenderCommandList.hpp>
+#include <X-GSD/RenderThread.hpp>
 
 #include <SFML/System/Time.hpp>
 #include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/Graphics/View.hpp>
 #include <SFML/Graphics/Font.hpp>
 #include <SFML/Graphics/Text.hpp>
 #include <SFML/Window/Event.hpp>
 
 #include <unordered_map>
+#include <memory>
+#include <cassert>
 
 namespace xgsd {
   
@@ -18,6 +25,16 @@ namespace xgsd {
    Game class. The main class of X-GSD, resposible to load the game's initial configuration, keep the game
    running in a specific timestep loop, handle resources and subsystems such as physics engine or events,
    and serve as a global point of access to these resources and subsystems.
+   
+   The configuration is loaded when the game starts running, after parseCommandLine, which accepts:
+   --headless      Run without a window (also "headless" in gameconfig.json). No GPU resources are created,
+                   no events are handled and nothing is rendered: the scene is updated with the fixed step of
+                   the run method as fast as possible, until quit is called or the step limit is reached.
+   --steps N       Stop after N simulation steps in headless mode, 0 for no limit (also "headlessSteps").
+   
+   Every frame is recorded on a RenderCommandList and then drawn on the window. With "renderThread" in
+   gameconfig.json, the frames are drawn by a RenderThread while the next ones are simulated, in any of the
+   run methods. Call synchronizeRendering before releasing resources that the last frames may use.
    */
   class Game
   {
@@ -31,6 +48,8 @@ namespace xgsd {
     
     static Game&            instance() { return globalInstance; }
     
+    void                    parseCommandLine(int argc, char* argv[]);
+    
     void                    runFixedDeltaTime(int simulationFrequency = 60);
     void                    runVariableDeltaTime();
     void                    runSemiFixedDeltaTime(int simulationFrequency = 60, int stepLimit = 3);
@@ -45,10 +64,14 @@ namespace xgsd {
     FontManager&            getLocalFontManager()           { return mScene->getLocalFontManager(); }
     TextureManager&         getLocalTextureManager()        { return mScene->getLocalTextureManager(); }
     SoundManager&           getLocalSoundManager()          { return mScene->getLocalSoundManager(); }
-    sf::RenderWindow&       getWindow()                     { return *mWindow; }
+    sf::RenderWindow&       getWindow()                     { assert(mWindow); return *mWindow; }
+    sf::Vector2f            getViewSize();
     HiResDuration           getRunningTime()                { return mTimeSinceStart; }
+    bool                    isHeadless()                    { return mHeadless; }
     
     void                    broadcastEvent(const Event& event);
+    void                    synchronizeRendering();
+    void                    quit();
     
 #ifdef DEBUG
     bool                    isDebugRenderingEnabled() { return mDebugRendering; }
@@ -58,9 +81,12 @@ namespace xgsd {
   private:
     // Private constructor to ensure the static globalInstance is the only one
     Game();
+    void                    initialize();
     void                    loadConfigurationFromFile();
+    bool                    isRunning();
+    void                    runHeadless(const HiResDuration& simulationFixedDuration);
     void                    update(const HiResDuration& dt);
-    void                    render();
+    void                    render(float interpolation = 1.f);
     void                    handleEvents();
     
     // Variables (member / properties)
@@ -68,8 +94,21 @@ namespace xgsd {
     static Game             globalInstance;
     
     HiResDuration           mTimeSinceStart;
-    sf::RenderWindow*       mWindow;
+    bool                    mInitialized;
+    sf::RenderWindow*       mWindow;            // nullptr in headless mode
+    sf::View                mView;              // Initial view of the window, kept in headless mode too
     bool                    mVSync;
+    bool                    mRenderInterpolation; // Only used by runFixedSimulationVariableFramerate
+    SpriteBatch             mSpriteBatch;
+    RenderCommandList       mCommandList;       // Frame being recorded, when there is no render thread
+    std::unique_ptr<RenderThread> mRenderThread; // nullptr unless enabled, destroyed before closing the window
+    
+    // Headless mode
+    bool                    mHeadless;
+    bool                    mHeadlessFromCommandLine;
+    std::size_t             mHeadlessSteps;     // 0 for no limit
+    bool                    mHeadlessStepsFromCommandLine;
+    bool                    mRunning;
     Scene*                  mScene;
     sf::Event               mEvent;
     PhysicsEngine           mPhysicsEngine;
@@ -83,11 +122,12 @@ namespace xgsd {
     // Statistics
     bool                    mDebugRendering;
     bool                    mEnableStatistics;
-    sf::RectangleShape      mStatisticsBackground;
+    sf::Color               mStatisticsBackgroundColor;
     sf::Text                mStatisticsText;
     HiResDuration           mStatisticsUpdateTime;
     std::size_t             mStatisticsNumFrames;
     std::size_t             mStatisticsNumSimulationSteps;
+    PoolAllocator::Statistics mStatisticsAllocations; // Totals at the last update of the statistics
 #endif
     
   public:
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+namespace xgsd {
+    
+    /*
+     JsonReader class. Event-driven (SAX) JSON parser: instead of building a document, like Json::Reader does,
+     it calls a Handler for each value as it goes through the text, so that a large file can be turned into
+     something else (e.g. the records of a SceneFile) without keeping all of it in memory as Json::Value maps.
+     
+     It accepts what Json::Reader accepts by default, comments included. Exceptions thrown by the handler stop
+     the parsing and are passed through.
+     */
+    class JsonReader
+    {
+        // Typedefs and enumerations
+    public:
+        // Receives the values in the order of the text. Keys come right before their value
+        class Handler
+        {
+        public:
+            virtual         ~Handler() {}
+            
+            virtual void    beginObject() = 0;
+            virtual void    endObject() = 0;
+            virtual void    beginArray() = 0;
+            virtual void    endArray() = 0;
+            virtual void    key(const std::string& name) = 0;
+            virtual void    stringValue(const std::string& value) = 0;
+            virtual void    numberValue(double value) = 0;
+            virtual void    boolValue(bool value) = 0;
+            virtual void    nullValue() = 0;
+        };
+        
+        static const std::size_t MaxDepth = 1000; // Of nested objects and arrays
+        
+        // Methods
+    public:
+        JsonReader();
+        
+        bool                parse(const char* begin, const char* end, Handler& handler);
+        std::string         getFormattedErrorMessages() const;
+    
+    private:
+        void                parseValue(std::size_t depth);
+        void                parseObject(std::size_t depth);
+        void                parseArray(std::size_t depth);
+        void                parseString(std::string& string);
+        void                parseNumber();
+        void                parseLiteral(const char* literal);
+        void                appendCodePoint(std::string& string, unsigned long codePoint);
+        unsigned long       parseHex4();
+        
+        void                skipWhitespace();
+        bool                consume(char character);
+        void                expect(char character, const char* message);
+        void                fail(const char* message, const char* at);
+        
+        // Variables (member / properties)
+    private:
+        const char*         mBegin;
+        const char*         mEnd;
+        const char*         mCurrent;
+        Handler*            mHandler;
+        std::string         mKey;       // Reused for every key, to avoid allocations
+        std::string         mString;    // Reused for every string value
+        std::string         mError;
+    };
+    
+} // namespace xgsd
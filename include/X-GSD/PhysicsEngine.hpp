@@ -3,11 +3,18 @@
 #include <X-GSD/Time.hpp>
 #include <X-GSD/PhysicState.hpp>
 #include <X-GSD/ComponentCollider.hpp>
+#include <X-GSD/AABBTree.hpp>
+#include <X-GSD/AABBArray.hpp>
+#include <X-GSD/RigidBodyStore.hpp>
+#include <X-GSD/ThreadPool.hpp>
+#include <X-GSD/PoolAllocator.hpp>
 
 #include <SFML/System/Vector2.hpp>
 #include <SFML/Graphics/Transformable.hpp>
 
-#include <set>
+#include <vector>
+#include <utility>
+#include <cstdint>
 
 namespace xgsd {
     
@@ -18,22 +25,125 @@ namespace xgsd {
         sf::Vector2f dv; // dv/dt = acceleration
     };
     
+    /*
+     PhysicsEngine class. Integrates the physics state of ComponentRigidBodies (all at once, see RigidBodyStore)
+     and detects collisions between ComponentColliders. Collision detection runs in two phases:
+     
+     - Broadphase: the world bounds of every collider are computed once per step, and a list of colliding
+     pairs is generated. The broadphase can be selected with setBroadphaseMode: BruteForce tests every pair
+     (useful as a reference for comparison), while UniformGrid buckets the world bounds of dynamic colliders
+     in a grid of square cells and only tests colliders which share a cell, and SweepAndPrune keeps the
+     bounds of dynamic colliders sorted along one axis between steps, so only colliders whose intervals
+     overlap on that axis are tested. Static colliders are kept in a persistent AABBTree, which is queried
+     with the bounds of every dynamic collider. Every broadphase discards the pairs filtered by the collision
+     layers of the colliders (see ComponentCollider). The bounds are tested in batches of 4 or 8 with a SIMD
+     overlap kernel (see AABBArray).
+     
+     The pair generation only reads the colliders, so it is split between the threads of a ThreadPool (see
+     setThreadCount), each one writing the pairs it finds to its own buffer. The world bounds are still
+     computed on the calling thread, as the world transforms of the nodes are cached lazily.
+     
+     - Dispatch: on the calling thread, the pairs of all the threads are sorted in the same order the brute
+     force loop would find them, and the collisionHandlers of both entities are called. Any broadphase and any
+     number of threads produce the same callbacks, in the same order. The pairs
+     which were overlapping in the previous step are kept in a contact cache, so that Components also get
+     onCollisionEnter when a contact begins, onCollisionStay while it lasts and onCollisionExit when it ends
+     (the colliders stop overlapping, one of the entities is pending of destruction or a collider is removed).
+     */
     class PhysicsEngine
     {
         // Typedefs and enumerations
     public:
         typedef std::unique_ptr<PhysicsEngine>    Ptr;
         
+        enum BroadphaseMode {
+            BruteForce,
+            UniformGrid,
+            SweepAndPrune
+        };
+        
+        enum Axis {
+            AxisX,
+            AxisY
+        };
+        
+    private:
+        static const int NoSweepProxy = -1; // Of the dynamic colliders, while the broadphase is not SweepAndPrune
+        
+        // A pair of overlapping colliders. First is always dynamic, second may be dynamic or static
+        struct CollisionPair
+        {
+            ComponentCollider*  first;
+            ComponentCollider*  second;
+            bool                secondIsStatic;
+            sf::FloatRect       intersection;
+        };
+        
+        // A dynamic collider inserted in one cell of the uniform grid
+        struct GridEntry
+        {
+            std::uint64_t       cell;
+            ComponentCollider*  collider;
+        };
+        
+        // A bound of the interval of a dynamic collider along the sweep axis
+        struct SweepEndpoint
+        {
+            float               value;
+            int                 proxy;
+            bool                isMin;
+        };
+        
+        // Output of each thread during the pair generation, so that threads never write to shared memory
+        struct WorkerBuffers
+        {
+            std::vector<CollisionPair>  pairs;
+            std::vector<std::uint32_t>  overlaps; // Indices of the boxes overlapping the one tested
+        };
+        
         // Methods
     public:
+        PhysicsEngine();
+        
+        void    integrate(const HiResDuration& dt);
         void    checkCollisions();
         
         void    addStaticCollider(ComponentCollider* collider);
         void    addDynamicCollider(ComponentCollider* collider);
         void    deleteStaticCollider(ComponentCollider* collider);
         void    deleteDynamicCollider(ComponentCollider* collider);
+        void    endContacts(ComponentCollider* collider);
+        
+        void            setBroadphaseMode(BroadphaseMode mode);
+        BroadphaseMode  getBroadphaseMode();
+        void            setGridCellSize(float cellSize);
+        float           getGridCellSize();
+        void            setSweepAxis(Axis axis);
+        Axis            getSweepAxis();
+        void            setThreadCount(std::size_t threadCount);
+        std::size_t     getThreadCount();
+        
+        void            rebuildStaticColliderTree();
         
+        RigidBodyStore& getRigidBodyStore();
+    
     private:
+        void    updateWorldBounds();
+        void    findPairsBruteForce();
+        void    findPairsUniformGrid();
+        void    insertInGrid(ComponentCollider* collider);
+        void    findPairsSweepAndPrune();
+        void    updateSweepEndpoints();
+        int     addSweepProxy(ComponentCollider* collider);
+        void    clearSweepProxies();
+        void    findStaticPairs();
+        void    gatherPairs();
+        void    dispatchPairs();
+        void    removeContacts(ComponentCollider* collider);
+        
+        void static             addPair(std::vector<CollisionPair>& pairs, ComponentCollider* dynamicCollider, ComponentCollider* otherCollider, bool otherIsStatic, const sf::FloatRect& intersection);
+        bool static             comparePairs(const CollisionPair& a, const CollisionPair& b);
+        
         Derivative static       evaluateRK4(const PhysicState& initialPhysics,
                                             const sf::Transformable& initialTransf,
                                             const HiResDuration& dt,
@@ -58,8 +168,49 @@ namespace xgsd {
         
         // Variables (member / properties)
     private:
-        std::set<ComponentCollider*>    staticColliders; // Colliders whose Entity does not have a RigidBody
-        std::set<ComponentCollider*>    dynamicColliders; // Colliders whose Entity has a RigidBody
+        PooledMap<ComponentCollider*, int> staticColliders; // Colliders whose Entity does not have a RigidBody, and their proxy in mStaticTree
+        PooledMap<ComponentCollider*, int> dynamicColliders; // Colliders whose Entity has a RigidBody, and their proxy in the sweep and prune lists (if used)
+        
+        BroadphaseMode                  mBroadphaseMode;
+        std::vector<CollisionPair>      mPairs; // Pairs found by all the threads in the current step (reused to avoid allocations)
+        std::vector<CollisionPair>      mContacts; // Pairs which were overlapping in the previous step, sorted as mPairs
+        std::vector<CollisionPair>      mNewContacts;
+        bool                            mDispatching; // While the collision callbacks are called, mContacts can not be modified
+        std::vector<std::pair<ComponentCollider*, bool>> mPendingContactRemovals; // Colliders whose contacts end after the dispatch, and if they are notified
+        
+        // Pair generation threads
+        ThreadPool                      mThreadPool;
+        std::vector<WorkerBuffers>      mWorkerBuffers; // One per thread
+        
+        // Dynamic colliders which can be part of a pair in the current step, in the same order as dynamicColliders
+        std::vector<ComponentCollider*> mActiveDynamicColliders;
+        
+        // Packed world bounds tested with the overlap kernel (reused to avoid allocations)
+        AABBArray                       mDynamicBoxes;
+        AABBArray                       mStaticBoxes;
+        std::vector<ComponentCollider*> mStaticBoxColliders;
+        
+        // Uniform grid broadphase
+        float                           mGridCellSize;
+        std::vector<GridEntry>          mGridEntries;
+        std::vector<std::size_t>        mGridCells; // Index of the first entry of every non-empty cell, plus the end
+        std::vector<ComponentCollider*> mOversizedColliders; // Colliders covering too many cells, tested against all the others
+        
+        // Sweep and prune broadphase, empty while it is not used. The endpoints are kept between steps, so they are almost sorted
+        Axis                            mSweepAxis;
+        std::vector<SweepEndpoint>      mSweepEndpoints;
+        std::vector<ComponentCollider*> mSweepProxies;       // Collider of each proxy, nullptr once deleted
+        std::vector<int>                mSweepFreeProxies;   // Proxies which can be reused
+        std::vector<int>                mSweepRemovedProxies; // Proxies whose endpoints must be removed in the next step
+        std::vector<int>                mSweepActive;        // Proxies whose interval contains the current sweep position
+        AABBArray                       mSweepActiveBoxes;   // World bounds of mSweepActive
+        
+        // Physics state of every ComponentRigidBody
+        RigidBodyStore                  mRigidBodies;
+        
+        // Static colliders hierarchy, used by the UniformGrid and SweepAndPrune broadphases
+        AABBTree                        mStaticTree;
+        std::uint16_t                   mStaticCategoryBits; // Union of the categories of all static colliders
     };
     
 } // namespace xgsd
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <functional>
+#include <utility>
+#include <cstddef>
+
+namespace xgsd {
+    
+    /*
+     PoolAllocator class. Slab allocator for the small objects which are created and destroyed all the time
+     while playing (entities, components and the containers inside them), so that spawning and destroying
+     them recycles memory instead of going to the general-purpose heap every time.
+     
+     Memory is served from pools of fixed-size blocks, one per size class (multiples of Granularity, up to
+     MaxPooledSize bytes). A pool takes a slab of BlocksPerSlab blocks from the heap when it runs out of
+     blocks, and keeps the freed blocks in a free list to recycle them. Slabs are never given back, so once
+     the pools have grown to the peak number of live objects, allocating does no heap allocations at all.
+     Bigger requests go straight to the heap.
+     
+     SceneGraphNode (and so Entity) and Component allocate all their instances here through their class
+     operator new, and PooledAllocator lets standard containers use it too (see PooledVector and PooledMap).
+     Containers with the default allocator still go to the heap, and are not counted in the statistics. It is
+     thread-safe.
+     */
+    class PoolAllocator
+    {
+        // Typedefs and enumerations
+    public:
+        // Totals since the program started
+        struct Statistics
+        {
+            std::size_t     allocations;        // All the allocations, pooled or not
+            std::size_t     deallocations;
+            std::size_t     slabAllocations;    // Heap allocations of the pools themselves: new slabs and objects too big to be pooled
+            std::size_t     reservedBytes;      // Memory held by the slabs
+        };
+        
+        static const std::size_t Granularity;
+        static const std::size_t MaxPooledSize;
+        static const std::size_t BlocksPerSlab;
+        
+        // Methods
+    public:
+        static void*            allocate(std::size_t size);
+        static void             deallocate(void* pointer, std::size_t size);
+        static Statistics       getStatistics();
+    };
+    
+    /*
+     PooledAllocator class. Standard allocator which takes its memory from the PoolAllocator, to be used with
+     standard containers (see PooledVector and PooledMap).
+     */
+    template <typename T>
+    class PooledAllocator
+    {
+        // Typedefs and enumerations
+    public:
+        typedef T value_type;
+        
+        // Methods
+    public:
+        PooledAllocator() = default;
+        template <typename U>
+        PooledAllocator(const PooledAllocator<U>& other);
+        
+        T*                      allocate(std::size_t count);
+        void                    deallocate(T* pointer, std::size_t count);
+    };
+    
+    template <typename T, typename U>
+    bool operator==(const PooledAllocator<T>& left, const PooledAllocator<U>& right);
+    template <typename T, typename U>
+    bool operator!=(const PooledAllocator<T>& left, const PooledAllocator<U>& right);
+    
+    template <typename T>
+    using PooledVector = std::vector<T, PooledAllocator<T>>;
+    
+    // Each node is a small allocation, so maps which change while playing benefit the most
+    template <typename Key, typename T>
+    using PooledMap = std::map<Key, T, std::less<Key>, PooledAllocator<std::pair<const Key, T>>>;
+    
+    
+    
+    /////////////////////////////
+    // Template implementation //
+    /////////////////////////////
+    
+    template <typename T>
+    template <typename U>
+    PooledAllocator<T>::PooledAllocator(const PooledAllocator<U>&)
+    {
+        
+    }
+    
+    template <typename T>
+    T* PooledAllocator<T>::allocate(std::size_t count)
+    {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "PooledAllocator does not support over-aligned types");
+        return static_cast<T*>(PoolAllocator::allocate(count * sizeof(T)));
+    }
+    
+    template <typename T>
+    void PooledAllocator<T>::deallocate(T* pointer, std::size_t count)
+    {
+        PoolAllocator::deallocate(pointer, count * sizeof(T));
+    }
+    
+    // All the PooledAllocators share the same pools, so memory allocated by one can be freed by any other
+    template <typename T, typename U>
+    bool operator==(const PooledAllocator<T>&, const PooledAllocator<U>&)
+    {
+        return true;
+    }
+    
+    template <typename T, typename U>
+    bool operator!=(const PooledAllocator<T>&, const PooledAllocator<U>&)
+    {
+        return false;
+    }
+    
+} // namespace xgsd
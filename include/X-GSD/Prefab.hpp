@@ -0,0 +1,61 @@
+#pragma once
+
+#include <X-GSD/Entity.hpp>
+#include <X-GSD/SceneFile.hpp>
+#include <X-GSD/ResourceManager.hpp>
+#include <X-GSD/ControllersManager.hpp>
+#include <X-GSD/ComponentSprite.hpp>
+
+#include <SFML/Graphics/Transformable.hpp>
+#include <SFML/Graphics/Rect.hpp>
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace xgsd {
+    
+    /*
+     Prefab class. Template of an entity, made once from its record in a compiled scene (see SceneFile) and
+     instantiated any number of times. Everything that can be resolved in advance already is: the textures
+     (with their atlas regions and sizes), the controller factories and the relative positions, so that
+     instantiating only creates the entity and its components, without looking up anything.
+     
+     Scenes make one for each entry of the "prefabs" array of their file, which are defined as their entities
+     (see Scene::getPrefab and Scene::instantiate). Prefabs keep pointers to the textures of the managers they
+     were made with, so they must not outlive them.
+     */
+    class Prefab
+    {
+        // Typedefs and enumerations
+    private:
+        // Components as they are created, with their record flags (see SceneFile::RecordFlags)
+        struct ComponentTemplate
+        {
+            SceneFile::ComponentType        type;
+            std::uint32_t                   flags;
+            ComponentSprite::ResolvedTexture sprite;            // Sprites
+            sf::FloatRect                   boundsRect;         // Colliders
+            std::uint16_t                   categoryBits;
+            std::uint16_t                   maskBits;
+            ControllersManager::Factory     controllerFactory;  // Controllers
+        };
+        
+        // Methods
+    public:
+        Prefab(const SceneFile& file, const SceneFile::EntityRecord& record, TextureManager& textureManager, ControllersManager& controllersManager, const sf::Vector2f& viewSize);
+        
+        Entity::Ptr                     instantiate(const std::string& name = "") const;
+        Entity::Ptr                     instantiate(const sf::Transformable& transformable, const std::string& name = "") const;
+        
+        const std::string&              getName() const;
+        const sf::Transformable&        getTransformable() const;
+        
+        // Variables (member / properties)
+    private:
+        std::string                     mName;
+        sf::Transformable               mTransformable;
+        std::vector<ComponentTemplate>  mComponents;        // In the order they are added
+    };
+    
+} // namespace xgsd
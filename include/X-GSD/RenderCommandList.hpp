@@ -0,0 +1,147 @@
+#pragma once
+
+#include <X-GSD/SpriteBatch.hpp>
+
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/RenderStates.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/Text.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <typeindex>
+#include <type_traits>
+#include <cstddef>
+
+namespace xgsd {
+    
+    /*
+     RenderCommandList class. Records the draws of a frame as commands, to be replayed on a render target
+     later (maybe by another thread, see RenderThread). The scene graph and its components draw on a command
+     list instead of on the window, with the same calls they would use on a sf::RenderTarget.
+     
+     Sprites are recorded as plain data (texture, texture rect, world transform, color and blend mode), and
+     replayed through a SpriteBatch. Any other drawable (texts, shapes...) is copied as it is when drawn, so
+     later changes to the original do not affect the recorded frame. The copies are kept in pools, one per
+     drawable type, which are reset but not freed when the list is cleared: each frame assigns over the copies
+     of the previous one, so recording allocates nothing once the pools have grown. Once recorded, a list is
+     never modified until it is cleared, so it can be replayed by a thread while the simulation goes on.
+     
+     Fonts are not thread-safe: measuring a text loads its glyphs and changes the size of the font face, so
+     the simulation must never ask for the bounds of a text which may be drawn at the same time. Texts laid
+     out by their bounds (centered, or with a background) are recorded with drawText instead, and their
+     bounds are only computed by the replay.
+     
+     Commands keep pointers to the textures and fonts they use, which must not be released before the list is
+     replayed (see Game::synchronizeRendering).
+     */
+    class RenderCommandList : private sf::NonCopyable
+    {
+        // Typedefs and enumerations
+    private:
+        struct Command
+        {
+            sf::RenderStates                states;         // For sprites, the transform includes the one of the sprite
+            sf::IntRect                     textureRect;    // Sprites only
+            sf::Color                       color;          // Sprites, or the background of aligned texts
+            sf::Drawable*                   drawable;       // Pooled copy of anything else, nullptr for sprites
+            sf::Text*                       alignedText;    // The same copy, for texts aligned by the replay
+            sf::Vector2f                    anchor;         // Aligned texts only
+        };
+        
+        // Copies of the drawables of one type, reused from frame to frame
+        class DrawablePool
+        {
+        public:
+            DrawablePool() : mUsed(0) {}
+            virtual ~DrawablePool() {}
+            
+            void                            reset() { mUsed = 0; }
+        
+        protected:
+            std::size_t                     mUsed;
+        };
+        
+        template <typename T>
+        class TypedDrawablePool : public DrawablePool
+        {
+        public:
+            T*                              copy(const T& drawable);
+        
+        private:
+            std::deque<T>                   mCopies;        // Which do not move as it grows
+        };
+        
+        // Methods
+    public:
+        RenderCommandList();
+        
+        void                    draw(const sf::Sprite& sprite, const sf::RenderStates& states = sf::RenderStates::Default);
+        template <typename T>
+        void                    draw(const T& drawable, const sf::RenderStates& states = sf::RenderStates::Default);
+        void                    drawText(const sf::Text& text, const sf::Vector2f& anchor, const sf::Color& backgroundColor = sf::Color::Transparent, const sf::RenderStates& states = sf::RenderStates::Default);
+        
+        void                    replay(sf::RenderTarget& target, SpriteBatch& spriteBatch) const;
+        void                    clear();
+        bool                    isEmpty() const;
+        
+    private:
+        template <typename T>
+        TypedDrawablePool<T>&   getPool();
+        static std::size_t      getPoolIndex(const std::type_index& type);
+        
+        // Variables (member / properties)
+    private:
+        std::vector<Command>    mCommands;  // In drawing order. Cleared but kept between frames, so that their memory is reused
+        std::vector<std::unique_ptr<DrawablePool>>  mPools;     // Indexed by getPoolIndex, created on first use
+    };
+    
+    
+    
+    /////////////////////////////
+    // Template implementation //
+    /////////////////////////////
+    
+    // Records a copy of the drawable, which must be copyable
+    template <typename T>
+    void RenderCommandList::draw(const T& drawable, const sf::RenderStates& states)
+    {
+        static_assert(std::is_base_of<sf::Drawable, T>::value, "T must derive from sf::Drawable");
+        
+        mCommands.push_back(Command{ states, sf::IntRect(), sf::Color(), getPool<T>().copy(drawable), nullptr, sf::Vector2f() });
+    }
+    
+    template <typename T>
+    RenderCommandList::TypedDrawablePool<T>& RenderCommandList::getPool()
+    {
+        // Looked up only once per type, then every call is just a read
+        static const std::size_t index = getPoolIndex(std::type_index(typeid(T)));
+        
+        if (index >= mPools.size())
+            mPools.resize(index + 1);
+        if (!mPools[index])
+            mPools[index].reset(new TypedDrawablePool<T>());
+        
+        return static_cast<TypedDrawablePool<T>&>(*mPools[index]);
+    }
+    
+    // Assigns over a copy left by a previous frame, if any
+    template <typename T>
+    T* RenderCommandList::TypedDrawablePool<T>::copy(const T& drawable)
+    {
+        static_assert(std::is_copy_assignable<T>::value, "T must be copyable");
+        
+        if (mUsed < mCopies.size())
+            mCopies[mUsed] = drawable;
+        else
+            mCopies.push_back(drawable);
+        
+        return &mCopies[mUsed++];
+    }
+    
+} // namespace xgsd
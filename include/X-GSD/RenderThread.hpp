@@ -0,0 +1,70 @@
+#pragma once
+
+#include <X-GSD/RenderCommandList.hpp>
+#include <X-GSD/SpriteBatch.hpp>
+
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/Graphics/RenderWindow.hpp>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+namespace xgsd {
+    
+    /*
+     RenderThread class. Draws the frames recorded by the simulation on a thread of its own, which owns the
+     OpenGL context of the window while it runs. The simulation records each frame on getCommandList and
+     submits it; the render thread then replays the latest submitted list and displays it, while the
+     simulation goes on with the next frame. This way a slow frame (or waiting for VSync) does not stall the
+     simulation, and the frames are simulated and drawn at the same time on multi-core machines.
+     
+     There are three command lists, so that neither thread ever touches the list used by the other: one being
+     recorded, one submitted and waiting, and one being drawn. Submitting waits until the previous submitted
+     list has been taken, so the simulation is at most one frame ahead of the display.
+     
+     Events are still polled by the thread which created the window. Calls which need the OpenGL context
+     (such as setVerticalSyncEnabled) must go through this class while it runs. Fonts are shared with the
+     copies of the texts being drawn, so the simulation must not measure texts while it runs: texts laid out
+     by their bounds are recorded with RenderCommandList::drawText.
+     */
+    class RenderThread : private sf::NonCopyable
+    {
+        // Methods
+    public:
+        RenderThread(sf::RenderWindow& window, SpriteBatch& spriteBatch);
+        ~RenderThread();
+        
+        RenderCommandList&      getCommandList();
+        void                    submit();
+        void                    synchronize();
+        
+        void                    setVerticalSyncEnabled(bool option);
+    
+    private:
+        void                    renderLoop();
+        
+        // Variables (member / properties)
+    private:
+        sf::RenderWindow&       mWindow;
+        SpriteBatch&            mSpriteBatch;   // Only used by the render thread while it runs
+        
+        // Indices of the lists, always different. Only the simulation uses mRecording, the rest is protected by mMutex
+        RenderCommandList       mCommandLists[3];
+        std::size_t             mRecording;
+        std::size_t             mSubmitted;
+        std::size_t             mDrawing;
+        bool                    mSubmittedPending;  // If mSubmitted has not been taken by the render thread yet
+        bool                    mDrawingBusy;
+        bool                    mVSync;
+        bool                    mVSyncChanged;
+        bool                    mStopping;
+        
+        std::mutex              mMutex;
+        std::condition_variable mFrameSubmitted;
+        std::condition_variable mFrameTaken;    // Also notified when a frame has been drawn
+        std::thread             mThread;        // Declared last, as it is started once the rest is initialized
+    };
+    
+} // namespace xgsd
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <utility>
+#include <tuple>
+#include <initializer_list>
+#include <cstdint>
+
+namespace xgsd {
+    
+    /* Identifies the content of a file: its hash and its size, which must both match so that two files are
+     taken as the same one (see ResourceCache::hashContent). */
+    struct ContentHash
+    {
+        std::uint64_t   value;
+        std::uint64_t   size;
+        
+        bool operator<(const ContentHash& other) const
+        {
+            return value != other.value ? value < other.value : size < other.size;
+        }
+    };
+    
+    /* Class template to share the resources loaded by every ResourceManager of the process. It does not own
+     them: resource managers hold reference-counted handles, and the cache only remembers them by the path of
+     their file and the hash of its content, while any manager still holds them. So if two scenes use the same
+     file, the second one gets the resource of the first one instead of decoding it again, as long as it is
+     loaded before the first one is unloaded (see Scene::performSceneChange).
+     
+     Placeholder resources (see ResourceManager::setPlaceholderMode) are cached apart from real ones, by path
+     only. Textures packed in an atlas (see ResourceManager::loadAtlas) are empty textures which only identify
+     their region, so they are cached apart from standalone ones too, and only found by those who ask for
+     packed textures. The cache can be used from any thread.
+     */
+    template <typename Resource>
+    class ResourceCache
+    {
+    public:
+        
+        typedef std::shared_ptr<Resource> Handle;
+        
+        static Handle           find(const std::string& path, bool placeholder, bool acceptPacked = false, bool* packed = nullptr);
+        static Handle           findContent(const ContentHash& hash, bool acceptPacked = false, bool* packed = nullptr);
+        static void             add(const std::string& path, bool placeholder, bool packed, const ContentHash& hash, const Handle& resource);
+        static std::size_t      getResourceCount();
+        
+        static bool             readFile(const std::string& fullPath, std::vector<char>& content);
+        static ContentHash      hashContent(const std::vector<char>& content);
+    
+    private:
+        struct Cache
+        {
+            std::mutex                                                      mutex;
+            std::map<std::tuple<std::string, bool, bool>, std::weak_ptr<Resource>>  paths; // Path, placeholder and packed flags
+            std::map<std::pair<ContentHash, bool>, std::weak_ptr<Resource>>         contents; // Hash, size and packed flag
+        };
+        
+        static Cache&           getCache();
+        static void             removeExpired(Cache& cache);
+    };
+    
+    
+    
+    /////////////////////////////
+    // Template implementation //
+    /////////////////////////////
+    
+    /* The resource loaded from the file (path relative to the resource path), or nullptr if it is not loaded.
+     Packed textures are only returned if accepted, before standalone ones; packed (if any) tells which one it is. */
+    template <typename Resource>
+    typename ResourceCache<Resource>::Handle ResourceCache<Resource>::find(const std::string& path, bool placeholder, bool acceptPacked, bool* packed)
+    {
+        Cache& cache = getCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        
+        for (bool packedKey : { true, false }) {
+            if (packedKey && !acceptPacked)
+                continue;
+            
+            auto found = cache.paths.find(std::make_tuple(path, placeholder, packedKey));
+            
+            if (Handle resource = found != cache.paths.end() ? found->second.lock() : nullptr) {
+                if (packed)
+                    *packed = packedKey;
+                return resource;
+            }
+        }
+        
+        return nullptr;
+    }
+    
+    /* A resource loaded from a file with the same content (maybe a copy with another path), or nullptr. Packed
+     textures are looked up as in find. */
+    template <typename Resource>
+    typename ResourceCache<Resource>::Handle ResourceCache<Resource>::findContent(const ContentHash& hash, bool acceptPacked, bool* packed)
+    {
+        Cache& cache = getCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        
+        for (bool packedKey : { true, false }) {
+            if (packedKey && !acceptPacked)
+                continue;
+            
+            auto found = cache.contents.find(std::make_pair(hash, packedKey));
+            
+            if (Handle resource = found != cache.contents.end() ? found->second.lock() : nullptr) {
+                if (packed)
+                    *packed = packedKey;
+                return resource;
+            }
+        }
+        
+        return nullptr;
+    }
+    
+    /* Remembers a resource until all its handles are released. Placeholders are not looked up by content, so
+     their hash is ignored. */
+    template <typename Resource>
+    void ResourceCache<Resource>::add(const std::string& path, bool placeholder, bool packed, const ContentHash& hash, const Handle& resource)
+    {
+        Cache& cache = getCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        
+        // Forget the resources released since the last time, so that the maps do not grow with every scene
+        removeExpired(cache);
+        
+        cache.paths[std::make_tuple(path, placeholder, packed)] = resource;
+        
+        if (!placeholder)
+            cache.contents[std::make_pair(hash, packed)] = resource;
+    }
+    
+    /* Number of cached resources still held by some manager. */
+    template <typename Resource>
+    std::size_t ResourceCache<Resource>::getResourceCount()
+    {
+        Cache& cache = getCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        
+        removeExpired(cache);
+        return cache.paths.size();
+    }
+    
+    template <typename Resource>
+    bool ResourceCache<Resource>::readFile(const std::string& fullPath, std::vector<char>& content)
+    {
+        std::ifstream file(fullPath, std::ifstream::binary);
+        
+        if (!file)
+            return false;
+        
+        content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return !file.bad();
+    }
+    
+    // FNV-1a, good enough to tell files apart along with their size
+    template <typename Resource>
+    ContentHash ResourceCache<Resource>::hashContent(const std::vector<char>& content)
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+        
+        for (char byte : content) {
+            hash ^= (unsigned char)byte;
+            hash *= 1099511628211ull;
+        }
+        
+        return ContentHash{ hash, content.size() };
+    }
+    
+    template <typename Resource>
+    typename ResourceCache<Resource>::Cache& ResourceCache<Resource>::getCache()
+    {
+        static Cache cache;
+        return cache;
+    }
+    
+    template <typename Resource>
+    void ResourceCache<Resource>::removeExpired(Cache& cache)
+    {
+        for (auto iter = cache.paths.begin(); iter != cache.paths.end();)
+            iter = iter->second.expired() ? cache.paths.erase(iter) : ++iter;
+        
+        for (auto iter = cache.contents.begin(); iter != cache.contents.end();)
+            iter = iter->second.expired() ? cache.contents.erase(iter) : ++iter;
+    }
+    
+} // namespace xgsd
@@ -13,13 +13,22 @@
  */
 #include "ResourcePath.hpp"
 
+#include <X-GSD/ResourceCache.hpp>
+#include <X-GSD/SkylinePacker.hpp>
+#include <X-GSD/Debug.hpp>
+
 #include <SFML/Graphics/Font.hpp>
 #include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Image.hpp>
 #include <SFML/Audio/SoundBuffer.hpp>
 
 #include <map>
+#include <vector>
+#include <algorithm>
 #include <string>
+#include <fstream>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <cassert>
 
@@ -35,6 +44,26 @@ namespace xgsd {
      from memory their required resources on creation / destruction
      of the scene (RAII), while the general (Game's instances) resources will last
      until the game ends or manual unload is invoked.
+     
+     In placeholder mode (see setPlaceholderMode), load only checks that the file exists
+     and stores an empty resource. It is used by headless games, which have no graphics
+     context to create textures. The size of placeholder textures is still read from their
+     files (see getPlaceholderSize), so that sprites keep their size.
+     
+     Texture managers can also pack many small textures into a few atlas pages (see loadAtlas), so that
+     sprites using any of them can be drawn together. Each packed texture gets an empty texture as its
+     resource, which only identifies its region of the page (see getAtlasRegion). ComponentSprite resolves
+     it transparently; any other use of these textures must load them with load instead.
+     
+     Loading can also be split between threads (see SceneLoader): files can be decoded and atlases packed
+     (packAtlas) on any thread, as long as the resources are created on the main thread (loadFromImage,
+     loadAtlas from the packed images, or insert for resources which need no graphics context).
+     
+     Resources are held through handles of the ResourceCache, shared by every manager of the process. load
+     reuses the resource of any manager which has loaded the same file (or one with the same content) and
+     still holds it, instead of decoding it again; resources created from memory can be shared with addToCache.
+     Packed textures keep their atlas page alive, so they can outlive the manager which packed them. They
+     are only reused by loadAtlas, as load must return textures usable on their own.
      */
     template <typename Resource, typename Identifier>
     class ResourceManager
@@ -42,22 +71,82 @@ namespace xgsd {
     public:
         
         typedef std::unique_ptr<ResourceManager<Resource, Identifier>> Ptr;
+        typedef ResourceCache<Resource>                         Cache;
+        typedef typename Cache::Handle                          Handle;
+        
+        // Part of an atlas page where a texture has been packed
+        struct AtlasRegion
+        {
+            const Resource*     page;
+            sf::IntRect         rect;
+        };
+        
+        // Result of packing some images in atlas pages, ready to create their textures (see packAtlas)
+        struct AtlasLayout
+        {
+            std::vector<sf::Image>      pages;
+            std::vector<sf::Vector2u>   usedSizes;  // Area used of each page, the textures are cropped to it
+            std::vector<std::size_t>    imagePages; // Page of each image, or NotPacked if it did not fit in a page
+            std::vector<sf::IntRect>    imageRects; // Region of each packed image in its page
+        };
+        
+        static const unsigned int AtlasPageSize = 2048; // Maximum, pages are cropped to the area used
+        static const unsigned int AtlasPadding = 1; // Empty pixels around each texture, so that neighbours do not bleed into each other
+        static const std::size_t NotPacked = static_cast<std::size_t>(-1);
+        
+        ResourceManager();
         
         void            load(Identifier id, const std::string& filename);
         
         template <typename Parameter>
         void            load(Identifier id, const std::string& filename, const Parameter& secondParam);
         
+        void            loadAtlas(const std::vector<std::pair<Identifier, std::string>>& files); // Textures only
+        void            loadAtlas(const std::vector<Identifier>& ids, const std::vector<sf::Image>& images, const AtlasLayout& layout);
+        void            loadFromImage(Identifier id, const sf::Image& image); // Textures only
+        void            insert(Identifier id, std::unique_ptr<Resource> resource);
+        void            insert(Identifier id, Handle resource);
+        void            addToCache(Identifier id, const std::string& filename, const ContentHash& hash);
+        
         void            unload(Identifier id);
         
         Resource&       get(Identifier id);
         const Resource& get(Identifier id) const;
         
+        void            setPlaceholderMode(bool placeholderMode);
+        bool            isPlaceholderMode() const;
+        
+        static sf::Vector2u getPlaceholderSize(const Resource& resource);
+        static const AtlasRegion* getAtlasRegion(const Resource& resource);
+        static unsigned int getAtlasPageSize();
+        static AtlasLayout  packAtlas(const std::vector<sf::Image>& images, unsigned int pageSize);
+    
     private:
-        void            insertResource(Identifier id, std::unique_ptr<Resource> resource);
+        void            insertResource(Identifier id, Handle resource);
+        void            loadPlaceholder(Identifier id, const std::string& filename);
+        void            insertPlaceholder(Identifier id, sf::Vector2u size);
+        
+        static Handle   makeHandle(std::unique_ptr<Resource> resource, Handle page = nullptr);
+        static std::vector<char> readFile(const std::string& filename, ContentHash& hash);
+        
+        static bool     loadFromContent(sf::Font& font, const std::vector<char>&, const std::string& path);
+        
+        template <typename Other>
+        static bool     loadFromContent(Other& resource, const std::vector<char>& content, const std::string& path);
+        
+        static bool     readPlaceholderSize(const sf::Texture& texture, const std::string& path, sf::Vector2u& size);
+        
+        template <typename Other>
+        static bool     readPlaceholderSize(const Other&, const std::string& path, sf::Vector2u&);
         
     private:
-        std::map<Identifier, std::unique_ptr<Resource>>         mResourceMap;
+        std::map<Identifier, Handle>                            mResourceMap;
+        std::vector<Handle>                                     mAtlasPages;
+        bool                                                    mPlaceholderMode;
+        
+        static std::map<const Resource*, sf::Vector2u>          PlaceholderSizes; // Size of every placeholder loaded by any manager
+        static std::map<const Resource*, AtlasRegion>           AtlasRegions; // Region of every texture packed by any manager
+        static std::mutex                                       AttributesMutex; // Of both maps, as handles may be released by any thread
     };
     
     // Specific resource managers (textures, fonts,  audio...)
@@ -71,34 +160,259 @@ namespace xgsd {
     // Template implementation //
     /////////////////////////////
     
+    template <typename Resource, typename Identifier>
+    std::map<const Resource*, sf::Vector2u> ResourceManager<Resource, Identifier>::PlaceholderSizes;
+    
+    template <typename Resource, typename Identifier>
+    std::map<const Resource*, typename ResourceManager<Resource, Identifier>::AtlasRegion> ResourceManager<Resource, Identifier>::AtlasRegions;
+    
+    template <typename Resource, typename Identifier>
+    std::mutex ResourceManager<Resource, Identifier>::AttributesMutex;
+    
+    template <typename Resource, typename Identifier>
+    const unsigned int ResourceManager<Resource, Identifier>::AtlasPageSize;
+    
+    template <typename Resource, typename Identifier>
+    const unsigned int ResourceManager<Resource, Identifier>::AtlasPadding;
+    
+    template <typename Resource, typename Identifier>
+    const std::size_t ResourceManager<Resource, Identifier>::NotPacked;
+    
+    
+    ////// CONSTRUCTION //////
+    
+    template <typename Resource, typename Identifier>
+    ResourceManager<Resource, Identifier>::ResourceManager()
+    : mPlaceholderMode(false)
+    {
+        
+    }
+    
+    /* Resources are released with their last handle, which may belong to another manager. Then their
+     placeholder size and atlas region are forgotten, as their addresses may be reused. That may happen on any
+     thread holding a handle (i.e: the render thread, or a SceneLoader). A packed texture also holds a handle
+     of its page, released with it. */
+    template <typename Resource, typename Identifier>
+    typename ResourceManager<Resource, Identifier>::Handle ResourceManager<Resource, Identifier>::makeHandle(std::unique_ptr<Resource> resource, Handle page)
+    {
+        return Handle(resource.release(), [page] (Resource* released) mutable {
+            {
+                std::lock_guard<std::mutex> lock(AttributesMutex);
+                PlaceholderSizes.erase(released);
+                AtlasRegions.erase(released);
+            }
+            delete released;
+            page.reset(); // The deleter lives as long as the cache remembers the resource
+        });
+    }
+    
     
     ////// LOAD //////
     
     template <typename Resource, typename Identifier>
     void ResourceManager<Resource, Identifier>::load(Identifier id, const std::string& filename)
     {
-        // Create and load resource
+        // Loaded already by some manager (not packed in an atlas, see loadAtlas)
+        if (Handle cached = Cache::find(filename, mPlaceholderMode)) {
+            insertResource(id, cached);
+            return;
+        }
+        
+        if (mPlaceholderMode) {
+            loadPlaceholder(id, filename);
+            return;
+        }
+        
+        // The same content may have been loaded from another path
+        ContentHash hash;
+        std::vector<char> content = readFile(filename, hash);
+        
+        if (Handle cached = Cache::findContent(hash)) {
+            insertResource(id, cached);
+            Cache::add(filename, false, false, hash, cached);
+            return;
+        }
+        
+        // Create and load resource from the content read (except fonts, see loadFromContent)
         std::unique_ptr<Resource> resource(new Resource());
-        if (!resource->loadFromFile(resourcePath() + filename))
+        if (!loadFromContent(*resource, content, resourcePath() + filename))
             throw std::runtime_error("ResourceManager::load - Failed to load " + resourcePath() + filename);
         
         // If loading successful, insert resource to map
-        insertResource(id, std::move(resource));
+        insertResource(id, makeHandle(std::move(resource)));
+        addToCache(id, filename, hash);
     }
     
     template <typename Resource, typename Identifier>
     template <typename Parameter>
     void ResourceManager<Resource, Identifier>::load(Identifier id, const std::string& filename, const Parameter& secondParam)
     {
-        // Create and load resource
+        if (mPlaceholderMode) {
+            load(id, filename);
+            return;
+        }
+        
+        // Create and load resource. Not cached, the same file may be loaded with other parameters
         std::unique_ptr<Resource> resource(new Resource());
         if (!resource->loadFromFile(resourcePath() + filename, secondParam))
             throw std::runtime_error("ResourceManager::load - Failed to load " + resourcePath() + filename);
         
         // If loading successful, insert resource to map
+        insertResource(id, makeHandle(std::move(resource)));
+    }
+    
+    /* Loads the textures packed in as few atlas pages as possible. Textures which do not fit in a page are
+     loaded on their own, as with load. Cached textures are reused wherever they were packed, only the rest are
+     packed. Standalone cached textures can be drawn as well as packed ones (see getAtlasRegion), so they are
+     reused too. In placeholder mode there are no pages, so all of them are placeholders. */
+    template <typename Resource, typename Identifier>
+    void ResourceManager<Resource, Identifier>::loadAtlas(const std::vector<std::pair<Identifier, std::string>>& files)
+    {
+        if (mPlaceholderMode) {
+            for (auto& file : files)
+                load(file.first, file.second);
+            return;
+        }
+        
+        std::vector<Identifier> ids;
+        std::vector<std::string> paths;
+        std::vector<ContentHash> hashes;
+        std::vector<sf::Image> images;
+        
+        ids.reserve(files.size());
+        paths.reserve(files.size());
+        hashes.reserve(files.size());
+        images.reserve(files.size());
+        
+        for (auto& file : files) {
+            bool packed;
+            
+            if (Handle cached = Cache::find(file.second, false, true, &packed)) {
+                insertResource(file.first, cached);
+                continue;
+            }
+            
+            ContentHash hash;
+            std::vector<char> content = readFile(file.second, hash);
+            
+            if (Handle cached = Cache::findContent(hash, true, &packed)) {
+                insertResource(file.first, cached);
+                Cache::add(file.second, false, packed, hash, cached);
+                continue;
+            }
+            
+            images.push_back(sf::Image());
+            if (!images.back().loadFromMemory(content.data(), content.size()))
+                throw std::runtime_error("ResourceManager::loadAtlas - Failed to load " + resourcePath() + file.second);
+            
+            ids.push_back(file.first);
+            paths.push_back(file.second);
+            hashes.push_back(hash);
+        }
+        
+        loadAtlas(ids, images, packAtlas(images, getAtlasPageSize()));
+        
+        for (std::size_t i = 0; i < ids.size(); ++i)
+            addToCache(ids[i], paths[i], hashes[i]);
+    }
+    
+    /* Creates the textures of images already packed with packAtlas. In placeholder mode the layout is ignored
+     (it may be empty), and all of them are placeholders of the size of their images. */
+    template <typename Resource, typename Identifier>
+    void ResourceManager<Resource, Identifier>::loadAtlas(const std::vector<Identifier>& ids, const std::vector<sf::Image>& images, const AtlasLayout& layout)
+    {
+        assert(ids.size() == images.size());
+        
+        if (mPlaceholderMode) {
+            for (std::size_t i = 0; i < ids.size(); ++i)
+                insertPlaceholder(ids[i], images[i].getSize());
+            return;
+        }
+        
+        assert(layout.imagePages.size() == images.size());
+        
+        // Create the textures of the pages, cropped to their used area
+        std::size_t firstPage = mAtlasPages.size();
+        
+        for (std::size_t page = 0; page < layout.pages.size(); ++page) {
+            sf::Vector2u usedSize = layout.usedSizes[page];
+            
+            std::unique_ptr<Resource> pageTexture(new Resource());
+            if (!pageTexture->loadFromImage(layout.pages[page], sf::IntRect(0, 0, usedSize.x, usedSize.y)))
+                throw std::runtime_error("ResourceManager::loadAtlas - Failed to create an atlas page");
+            
+            mAtlasPages.push_back(makeHandle(std::move(pageTexture)));
+        }
+        
+        DBGMSGC("Texture atlas: " << images.size() << " textures packed in " << layout.pages.size() << " pages.");
+        
+        // Every packed texture is an empty texture which identifies its region. Too big ones get their own texture
+        for (std::size_t i = 0; i < images.size(); ++i) {
+            std::unique_ptr<Resource> resource(new Resource());
+            
+            if (layout.imagePages[i] == NotPacked) {
+                if (!resource->loadFromImage(images[i]))
+                    throw std::runtime_error("ResourceManager::loadAtlas - Failed to create the texture of [" + ids[i] + "]");
+                
+                insertResource(ids[i], makeHandle(std::move(resource)));
+            }
+            else {
+                const Handle& page = mAtlasPages[firstPage + layout.imagePages[i]];
+                
+                {
+                    std::lock_guard<std::mutex> lock(AttributesMutex);
+                    AtlasRegions[resource.get()] = AtlasRegion{ page.get(), layout.imageRects[i] };
+                }
+                
+                insertResource(ids[i], makeHandle(std::move(resource), page));
+            }
+        }
+    }
+    
+    /* Creates a texture from an image decoded elsewhere, or a placeholder of its size in placeholder mode. */
+    template <typename Resource, typename Identifier>
+    void ResourceManager<Resource, Identifier>::loadFromImage(Identifier id, const sf::Image& image)
+    {
+        if (mPlaceholderMode) {
+            insertPlaceholder(id, image.getSize());
+            return;
+        }
+        
+        std::unique_ptr<Resource> resource(new Resource());
+        if (!resource->loadFromImage(image))
+            throw std::runtime_error("ResourceManager::loadFromImage - Failed to create the texture of [" + id + "]");
+        
+        insertResource(id, makeHandle(std::move(resource)));
+    }
+    
+    /* Adds a resource loaded elsewhere (e.g. a font or a sound buffer loaded by a SceneLoader). */
+    template <typename Resource, typename Identifier>
+    void ResourceManager<Resource, Identifier>::insert(Identifier id, std::unique_ptr<Resource> resource)
+    {
+        assert(resource);
+        insertResource(id, makeHandle(std::move(resource)));
+    }
+    
+    /* Adds a resource held by other managers (e.g. one found in the cache). */
+    template <typename Resource, typename Identifier>
+    void ResourceManager<Resource, Identifier>::insert(Identifier id, Handle resource)
+    {
+        assert(resource);
         insertResource(id, std::move(resource));
     }
     
+    /* Shares a resource created from the file (path relative to the resource path) with the managers which load it
+     afterwards. The hash of its content is only used out of placeholder mode (see ResourceCache::hashContent).
+     Packed textures are only shared with the ones loading them with loadAtlas. */
+    template <typename Resource, typename Identifier>
+    void ResourceManager<Resource, Identifier>::addToCache(Identifier id, const std::string& filename, const ContentHash& hash)
+    {
+        auto found = mResourceMap.find(id);
+        assert(found != mResourceMap.end());
+        
+        Cache::add(filename, mPlaceholderMode, getAtlasRegion(*found->second) != nullptr, hash, found->second);
+    }
+    
     
     ////// UNLOAD //////
     
@@ -135,11 +449,191 @@ namespace xgsd {
     ////// INSERT //////
     
     template <typename Resource, typename Identifier>
-    void ResourceManager<Resource, Identifier>::insertResource(Identifier id, std::unique_ptr<Resource> resource)
+    void ResourceManager<Resource, Identifier>::insertResource(Identifier id, Handle resource)
     {
         // Insert and check success
         auto inserted = mResourceMap.insert(std::make_pair(id, std::move(resource)));
         assert(inserted.second);
     }
     
+    
+    ////// PLACEHOLDERS //////
+    
+    /* Placeholder mode only affects the resources loaded afterwards. */
+    template <typename Resource, typename Identifier>
+    void ResourceManager<Resource, Identifier>::setPlaceholderMode(bool placeholderMode)
+    {
+        mPlaceholderMode = placeholderMode;
+    }
+    
+    template <typename Resource, typename Identifier>
+    bool ResourceManager<Resource, Identifier>::isPlaceholderMode() const
+    {
+        return mPlaceholderMode;
+    }
+    
+    /* Size of the file of a placeholder resource, or (0, 0) if it is not a placeholder or has no size. */
+    template <typename Resource, typename Identifier>
+    sf::Vector2u ResourceManager<Resource, Identifier>::getPlaceholderSize(const Resource& resource)
+    {
+        std::lock_guard<std::mutex> lock(AttributesMutex);
+        
+        auto found = PlaceholderSizes.find(&resource);
+        return found != PlaceholderSizes.end() ? found->second : sf::Vector2u();
+    }
+    
+    template <typename Resource, typename Identifier>
+    void ResourceManager<Resource, Identifier>::loadPlaceholder(Identifier id, const std::string& filename)
+    {
+        // Create an empty resource, but check the file anyway, so that missing files are reported as usual
+        std::unique_ptr<Resource> resource(new Resource());
+        sf::Vector2u size;
+        
+        if (!readPlaceholderSize(*resource, resourcePath() + filename, size))
+            throw std::runtime_error("ResourceManager::load - Failed to load " + resourcePath() + filename);
+        
+        insertPlaceholder(id, size);
+        addToCache(id, filename, ContentHash());
+    }
+    
+    template <typename Resource, typename Identifier>
+    void ResourceManager<Resource, Identifier>::insertPlaceholder(Identifier id, sf::Vector2u size)
+    {
+        std::unique_ptr<Resource> resource(new Resource());
+        
+        {
+            std::lock_guard<std::mutex> lock(AttributesMutex);
+            PlaceholderSizes[resource.get()] = size;
+        }
+        
+        insertResource(id, makeHandle(std::move(resource)));
+    }
+    
+    // Textures: the image is decoded in memory, which does not need a graphics context
+    template <typename Resource, typename Identifier>
+    bool ResourceManager<Resource, Identifier>::readPlaceholderSize(const sf::Texture&, const std::string& path, sf::Vector2u& size)
+    {
+        sf::Image image;
+        
+        if (!image.loadFromFile(path))
+            return false;
+        
+        size = image.getSize();
+        return true;
+    }
+    
+    // Other resources have no size, just check that the file can be opened
+    template <typename Resource, typename Identifier>
+    template <typename Other>
+    bool ResourceManager<Resource, Identifier>::readPlaceholderSize(const Other&, const std::string& path, sf::Vector2u&)
+    {
+        return std::ifstream(path).good();
+    }
+    
+    
+    ////// CACHE //////
+    
+    // Reads the whole file (path relative to the resource path) to hash its content
+    template <typename Resource, typename Identifier>
+    std::vector<char> ResourceManager<Resource, Identifier>::readFile(const std::string& filename, ContentHash& hash)
+    {
+        std::vector<char> content;
+        
+        if (!Cache::readFile(resourcePath() + filename, content))
+            throw std::runtime_error("ResourceManager::load - Failed to load " + resourcePath() + filename);
+        
+        hash = Cache::hashContent(content);
+        return content;
+    }
+    
+    // Fonts read their file while they are used, so the content would have to be kept: they are loaded from the file again
+    template <typename Resource, typename Identifier>
+    bool ResourceManager<Resource, Identifier>::loadFromContent(sf::Font& font, const std::vector<char>&, const std::string& path)
+    {
+        return font.loadFromFile(path);
+    }
+    
+    // Other resources are decoded from the content already read to hash it
+    template <typename Resource, typename Identifier>
+    template <typename Other>
+    bool ResourceManager<Resource, Identifier>::loadFromContent(Other& resource, const std::vector<char>& content, const std::string&)
+    {
+        return resource.loadFromMemory(content.data(), content.size());
+    }
+    
+    
+    ////// ATLAS //////
+    
+    /* Region of the page where a texture loaded with loadAtlas has been packed, or nullptr if it was loaded on its own. */
+    template <typename Resource, typename Identifier>
+    const typename ResourceManager<Resource, Identifier>::AtlasRegion* ResourceManager<Resource, Identifier>::getAtlasRegion(const Resource& resource)
+    {
+        // The region stays in the map (so the pointer is valid) until the resource is released
+        std::lock_guard<std::mutex> lock(AttributesMutex);
+        
+        auto found = AtlasRegions.find(&resource);
+        return found != AtlasRegions.end() ? &found->second : nullptr;
+    }
+    
+    /* Size of the atlas pages, limited by the graphics card. Needs a graphics context (unlike packAtlas). */
+    template <typename Resource, typename Identifier>
+    unsigned int ResourceManager<Resource, Identifier>::getAtlasPageSize()
+    {
+        return std::min(Resource::getMaximumSize(), AtlasPageSize);
+    }
+    
+    /* Packs the images in as few pages of the given size as possible, tallest first. Only works on images in
+     memory, so it can run on any thread. */
+    template <typename Resource, typename Identifier>
+    typename ResourceManager<Resource, Identifier>::AtlasLayout ResourceManager<Resource, Identifier>::packAtlas(const std::vector<sf::Image>& images, unsigned int pageSize)
+    {
+        std::vector<std::size_t> order(images.size());
+        
+        for (std::size_t i = 0; i < images.size(); ++i)
+            order[i] = i;
+        
+        std::stable_sort(order.begin(), order.end(), [&images] (std::size_t a, std::size_t b) {
+            return images[a].getSize().y > images[b].getSize().y;
+        });
+        
+        AtlasLayout layout;
+        layout.imagePages.assign(images.size(), NotPacked);
+        layout.imageRects.resize(images.size());
+        
+        std::vector<SkylinePacker> packers;
+        
+        for (std::size_t i : order) {
+            sf::Vector2u size = images[i].getSize();
+            sf::Vector2u paddedSize(size.x + 2 * AtlasPadding, size.y + 2 * AtlasPadding);
+            sf::Vector2u position;
+            std::size_t page = 0;
+            
+            // First page where it fits, or a new one
+            while (page < packers.size() && !packers[page].insert(paddedSize, position))
+                ++page;
+            
+            if (page == packers.size()) {
+                packers.push_back(SkylinePacker(sf::Vector2u(pageSize, pageSize)));
+                
+                if (!packers.back().insert(paddedSize, position)) {
+                    // Too big for a page, so it gets its own texture
+                    packers.pop_back();
+                    continue;
+                }
+                
+                layout.pages.push_back(sf::Image());
+                layout.pages.back().create(pageSize, pageSize, sf::Color::Transparent);
+            }
+            
+            layout.pages[page].copy(images[i], position.x + AtlasPadding, position.y + AtlasPadding);
+            layout.imagePages[i] = page;
+            layout.imageRects[i] = sf::IntRect(position.x + AtlasPadding, position.y + AtlasPadding, size.x, size.y);
+        }
+        
+        for (auto& packer : packers)
+            layout.usedSizes.push_back(packer.getUsedSize());
+        
+        return layout;
+    }
+    
 } // namespace xgsd
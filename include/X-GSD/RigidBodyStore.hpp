@@ -0,0 +1,87 @@
+#pragma once
+
+#include <X-GSD/Time.hpp>
+
+#include <SFML/System/Vector2.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cassert>
+
+namespace xgsd {
+    
+    // Forward declaration
+    class SceneGraphNode;
+    
+    /*
+     RigidBodyStore class. Holds the physics state of every ComponentRigidBody in contiguous arrays (one
+     array per scalar property: velocity x, velocity y, force x...), so that all the bodies are integrated in
+     a single cache-friendly pass per step which the compiler can vectorize, instead of one call per component.
+     
+     Components only hold the id of their body. Ids are stable, while the bodies themselves are kept packed at
+     the beginning of the arrays: when a body is destroyed, the last one is moved to its place (swap and pop).
+     
+     The position of a body is owned by the Transformable of its SceneGraphNode, as gameplay code may move it
+     at any time. It is gathered into the store before integrating, and written back afterwards. The rest of
+     the transform is not integrated, it is only saved with the last state (see returnToLastState).
+     */
+    class RigidBodyStore
+    {
+        // Typedefs and enumerations
+    private:
+        // Part of the last transform which is not integrated, only touched when saving and restoring the last state
+        struct LastTransform
+        {
+            float                       rotation;
+            sf::Vector2f                scale;
+            sf::Vector2f                origin;
+        };
+        
+        // Methods
+    public:
+        RigidBodyStore();
+        
+        int                     create();
+        void                    destroy(int id);
+        
+        void                    integrate(const HiResDuration& dt);
+        void                    returnToLastState(int id);
+        
+        void                    setNode(int id, SceneGraphNode* node);
+        void                    setSimulated(int id, bool simulated);
+        
+        void                    setVelocity(int id, const sf::Vector2f& velocity);
+        sf::Vector2f            getVelocity(int id) const;
+        void                    setForce(int id, const sf::Vector2f& force);
+        sf::Vector2f            getForce(int id) const;
+        void                    setMass(int id, float mass);
+        float                   getMass(int id) const;
+        
+        std::size_t             getBodyCount() const;
+    
+    private:
+        int                     getIndex(int id) const;
+        
+        // Variables (member / properties)
+    private:
+        std::vector<int>                mIndices;       // Index in the arrays of every id, -1 if the id is free
+        std::vector<int>                mIds;           // Id of the body stored at every index
+        std::vector<int>                mFreeIds;
+        
+        std::vector<float>              mPositionsX;    // Gathered from the nodes on every step
+        std::vector<float>              mPositionsY;
+        std::vector<float>              mVelocitiesX;
+        std::vector<float>              mVelocitiesY;
+        std::vector<float>              mForcesX;
+        std::vector<float>              mForcesY;
+        std::vector<float>              mInverseMasses;
+        std::vector<float>              mLastPositionsX;
+        std::vector<float>              mLastPositionsY;
+        std::vector<float>              mLastVelocitiesX;
+        std::vector<float>              mLastVelocitiesY;
+        std::vector<LastTransform>      mLastTransforms;
+        std::vector<std::uint8_t>       mSimulated;     // Attached to a node, neither kinematic nor paused
+        std::vector<SceneGraphNode*>    mNodes;
+    };
+    
+} // namespace xgsd
@@ -2,10 +2,15 @@
 
 #include <X-GSD/Time.hpp>
 #include <X-GSD/Entity.hpp>
+#include <X-GSD/EntityRegistry.hpp>
+#include <X-GSD/RenderCommandList.hpp>
 #include <X-GSD/ControllersManager.hpp>
 #include <X-GSD/PhysicsEngine.hpp>
+#include <X-GSD/ArchetypeWorld.hpp>
 #include <X-GSD/SceneGraphNode.hpp>
 #include <X-GSD/ResourceManager.hpp>
+#include <X-GSD/SceneLoader.hpp>
+#include <X-GSD/Prefab.hpp>
 #include <X-GSD/Event.hpp>
 
 #include <SFML/Graphics/View.hpp>
@@ -23,6 +28,15 @@ namespace xgsd {
      This class also manages loading, unloading, update/render/events calls, etc.
      Contains the main SceneGraphNode (the root element of the scene) and some resource managers to store
      and access fonts, textures, sounds, etc. loaded to this specific scene (or global resources).
+     Without a window (headless mode) the scene is only updated, and its textures are placeholders.
+     Each scene also has an ArchetypeWorld, whose systems are run after updating the scene graph, and an
+     EntityRegistry with the handles and names of its entities. Rendering records the scene on a
+     RenderCommandList, which the Game draws on the window (maybe from its RenderThread).
+     Scene files are loaded in the background by a SceneLoader while the transition fades out; if loading
+     takes longer, the screen stays black showing its progress (see getLoadingProgress). The resources used by
+     both scenes are not loaded again, the new managers share them through the ResourceCache.
+     Entities spawned while playing are instantiated from the prefabs defined in the scene file, which are
+     resolved once when it is loaded (see Prefab).
      */
     
     class Scene
@@ -42,11 +56,11 @@ namespace xgsd {
         
         // Methods
     public:
-        Scene(sf::RenderWindow& window);
+        Scene(sf::RenderWindow* window, const sf::View& view);
         ~Scene();
         
         void                    update(const HiResDuration &dt);
-        void                    render();
+        void                    render(RenderCommandList& commands, float interpolation = 1.f);
         void                    handleEvent(const Event &event);
         
         std::string             getName();
@@ -54,10 +68,16 @@ namespace xgsd {
         TextureManager&         getLocalTextureManager()        { return *mTextureManager; }
         SoundManager&           getLocalSoundManager()          { return *mSoundManager; }
         ControllersManager&     getControllersManager()         { return mControllersManager; }
+        ArchetypeWorld&         getWorld()                      { return mWorld; }
+        EntityRegistry&         getEntityRegistry()             { return mEntityRegistry; }
         
         void                    addNode(SceneGraphNode::Ptr node);
         
-        void                    loadSceneFromFile(std::string jsonPath);
+        const Prefab&           getPrefab(const std::string& name) const;
+        Entity*                 instantiate(const Prefab& prefab, const sf::Transformable& transformable);
+        
+        void                    loadSceneFromFile(std::string path);
+        float                   getLoadingProgress() const;
         
         bool                    isTransitionEnabled();
         void                    setTransitionEnabled(bool option);
@@ -65,19 +85,21 @@ namespace xgsd {
         void                    resumeGame();
         
     private:
-        void                    readJsonSceneFile(std::string jsonPath);
+        void                    loadScene(SceneLoader::LoadedScene& scene);
         void                    performSceneChange();
         void                    unloadScene();
         
         void                    updateTransition(const HiResDuration &dt);
-        void                    renderTransition();
+        void                    renderTransition(RenderCommandList& commands);
         
         
         // Variables (member / properties)
     private:
         std::string             mName;
+        ArchetypeWorld          mWorld; // Declared before the scene graph, as entities remove themselves from it when destroyed
+        EntityRegistry          mEntityRegistry; // Same as the world
         SceneGraphNode::Ptr     mSceneGraph;
-        sf::RenderWindow&       mWindow;
+        sf::RenderWindow*       mWindow; // nullptr in headless mode
         sf::View                mSceneView; // Camera
         std::string             mNextScenePath;
         bool                    mSceneChangeRequest;
@@ -89,6 +111,8 @@ namespace xgsd {
         SoundManager::Ptr       mSoundManager;
         
         ControllersManager      mControllersManager;
+        SceneLoader             mSceneLoader;
+        std::unordered_map<std::string, Prefab> mPrefabs;
         
         PhysicsEngine&          mPhysicsEngine;
         
@@ -97,6 +121,7 @@ namespace xgsd {
         HiResDuration           mTransitionTime;
         HiResDuration           mTransitionDuration;
         sf::RectangleShape      mTransitionFadingRectangle;
+        sf::RectangleShape      mTransitionLoadingBar;
     };
     
 } // namespace xgsd
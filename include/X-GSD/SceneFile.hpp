@@ -0,0 +1,150 @@
+#pragma once
+
+#include <SFML/System/NonCopyable.hpp>
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace xgsd {
+    
+    /*
+     SceneFile class. Compiled form of a scene: a little-endian binary file with a header, flat tables of
+     resource, entity, prefab and component records, and a table of null-terminated strings which the records refer
+     to by their offset. Compiled files are memory-mapped and read in place, so a scene can be instantiated
+     without parsing anything (see Scene::loadScene).
+     
+     Scene files in JSON are compiled in memory when loaded (see SceneLoader), streaming through the text with
+     a JsonReader instead of building a document, or offline with the scene compiler (tools/SceneCompiler.cpp)
+     into ".xgsc" files, which skip parsing altogether. The version changes
+     with the records, so files compiled by older versions have to be compiled again.
+     
+     Files are checked when loaded (sizes, offsets, strings and component ranges), so the records can be used
+     without further checks. Errors are thrown as std::runtime_error.
+     */
+    class SceneFile : private sf::NonCopyable
+    {
+        // Typedefs and enumerations
+    public:
+        static const std::uint32_t  Magic = 0x43534758; // "XGSC" in little-endian
+        static const std::uint32_t  Version = 2;
+        static const std::uint32_t  NoString = 0xFFFFFFFF;
+        
+        enum ResourceType
+        {
+            TextureResource,
+            AtlasTextureResource,   // Texture packed in atlas pages (see TextureManager::loadAtlas)
+            FontResource,
+            SoundResource
+        };
+        
+        enum ComponentType
+        {
+            SpriteComponent,
+            ColliderComponent,
+            RigidBodyComponent,
+            ControllerComponent
+        };
+        
+        enum RecordFlags
+        {
+            NoFlags             = 0,
+            RelativePosition    = 1 << 0,   // Entities: position as a fraction of the view size
+            GlobalTexture       = 1 << 1,   // Sprites: texture of the Game's texture manager
+            HasTextureRect      = 1 << 2,   // Sprites
+            HasCategoryBits     = 1 << 3,   // Colliders
+            HasMaskBits         = 1 << 4,   // Colliders
+            Kinematic           = 1 << 5    // Rigid bodies
+        };
+        
+        // Every record is made of 32-bit fields, and the strings are stored after all of them
+        struct Header
+        {
+            std::uint32_t   magic;
+            std::uint32_t   version;
+            std::uint32_t   name;               // Of the scene
+            std::uint32_t   resourceCount;
+            std::uint32_t   resourceOffset;     // In bytes, from the start of the file
+            std::uint32_t   entityCount;
+            std::uint32_t   entityOffset;
+            std::uint32_t   prefabCount;        // Entity records of the templates (see Prefab)
+            std::uint32_t   prefabOffset;
+            std::uint32_t   componentCount;
+            std::uint32_t   componentOffset;
+            std::uint32_t   stringsSize;
+            std::uint32_t   stringsOffset;
+        };
+        
+        struct ResourceRecord
+        {
+            std::uint32_t   type;               // ResourceType
+            std::uint32_t   name;
+            std::uint32_t   path;
+        };
+        
+        struct EntityRecord
+        {
+            std::uint32_t   name;
+            std::uint32_t   parentName;         // NoString to attach it to the root
+            std::uint32_t   flags;
+            float           origin[2];
+            float           position[2];
+            float           scale[2];
+            float           rotation;
+            std::uint32_t   firstComponent;     // Its components are consecutive, in the order they are added
+            std::uint32_t   componentCount;
+        };
+        
+        struct ComponentRecord
+        {
+            std::uint32_t   type;               // ComponentType
+            std::uint32_t   flags;
+            std::uint32_t   string;             // Texture of sprites, type of controllers
+            std::uint32_t   categoryBits;
+            std::uint32_t   maskBits;
+            std::int32_t    textureRect[4];     // Left, top, width and height
+            float           boundsRect[4];      // Left, top, width and height
+        };
+        
+        // Methods
+    public:
+        SceneFile();
+        ~SceneFile();
+        
+        void                    loadFromFile(const std::string& filename);
+        void                    loadFromMemory(std::vector<char> data);
+        
+        const char*             getName() const;
+        std::size_t             getResourceCount() const;
+        const ResourceRecord&   getResource(std::size_t index) const;
+        std::size_t             getEntityCount() const;
+        const EntityRecord&     getEntity(std::size_t index) const;
+        std::size_t             getPrefabCount() const;
+        const EntityRecord&     getPrefab(std::size_t index) const;
+        const ComponentRecord&  getComponent(std::size_t index) const;
+        const char*             getString(std::uint32_t offset) const;
+        
+        static std::vector<char> compile(const char* begin, const char* end, const std::string& filename);
+    
+    private:
+        void                    takeData(std::vector<char> data, const std::string& filename);
+        void                    check(const std::string& filename);
+        void                    checkString(std::uint32_t offset, const std::string& filename) const;
+        void                    unmap();
+        
+        // Variables (member / properties)
+    private:
+        std::vector<char>       mOwnedData;     // Compiled in memory, or read where files are not mapped
+        const char*             mData;
+        std::size_t             mSize;
+        void*                   mMapping;       // Of the whole file, if mapped
+        
+        const Header*           mHeader;
+        const ResourceRecord*   mResources;
+        const EntityRecord*     mEntities;
+        const EntityRecord*     mPrefabs;
+        const ComponentRecord*  mComponents;
+        const char*             mStrings;
+    };
+    
+} // namespace xgsd
@@ -5,10 +5,11 @@
 #include <X-GSD/Time.hpp>
 #include <X-GSD/Debug.hpp>
 #include <X-GSD/Event.hpp>
+#include <X-GSD/PoolAllocator.hpp>
+#include <X-GSD/RenderCommandList.hpp>
 
 #include <SFML/System/NonCopyable.hpp>
 #include <SFML/Graphics/Transformable.hpp>
-#include <SFML/Graphics/Drawable.hpp>
 
 #include <vector>
 #include <cassert>
@@ -21,8 +22,22 @@ namespace xgsd {
      children SceneGraphNodes and a reference to the parent. Actions like update, draw and handleEvent are
      performed on this node first, and then invoked on all of its children. As the node can have children nodes,
      attachChild, detachChild operations can be used to make or destroy these relationships.
+     
+     The local transform of the node can only be modified through its setters (setPosition, move, rotate...),
+     so that the world transform is cached: modifying the local transform marks the node and all its
+     descendants as dirty, and getWorldTransform only recomputes the matrix of a dirty node the next time it
+     is requested. Nodes which do not move never recompute it.
+     
+     Each node also keeps its local transform as it was at the start of the last simulation step (see
+     Scene::update). draw can place the nodes between that transform and the current one, so that
+     rendering stays smooth when the simulation runs at a lower rate than the display. Call
+     resetInterpolation after teleporting a node, so that it is not drawn sliding to its new place.
+     
+     Nodes (and so entities) are allocated by the PoolAllocator, so spawning and destroying them recycles memory.
+     Each node knows its index in its parent's children, so detaching is constant time, and the children
+     detached in the same performPendingSceneGraphOperations are removed from the collection at once.
      */
-    class SceneGraphNode : public sf::Drawable, private sf::NonCopyable
+    class SceneGraphNode : private sf::NonCopyable
     {
         // Typedefs and enumerations
     public:
@@ -33,6 +48,9 @@ namespace xgsd {
         SceneGraphNode();
         virtual             ~SceneGraphNode();
         
+        static void*        operator new(std::size_t size);
+        static void         operator delete(void* pointer, std::size_t size);
+        
         void                requestDetach(SceneGraphNode* child);
         void                requestAttach(Ptr child);
         void                requestDestroy();
@@ -43,11 +61,29 @@ namespace xgsd {
         void                onPause(const HiResDuration &dt);
 
         void                update(const HiResDuration& dt);
-        void                draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+        void                draw(RenderCommandList& target, sf::RenderStates states, float alpha = 1.f) const;
         void                handleEvent(const Event& event);
         
+        void                setPosition(float x, float y);
+        void                setPosition(const sf::Vector2f& position);
+        void                move(float offsetX, float offsetY);
+        void                move(const sf::Vector2f& offset);
+        void                setRotation(float angle);
+        void                rotate(float angle);
+        void                setScale(float factorX, float factorY);
+        void                setScale(const sf::Vector2f& factors);
+        void                scale(float factorX, float factorY);
+        void                scale(const sf::Vector2f& factor);
+        void                setOrigin(float x, float y);
+        void                setOrigin(const sf::Vector2f& origin);
+        void                setTransformable(const sf::Transformable& transformable);
+        
+        void                savePreviousTransforms();
+        void                resetInterpolation();
+        
+        const sf::Transformable& getTransformable() const;
         sf::Vector2f        getWorldPosition() const;
-        sf::Transform       getWorldTransform() const;
+        const sf::Transform& getWorldTransform() const;
         SceneGraphNode&     getParent();
         bool                isDestroyPending();
         
@@ -67,23 +103,30 @@ namespace xgsd {
         virtual void        handleEventThis(const Event& event);
         void                handleEventChildren(const Event& event);
         
-        virtual void        drawThis(sf::RenderTarget& target, sf::RenderStates states) const;
-        void                drawChildren(sf::RenderTarget& target, sf::RenderStates states) const;
+        virtual void        drawThis(RenderCommandList& target, sf::RenderStates states) const;
+        void                drawChildren(RenderCommandList& target, sf::RenderStates states, float alpha) const;
+        sf::Transform       getInterpolatedTransform(float alpha) const;
         
         void                attachChild(Ptr child);
         Ptr                 detachChild(SceneGraphNode& child);
+        void                removeDetachedChildren();
         void                destroy();
         
+        void                markWorldTransformDirty();
+        
         // Variables (member / properties)
-    public:
+    private:
         sf::Transformable               mTransformable;
+        sf::Transformable               mPreviousTransformable; // At the start of the last simulation step
+        mutable sf::Transform           mWorldTransform;        // Cached, valid only if not dirty
+        mutable bool                    mWorldTransformDirty;   // If a node is dirty, all its descendants are dirty too
         
-    private:
-        std::vector<Ptr>                mChildren;
+        PooledVector<Ptr>               mChildren;
         SceneGraphNode*                 mParent;
+        std::size_t                     mIndexInParent;         // In the parent's mChildren
         
-        std::vector<SceneGraphNode*>    mPendingDetachments;
-        std::vector<Ptr>                mPendingAttachments;
+        PooledVector<SceneGraphNode*>   mPendingDetachments;
+        PooledVector<Ptr>               mPendingAttachments;
         bool                            mPendingDestruction;
     };
     
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <X-GSD/ResourceManager.hpp>
+#include <X-GSD/SceneFile.hpp>
+#include <X-GSD/ThreadPool.hpp>
+
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/Graphics/Font.hpp>
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <future>
+#include <atomic>
+#include <utility>
+#include <cstdint>
+
+namespace xgsd {
+    
+    /*
+     SceneLoader class. Loads the file of a scene in the background, so that the game keeps running (e.g. the
+     fade-out transition of the Scene) meanwhile. A thread maps the compiled scene file (or parses and compiles
+     a JSON one, see SceneFile) and checks its resources, and the files are decoded by a ThreadPool: images are
+     decoded and packed in atlas pages, fonts are opened and sounds are decoded to samples. Then the main thread
+     only has to create the textures and sound buffers and the entities (see Scene::loadScene), as they need
+     the graphics and audio contexts or the current scene.
+     
+     Files whose resources are held by some manager already are looked up in the ResourceCache, by path or by
+     content, and not decoded again: as the loader runs before the current scene is unloaded, the resources
+     shared by both scenes survive the change. The files are read one after another, which suits slow disks,
+     and decoded from memory.
+     
+     In placeholder mode only the images are decoded, to get their size. Fonts and sounds are left to the
+     placeholder mode of their resource managers.
+     
+     Errors are thrown by finish, on the thread which calls it.
+     */
+    class SceneLoader : private sf::NonCopyable
+    {
+        // Typedefs and enumerations
+    public:
+        struct File
+        {
+            std::string                 name;
+            std::string                 path;
+            ContentHash                 hash;       // Of the content, to add the resource to the ResourceCache
+            std::vector<char>           content;    // Released once decoded
+        };
+        
+        struct SoundData
+        {
+            std::vector<sf::Int16>      samples;
+            unsigned int                channelCount;
+            unsigned int                sampleRate;
+        };
+        
+        template <typename Manager>
+        using CachedResources = std::vector<std::pair<std::string, typename Manager::Handle>>;
+        
+        // Everything the main thread needs to load the scene. Each list of files goes with its decoded resources
+        struct LoadedScene
+        {
+            std::string                 path;
+            SceneFile                   file;
+            bool                        placeholderMode;
+            
+            std::vector<File>           textureFiles; // Loaded on their own
+            std::vector<sf::Image>      textures;
+            std::vector<File>           atlasFiles; // Textures packed in atlas pages
+            std::vector<sf::Image>      atlasImages;
+            TextureManager::AtlasLayout atlasLayout; // Empty in placeholder mode
+            std::vector<File>           fontFiles;
+            std::vector<std::unique_ptr<sf::Font>> fonts; // Empty in placeholder mode
+            std::vector<File>           soundFiles;
+            std::vector<SoundData>      sounds;     // Empty in placeholder mode
+            
+            // Found in the cache, by name
+            CachedResources<TextureManager> cachedTextures;
+            CachedResources<FontManager> cachedFonts;
+            CachedResources<SoundManager> cachedSounds;
+        };
+        
+        // Methods
+    public:
+        SceneLoader();
+        
+        void                        start(const std::string& path, bool placeholderMode, unsigned int atlasPageSize);
+        std::unique_ptr<LoadedScene> finish();
+        
+        bool                        isLoading() const;
+        bool                        isFinished() const;
+        float                       getProgress() const;
+    
+    private:
+        std::unique_ptr<LoadedScene> load(const std::string& path, bool placeholderMode, unsigned int atlasPageSize);
+        void                        findCachedFiles(LoadedScene& scene);
+        void                        decodeFiles(LoadedScene& scene);
+        
+        // Variables (member / properties)
+    private:
+        std::unique_ptr<ThreadPool> mThreadPool;    // One worker per core, made on first use (see decodeFiles)
+        std::atomic<std::size_t>    mLoadedSteps;   // Files decoded, plus parsing, reading and packing
+        std::atomic<std::size_t>    mTotalSteps;    // 0 until the scene file has been read
+        std::future<std::unique_ptr<LoadedScene>> mResult; // Declared after the pool, so that it is waited for before destroying the pool
+    };
+    
+} // namespace xgsd
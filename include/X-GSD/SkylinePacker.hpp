@@ -0,0 +1,45 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+
+#include <vector>
+
+namespace xgsd {
+    
+    /*
+     SkylinePacker class. Packs rectangles into an area of fixed size, used to build texture atlases (see
+     TextureManager::loadAtlas). It keeps the skyline of the rectangles packed so far (the top edge of the
+     used area, as a list of horizontal segments), and places each new rectangle where its top ends lowest,
+     on the leftmost position in case of a tie (bottom-left rule). Packing the tallest rectangles first gives
+     the best results.
+     */
+    class SkylinePacker
+    {
+        // Typedefs and enumerations
+    private:
+        struct Segment
+        {
+            unsigned int    x;
+            unsigned int    y;
+            unsigned int    width;
+        };
+        
+        // Methods
+    public:
+        explicit SkylinePacker(sf::Vector2u size);
+        
+        bool                    insert(sf::Vector2u size, sf::Vector2u& position);
+        sf::Vector2u            getUsedSize() const;
+    
+    private:
+        bool                    fits(std::size_t index, sf::Vector2u size, unsigned int& y) const;
+        void                    addSegment(std::size_t index, const Segment& segment);
+        
+        // Variables (member / properties)
+    private:
+        sf::Vector2u            mSize;
+        sf::Vector2u            mUsedSize;  // Bounding box of the packed rectangles
+        std::vector<Segment>    mSkyline;   // Covers the whole width, from left to right
+    };
+    
+} // namespace xgsd
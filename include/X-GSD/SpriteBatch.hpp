@@ -0,0 +1,68 @@
+#pragma once
+
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/RenderStates.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <cassert>
+
+namespace xgsd {
+    
+    /*
+     SpriteBatch class. Merges the draws of many sprites into a few draw calls. Instead of being drawn one by
+     one, sprites are added to the batch as two triangles with the world transform already applied, in one
+     vertex array per run of consecutive sprites with the same texture and blend mode. Flushing the batch
+     draws each vertex array with a single call, so hundreds of sprites sharing a texture (or the pages of a
+     texture atlas, see TextureManager::loadAtlas) take a handful of draw calls.
+     
+     Sprites are drawn in the order they were added: a sprite with another texture starts a new run, so it
+     stays over the sprites added before it and under the ones added after it. Flush the batch before drawing
+     anything else on the target, so that it keeps its order with respect to the batched sprites (see
+     RenderCommandList::replay, which draws all the sprites of a frame through the batch of the Game).
+     
+     The statistics can be read by any thread, as the batch may be used by the RenderThread.
+     */
+    class SpriteBatch : private sf::NonCopyable
+    {
+        // Typedefs and enumerations
+    private:
+        struct Batch
+        {
+            const sf::Texture*      texture;
+            sf::BlendMode           blendMode;
+            std::vector<sf::Vertex> vertices;   // Two triangles per sprite
+        };
+        
+        // Methods
+    public:
+        SpriteBatch();
+        
+        void                    add(const sf::Sprite& sprite, const sf::RenderStates& states);
+        void                    flush(sf::RenderTarget& target);
+        bool                    isEmpty() const;
+        
+        void                    setEnabled(bool option);
+        bool                    isEnabled() const;
+        
+        void                    resetStatistics();
+        std::size_t             getDrawCallCount() const;
+        std::size_t             getSpriteCount() const;
+    
+    private:
+        Batch&                  getBatch(const sf::Texture* texture, const sf::BlendMode& blendMode);
+        
+        // Variables (member / properties)
+    private:
+        std::vector<Batch>      mBatches;           // Kept between flushes, so that their memory is reused
+        std::size_t             mActiveBatches;     // The first ones of mBatches, in drawing order
+        std::atomic<std::size_t> mDrawCalls;        // Since the last resetStatistics
+        std::atomic<std::size_t> mSprites;
+        bool                    mEnabled;
+    };
+    
+} // namespace xgsd
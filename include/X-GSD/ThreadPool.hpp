@@ -0,0 +1,63 @@
+#pragma once
+
+#include <SFML/System/NonCopyable.hpp>
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+namespace xgsd {
+    
+    /*
+     ThreadPool class. A fixed set of worker threads used to split loops over many items (e.g. the collision
+     pair generation of the PhysicsEngine). parallelFor splits the range in chunks which are taken by the
+     workers and by the calling thread until none is left, and returns when all of them have finished.
+     
+     The task receives the index of the thread running it (0 is always the calling thread), so that each
+     thread can write to its own buffer without locks. With a single thread, or if the range is not larger
+     than one chunk, the task runs directly on the calling thread.
+     */
+    class ThreadPool : private sf::NonCopyable
+    {
+        // Typedefs and enumerations
+    public:
+        typedef std::function<void(std::size_t begin, std::size_t end, std::size_t thread)> Task;
+        
+        // Methods
+    public:
+        ThreadPool(std::size_t threadCount = 1);
+        ~ThreadPool();
+        
+        void                        setThreadCount(std::size_t threadCount);
+        std::size_t                 getThreadCount() const;
+        
+        void                        parallelFor(std::size_t count, std::size_t chunkSize, const Task& task);
+    
+    private:
+        void                        startWorkers(std::size_t workerCount);
+        void                        stopWorkers();
+        void                        workerLoop(std::size_t thread, std::uint64_t lastGeneration);
+        void                        runChunks(std::size_t thread);
+        
+        // Variables (member / properties)
+    private:
+        std::vector<std::thread>    mWorkers;
+        std::mutex                  mMutex;
+        std::condition_variable     mWorkAvailable;
+        std::condition_variable     mWorkFinished;
+        
+        // Current parallelFor, protected by mMutex (except mNextIndex, taken atomically by every thread)
+        const Task*                 mTask;
+        std::size_t                 mCount;
+        std::size_t                 mChunkSize;
+        std::atomic<std::size_t>    mNextIndex;
+        std::size_t                 mBusyWorkers;
+        std::uint64_t               mGeneration; // Incremented on every parallelFor, so that workers know there is new work
+        bool                        mStopping;
+    };
+    
+} // namespace xgsd
@@ -1,11 +1,15 @@
 #include "EnemyController.hpp"
-#include <string>
 
 EnemyController::EnemyController()
 {
 	// Load resources here (RAII)
 }
 
+unsigned EnemyController::getCallbacks() const
+{
+	return getOverriddenCallbacks<EnemyController>();
+}
+
 void EnemyController::onEntityAttach()
 {
 	// Broadcast a "AsteroidCreated" event
@@ -18,22 +22,18 @@ void EnemyController::onEntityAttach()
 
 void EnemyController::update(const HiResDuration &dt)
 {
-    entity->mTransformable.rotate(50*dt.count()/(float)ONE_SECOND.count());
+    entity->rotate(50*dt.count()/(float)ONE_SECOND.count());
 }
 
 
-void EnemyController::collisionHandler(Entity *theOtherEntity, sf::FloatRect collision)
+void EnemyController::onCollisionEnter(Entity *theOtherEntity, sf::FloatRect collision)
 {
 	
-	// Get destroyed
-    if (theOtherEntity->getName().find("bullet") != std::string::npos) {
-		
-		theOtherEntity->requestDestroy(); // Destroy the bullet
-		
-		// Destroy the Asteroid
-		entity->requestDestroy();
-	}
+	// Get destroyed. The collision layers only let asteroids collide with bullets and the player
+	theOtherEntity->requestDestroy(); // Destroy the bullet (or the player)
 	
+	// Destroy the Asteroid
+	entity->requestDestroy();
 }
 
 EnemyController::~EnemyController()
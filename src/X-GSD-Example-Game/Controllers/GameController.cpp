@@ -1,4 +1,5 @@
 #include "GameController.hpp"
+#include "CollisionCategories.hpp"
 
 GameController::GameController()
 : mGameOverTime(0)
@@ -14,6 +15,7 @@ GameController::GameController()
 , mGameOver(false)
 , mPaused(false)
 , mStopped(false)
+, mAsteroidPrefabs()
 {
 	// Load resources here (RAII)
 	
@@ -24,9 +26,14 @@ GameController::GameController()
 	randomasteroidTextureValues = std::uniform_int_distribution<int>(1, 3);
 }
 
+unsigned GameController::getCallbacks() const
+{
+	return getOverriddenCallbacks<GameController>();
+}
+
 void GameController::onEntityAttach()
 {
-	sf::Vector2f viewSize = Game::instance().getWindow().getView().getSize();
+	sf::Vector2f viewSize = Game::instance().getViewSize();
 	
 	// Points text configuration
 	mPointsText.setFont(Game::instance().getLocalFontManager().get("mainFont"));
@@ -39,7 +46,7 @@ void GameController::onEntityAttach()
 	mCentralText.setFont(Game::instance().getLocalFontManager().get("mainFont"));
 	mCentralText.setCharacterSize(32);
 	mCentralText.setString("PAUSE");
-	mCentralText.setPosition(viewSize.x / 2.f - mCentralText.getLocalBounds().width/ 2.f, viewSize.y / 2.f - mCentralText.getLocalBounds().height / 2.f);
+	centerText(mCentralText);
 	mCentralText.setColor(sf::Color::White);
 	
 	// Set the central text rectangle (background with alpha, so that the text is more readable)
@@ -56,8 +63,13 @@ void GameController::onEntityAttach()
 	
 	// Set the background
 	mBackground.setTexture(&Game::instance().getLocalTextureManager().get("BGTexture"));
-	mBackground.setTextureRect(sf::IntRect(15, 15, Game::instance().getWindow().getView().getSize().x-15, Game::instance().getWindow().getView().getSize().y-15));
-	mBackground.setSize(sf::Vector2f(Game::instance().getWindow().getView().getSize().x, Game::instance().getWindow().getView().getSize().y));
+	mBackground.setTextureRect(sf::IntRect(15, 15, viewSize.x-15, viewSize.y-15));
+	mBackground.setSize(viewSize);
+	
+	// Asteroid prefabs, one for each texture (defined in GameScene.json)
+	mAsteroidPrefabs[0] = &Game::instance().getSceneManager().getPrefab("asteroid1");
+	mAsteroidPrefabs[1] = &Game::instance().getSceneManager().getPrefab("asteroid2");
+	mAsteroidPrefabs[2] = &Game::instance().getSceneManager().getPrefab("asteroid3");
 }
 
 void GameController::update(const xgsd::HiResDuration& dt)
@@ -79,7 +91,7 @@ void GameController::update(const xgsd::HiResDuration& dt)
 	}
 }
 
-void GameController::draw(sf::RenderTarget &target, sf::RenderStates states) const
+void GameController::draw(RenderCommandList &target, sf::RenderStates states) const
 {
 	// Draw the background
 	target.draw(mBackground, states);
@@ -90,7 +102,7 @@ void GameController::draw(sf::RenderTarget &target, sf::RenderStates states) con
 	// Draw central text with background
 	if (mPaused || mGameOver) {
 		target.draw(mCentralTextRectangle, states);
-		target.draw(mCentralText, states);
+		target.drawText(mCentralText, sf::Vector2f(0.5f, 0.5f), sf::Color::Transparent, states);
 	}
 	
 	// Draw player information
@@ -139,8 +151,14 @@ void GameController::gameOver()
 	DBGMSGC("GAME OVER :(");
 	mGameOver = true;
 	mCentralText.setString("GAME OVER");
-	sf::Vector2f viewSize = Game::instance().getWindow().getView().getSize();
-	mCentralText.setPosition(viewSize.x / 2.f - mCentralText.getLocalBounds().width/ 2.f, viewSize.y / 2.f - mCentralText.getLocalBounds().height / 2.f);
+	centerText(mCentralText);
+}
+
+// Center the text in the view. Its bounds are only taken by the render side, which centers it on its position (see draw)
+void GameController::centerText(sf::Text& text)
+{
+	sf::Vector2f viewSize = Game::instance().getViewSize();
+	text.setPosition(viewSize.x / 2.f, viewSize.y / 2.f);
 }
 
 void GameController::pause()
@@ -158,46 +176,17 @@ void GameController::pause()
 
 void GameController::spawnAsteroid()
 {
-	// Create the two new asteroids entities
-	std::string asteroidName = "asteroid_" + std::to_string(++mCreatedAsteroids);
-	Entity::Ptr asteroidEntity(new Entity(asteroidName));
-	
-	// Set its position
-	asteroidEntity->mTransformable.setPosition(randomasteroidPositionValues(randomEngine), -50);
-	
-	// Create the required components
-	int randomTexture = randomasteroidTextureValues(randomEngine);
-	std::string textureName;
-	
-	switch (randomTexture) {
-		case 1:
-			textureName = "asteroid1";
-			break;
-		case 2:
-			textureName = "asteroid2";
-			break;
-		case 3:
-			textureName = "asteroid3";
-			break;
-	}
-	ComponentSprite::Ptr asteroidSprite(new ComponentSprite(Game::instance().getLocalTextureManager().get(textureName)));
-	
-	// Create the rigidbody and set initial velocity
-	ComponentRigidBody *rb = new ComponentRigidBody(false);
-    rb->getPhysicsState().getVelocityRef().y = 25;// + random()%100;
-	ComponentRigidBody::Ptr asteroidRigidbody(rb);
-	
-	// Create the collider
-	ComponentCollider::Ptr asteroidCollider(new ComponentCollider());
+	// Create the new asteroid entity from one of its prefabs, at a random position
+	++mCreatedAsteroids;
+	float x = randomasteroidPositionValues(randomEngine);
+	const Prefab& prefab = *mAsteroidPrefabs[randomasteroidTextureValues(randomEngine) - 1];
 	
-	// Add the components
-	asteroidEntity->addComponent(std::move(asteroidSprite));
-	asteroidEntity->addComponent(std::move(asteroidRigidbody));
-	asteroidEntity->addComponent(std::move(asteroidCollider));
-	asteroidEntity->addComponent(Game::instance().getControllersManager().getController("EnemyController"));
+	sf::Transformable transformable = prefab.getTransformable();
+	transformable.setPosition(x, -50);
 	
-	// And finally, add it to the scene
-	Game::instance().getSceneManager().addNode(std::move(asteroidEntity));
+	// Add it to the scene, and set its initial velocity
+	Entity* asteroidEntity = Game::instance().getSceneManager().instantiate(prefab, transformable);
+	asteroidEntity->getComponent<ComponentRigidBody>()->setVelocity(sf::Vector2f(0, 25));// + random()%100;
 }
 
 GameController::~GameController()
@@ -1,12 +1,19 @@
 #include "PlayerController.hpp"
+#include "CollisionCategories.hpp"
 
 PlayerController::PlayerController()
 : mVelocity(200)
 , mNumShots(0)
+, mBulletPrefab(nullptr)
 {
     // Load resources here (RAII)
 }
 
+unsigned PlayerController::getCallbacks() const
+{
+	return getOverriddenCallbacks<PlayerController>();
+}
+
 void PlayerController::onEntityAttach()
 {
     // Get references to components that will be used frequently
@@ -16,13 +23,16 @@ void PlayerController::onEntityAttach()
     assert(sprite);
     
     // No gravity
-    rigidBody->getPhysicsState().setForce(sf::Vector2f());
+    rigidBody->setForce(sf::Vector2f());
 
     // Get the screen bounds
-    mBounds = sf::Rect<float>(0, 0, Game::instance().getWindow().getSize().x, Game::instance().getWindow().getSize().y); ;
+    mBounds = sf::Rect<float>(0, 0, Game::instance().getViewSize().x, Game::instance().getViewSize().y);
     
     // Set sounds
     mShootingSound.setBuffer(Game::instance().getLocalSoundManager().get("bulletSound"));
+    
+    // Bullet prefab (defined in GameScene.json)
+    mBulletPrefab = &Game::instance().getSceneManager().getPrefab("bullet");
 }
 
 void PlayerController::update(const HiResDuration& dt)
@@ -47,41 +57,41 @@ void PlayerController::handleEvent(const Event& event)
     }
 }
 
-void PlayerController::collisionHandler(Entity *theOtherEntity, sf::FloatRect collision)
+void PlayerController::onCollisionEnter(Entity *theOtherEntity, sf::FloatRect collision)
 {
-    // Get destroyed
-    if (theOtherEntity->getName().find("asteroid") != std::string::npos) {
-        
-        theOtherEntity->requestDestroy(); // Destroy the asteroid
-        
-        // Destroy the player
-        entity->requestDestroy();
-    }
+    // Get destroyed. The collision layers only let the player collide with asteroids
+    theOtherEntity->requestDestroy(); // Destroy the asteroid
     
+    // Destroy the player
+    entity->requestDestroy();
 }
 
 void PlayerController::handleRealTimeInput(const HiResDuration &dt)
 {
+    // There is no keyboard in headless mode
+    if (Game::instance().isHeadless())
+        return;
+    
     // Basic Keyboard controls
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left) || sf::Keyboard::isKeyPressed(sf::Keyboard::A))
     {
-        rigidBody->getPhysicsState().setVelocity(sf::Vector2f(-mVelocity, rigidBody->getPhysicsState().getVelocity().y));
+        rigidBody->setVelocity(sf::Vector2f(-mVelocity, rigidBody->getVelocity().y));
     }
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right) || sf::Keyboard::isKeyPressed(sf::Keyboard::D))
     {
-        rigidBody->getPhysicsState().setVelocity(sf::Vector2f(mVelocity, rigidBody->getPhysicsState().getVelocity().y));
+        rigidBody->setVelocity(sf::Vector2f(mVelocity, rigidBody->getVelocity().y));
     }
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up) || sf::Keyboard::isKeyPressed(sf::Keyboard::W))
     {
-        rigidBody->getPhysicsState().setVelocity(sf::Vector2f(rigidBody->getPhysicsState().getVelocity().x, -mVelocity));
+        rigidBody->setVelocity(sf::Vector2f(rigidBody->getVelocity().x, -mVelocity));
     }
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down) || sf::Keyboard::isKeyPressed(sf::Keyboard::S))
     {
-        rigidBody->getPhysicsState().setVelocity(sf::Vector2f(rigidBody->getPhysicsState().getVelocity().x, mVelocity));
+        rigidBody->setVelocity(sf::Vector2f(rigidBody->getVelocity().x, mVelocity));
     }
     
     // Reduce velocity gradually
-    rigidBody->getPhysicsState().setVelocity(sf::Vector2f(rigidBody->getPhysicsState().getVelocity().x * 0.9f, rigidBody->getPhysicsState().getVelocity().y * 0.9));
+    rigidBody->setVelocity(sf::Vector2f(rigidBody->getVelocity().x * 0.9f, rigidBody->getVelocity().y * 0.9));
 }
 
 void PlayerController::shoot()
@@ -89,30 +99,16 @@ void PlayerController::shoot()
     // Play a sound
     mShootingSound.play();
     
-    // Create the entity
-    Entity::Ptr bulletEntity(new Entity("bullet_" + std::to_string(mNumShots)));
-    
-    // Set its position to the player's
-    bulletEntity->mTransformable.setPosition(entity->mTransformable.getPosition());
-    bulletEntity->mTransformable.move(32-8, 0); // Center it so that the bullet exits from the center of the player
-    
-    // Create the required components
-    ComponentSprite::Ptr bulletSprite(new ComponentSprite(Game::instance().getLocalTextureManager().get("bulletTexture")));
-    
-    ComponentRigidBody::Ptr bulletRigidBody(new ComponentRigidBody(false));
-    
-    ComponentCollider::Ptr bulletCollider(new ComponentCollider());
-    
-    // Add the components
-    bulletEntity->addComponent(std::move(bulletSprite));
-    bulletEntity->addComponent(std::move(bulletRigidBody));
-    bulletEntity->addComponent(std::move(bulletCollider));
+    // Create the bullet from its prefab, at the player's position
+    sf::Transformable transformable = mBulletPrefab->getTransformable();
+    transformable.setPosition(entity->getTransformable().getPosition());
+    transformable.move(32-8, 0); // Center it so that the bullet exits from the center of the player
     
-    bulletEntity->getComponent<ComponentRigidBody>()->getPhysicsState().setForce(sf::Vector2f());
-    bulletEntity->getComponent<ComponentRigidBody>()->getPhysicsState().setVelocity(sf::Vector2f(0, -300));
+    // Add it to the scene, and set its velocity
+    Entity* bulletEntity = Game::instance().getSceneManager().instantiate(*mBulletPrefab, transformable);
     
-    // And finally, add it to the scene
-    Game::instance().getSceneManager().addNode(std::move(bulletEntity));
+    bulletEntity->getComponent<ComponentRigidBody>()->setForce(sf::Vector2f());
+    bulletEntity->getComponent<ComponentRigidBody>()->setVelocity(sf::Vector2f(0, -300));
     
     mNumShots++;
 }
@@ -7,6 +7,11 @@ TitleMenuController::TitleMenuController()
     // Load resources here (RAII)
 }
 
+unsigned TitleMenuController::getCallbacks() const
+{
+	return getOverriddenCallbacks<TitleMenuController>();
+}
+
 void TitleMenuController::onEntityAttach()
 {
     // Sound
@@ -22,11 +27,8 @@ void TitleMenuController::onEntityAttach()
     // Size
     mTextPressAnyKey.setCharacterSize(14);
     
-    // Positioning
-    sf::Vector2f viewSize = Game::instance().getWindow().getView().getSize();
-    sf::FloatRect textRect = mTextPressAnyKey.getLocalBounds();
-    mTextPressAnyKey.setOrigin(textRect.left + textRect.width/2.0f,
-                               textRect.top  + textRect.height/2.0f);
+    // Positioning (centered on its position when drawn, see draw)
+    sf::Vector2f viewSize = Game::instance().getViewSize();
     mTextPressAnyKey.setPosition(viewSize.x / 2.0f, viewSize.y / 1.2f);
     
     // Color
@@ -50,13 +52,13 @@ void TitleMenuController::update(const HiResDuration& dt)
     }
 }
 
-void TitleMenuController::draw(sf::RenderTarget &target, sf::RenderStates states) const
+void TitleMenuController::draw(RenderCommandList &target, sf::RenderStates states) const
 {
     // Draw background
     target.draw(mBackground, states);
     
-    // Draw text on top of everything
-    target.draw(mTextPressAnyKey, states);
+    // Draw text on top of everything. It is centered by the render side, which is the only one measuring texts
+    target.drawText(mTextPressAnyKey, sf::Vector2f(0.5f, 0.5f), sf::Color::Transparent, states);
 }
 
 void TitleMenuController::handleEvent(const Event& event)
@@ -73,7 +75,7 @@ void TitleMenuController::handleEvent(const Event& event)
             
             // Pressing Esc will close the game
             if (systemEvent.key.code == sf::Keyboard::Escape) {
-                Game::instance().getWindow().close();
+                Game::instance().quit();
                 return;
             }
             
@@ -3,7 +3,7 @@
 #include <stdexcept>
 #include <iostream>
 
-int main()
+int main(int argc, char* argv[])
 {
 	// General try-catch for unhandled exceptions in game
 	try
@@ -18,8 +18,12 @@ int main()
 		 xgsd::Game::instance().runVariableDeltaTime();
 		 xgsd::Game::instance().runSemiFixedDeltaTime();
 		 xgsd::Game::instance().runFixedSimulationVariableFramerate();
+		 
+		 Pass --headless (and optionally --steps N) to run the simulation without a window.
 		 */
         
+        xgsd::Game::instance().parseCommandLine(argc, argv);
+        
         //xgsd::Game::instance().runFixedDeltaTime(30);
         xgsd::Game::instance().runFixedSimulationVariableFramerate(60);
 	}
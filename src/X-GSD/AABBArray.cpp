@@ -0,0 +1,168 @@
+#include <X-GSD/AABBArray.hpp>
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define XGSD_AABB_KERNEL_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define XGSD_AABB_KERNEL_SSE
+#endif
+
+using namespace xgsd;
+
+namespace {
+    
+    // Empty boxes used as padding. They never overlap anything, as their min is greater than their max
+    const float PaddingMin = std::numeric_limits<float>::infinity();
+    const float PaddingMax = -std::numeric_limits<float>::infinity();
+    
+} // anonymous namespace
+
+#if defined(XGSD_AABB_KERNEL_AVX2)
+const std::size_t AABBArray::KernelWidth = 8;
+#else
+const std::size_t AABBArray::KernelWidth = 4;
+#endif
+
+AABBArray::AABBArray()
+: mMinX()
+, mMinY()
+, mMaxX()
+, mMaxY()
+, mSize(0)
+{
+    
+}
+
+void AABBArray::clear()
+{
+    // Keep the memory, but fill the used part with padding again (the rest is always padding)
+    std::fill(mMinX.begin(), mMinX.begin() + mSize, PaddingMin);
+    std::fill(mMinY.begin(), mMinY.begin() + mSize, PaddingMin);
+    std::fill(mMaxX.begin(), mMaxX.begin() + mSize, PaddingMax);
+    std::fill(mMaxY.begin(), mMaxY.begin() + mSize, PaddingMax);
+    mSize = 0;
+}
+
+void AABBArray::push_back(const sf::FloatRect& bounds)
+{
+    // Always keep at least KernelWidth boxes of padding after the last one, so that the kernel can read
+    // a whole block starting at any box
+    if (mSize + KernelWidth >= mMinX.size()) {
+        std::size_t capacity = std::max<std::size_t>(mMinX.size() * 2, KernelWidth * 4);
+        mMinX.resize(capacity, PaddingMin);
+        mMinY.resize(capacity, PaddingMin);
+        mMaxX.resize(capacity, PaddingMax);
+        mMaxY.resize(capacity, PaddingMax);
+    }
+    
+    set(mSize++, bounds);
+}
+
+void AABBArray::set(std::size_t index, const sf::FloatRect& bounds)
+{
+    assert(index < mSize);
+    
+    // Same normalization as sf::FloatRect::intersects, for boxes with negative sizes
+    mMinX[index] = std::min(bounds.left, bounds.left + bounds.width);
+    mMinY[index] = std::min(bounds.top, bounds.top + bounds.height);
+    mMaxX[index] = std::max(bounds.left, bounds.left + bounds.width);
+    mMaxY[index] = std::max(bounds.top, bounds.top + bounds.height);
+}
+
+// Moves the last box to the given index, and removes the last one
+void AABBArray::swapAndPop(std::size_t index)
+{
+    assert(index < mSize);
+    
+    std::size_t last = --mSize;
+    
+    mMinX[index] = mMinX[last];
+    mMinY[index] = mMinY[last];
+    mMaxX[index] = mMaxX[last];
+    mMaxY[index] = mMaxY[last];
+    
+    mMinX[last] = PaddingMin;
+    mMinY[last] = PaddingMin;
+    mMaxX[last] = PaddingMax;
+    mMaxY[last] = PaddingMax;
+}
+
+std::size_t AABBArray::size() const
+{
+    return mSize;
+}
+
+/* Tests the given bounds against the boxes in [begin, end), and stores the indices of the ones it overlaps
+ in ascending order. Returns the number of overlaps found. */
+std::size_t AABBArray::findOverlaps(const sf::FloatRect& bounds, std::size_t begin, std::size_t end, std::vector<std::uint32_t>& overlaps) const
+{
+    assert(begin <= end && end <= mSize);
+    
+    overlaps.clear();
+    
+    const float box[4] = {
+        std::min(bounds.left, bounds.left + bounds.width),
+        std::min(bounds.top, bounds.top + bounds.height),
+        std::max(bounds.left, bounds.left + bounds.width),
+        std::max(bounds.top, bounds.top + bounds.height)
+    };
+    
+    for (std::size_t index = begin; index < end; index += KernelWidth) {
+        unsigned mask = overlapMask(index, box);
+        
+        // Discard the boxes past the end of the range (the padding never overlaps, but other boxes may)
+        if (end - index < KernelWidth)
+            mask &= (1u << (end - index)) - 1;
+        
+        for (std::uint32_t i = (std::uint32_t)index; mask != 0; ++i, mask >>= 1)
+            if (mask & 1)
+                overlaps.push_back(i);
+    }
+    
+    return overlaps.size();
+}
+
+/* Overlap kernel. Tests the box against KernelWidth boxes starting at index, and returns a mask with bit i
+ set if the box overlaps the box at index + i. Two boxes overlap if, on both axes, the greatest of their mins
+ is less than the least of their maxs, which is exactly the test of sf::FloatRect::intersects. */
+unsigned AABBArray::overlapMask(std::size_t index, const float* box) const
+{
+#if defined(XGSD_AABB_KERNEL_AVX2)
+    __m256 left   = _mm256_max_ps(_mm256_loadu_ps(&mMinX[index]), _mm256_set1_ps(box[0]));
+    __m256 top    = _mm256_max_ps(_mm256_loadu_ps(&mMinY[index]), _mm256_set1_ps(box[1]));
+    __m256 right  = _mm256_min_ps(_mm256_loadu_ps(&mMaxX[index]), _mm256_set1_ps(box[2]));
+    __m256 bottom = _mm256_min_ps(_mm256_loadu_ps(&mMaxY[index]), _mm256_set1_ps(box[3]));
+    
+    __m256 overlap = _mm256_and_ps(_mm256_cmp_ps(left, right, _CMP_LT_OQ), _mm256_cmp_ps(top, bottom, _CMP_LT_OQ));
+    return (unsigned)_mm256_movemask_ps(overlap);
+    
+#elif defined(XGSD_AABB_KERNEL_SSE)
+    __m128 left   = _mm_max_ps(_mm_loadu_ps(&mMinX[index]), _mm_set1_ps(box[0]));
+    __m128 top    = _mm_max_ps(_mm_loadu_ps(&mMinY[index]), _mm_set1_ps(box[1]));
+    __m128 right  = _mm_min_ps(_mm_loadu_ps(&mMaxX[index]), _mm_set1_ps(box[2]));
+    __m128 bottom = _mm_min_ps(_mm_loadu_ps(&mMaxY[index]), _mm_set1_ps(box[3]));
+    
+    __m128 overlap = _mm_and_ps(_mm_cmplt_ps(left, right), _mm_cmplt_ps(top, bottom));
+    return (unsigned)_mm_movemask_ps(overlap);
+    
+#else
+    // Scalar fallback
+    unsigned mask = 0;
+    
+    for (std::size_t i = 0; i < KernelWidth; ++i) {
+        float left   = std::max(mMinX[index + i], box[0]);
+        float top    = std::max(mMinY[index + i], box[1]);
+        float right  = std::min(mMaxX[index + i], box[2]);
+        float bottom = std::min(mMaxY[index + i], box[3]);
+        
+        if (left < right && top < bottom)
+            mask |= 1u << i;
+    }
+    
+    return mask;
+#endif
+}
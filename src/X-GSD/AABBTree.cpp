@@ -0,0 +1,445 @@
+#include <X-GSD/AABBTree.hpp>
+
+#include <algorithm>
+
+using namespace xgsd;
+
+namespace {
+    
+    sf::FloatRect unionOf(const sf::FloatRect& a, const sf::FloatRect& b)
+    {
+        float left = std::min(a.left, b.left);
+        float top = std::min(a.top, b.top);
+        float right = std::max(a.left + a.width, b.left + b.width);
+        float bottom = std::max(a.top + a.height, b.top + b.height);
+        
+        return sf::FloatRect(left, top, right - left, bottom - top);
+    }
+    
+    // The perimeter is used as the cost of a node (the 2D equivalent of the surface area heuristic)
+    float perimeterOf(const sf::FloatRect& rect)
+    {
+        return 2.f * (rect.width + rect.height);
+    }
+    
+    bool contains(const sf::FloatRect& outer, const sf::FloatRect& inner)
+    {
+        return outer.left <= inner.left && outer.top <= inner.top &&
+        inner.left + inner.width <= outer.left + outer.width &&
+        inner.top + inner.height <= outer.top + outer.height;
+    }
+    
+} // anonymous namespace
+
+AABBTree::AABBTree(float margin)
+: mNodes()
+, mRoot(NullNode)
+, mFreeList(NullNode)
+, mProxyCount(0)
+, mMargin(margin)
+{
+    
+}
+
+int AABBTree::insert(const sf::FloatRect& bounds, ComponentCollider* collider)
+{
+    int proxy = allocateNode();
+    
+    // Enlarge the bounds, so that small movements do not need to update the tree
+    mNodes[proxy].bounds = sf::FloatRect(bounds.left - mMargin, bounds.top - mMargin, bounds.width + 2.f * mMargin, bounds.height + 2.f * mMargin);
+    mNodes[proxy].collider = collider;
+    mNodes[proxy].height = 0;
+    
+    insertLeaf(proxy);
+    ++mProxyCount;
+    
+    return proxy;
+}
+
+void AABBTree::remove(int proxy)
+{
+    assert(proxy >= 0 && proxy < (int)mNodes.size() && mNodes[proxy].isLeaf());
+    
+    removeLeaf(proxy);
+    freeNode(proxy);
+    --mProxyCount;
+}
+
+// Updates the bounds of a proxy. The tree is only modified if the new bounds exceed the enlarged ones (returns true in that case)
+bool AABBTree::move(int proxy, const sf::FloatRect& bounds)
+{
+    assert(proxy >= 0 && proxy < (int)mNodes.size() && mNodes[proxy].isLeaf());
+    
+    if (contains(mNodes[proxy].bounds, bounds))
+        return false;
+    
+    removeLeaf(proxy);
+    mNodes[proxy].bounds = sf::FloatRect(bounds.left - mMargin, bounds.top - mMargin, bounds.width + 2.f * mMargin, bounds.height + 2.f * mMargin);
+    insertLeaf(proxy);
+    
+    return true;
+}
+
+// Rebuilds the whole tree from its leaves, splitting them by the median of the longest axis. Proxies keep their ids
+void AABBTree::rebuild()
+{
+    if (mRoot == NullNode)
+        return;
+    
+    std::vector<int> leaves;
+    leaves.reserve(mProxyCount);
+    
+    // Collect the leaves and free the internal nodes
+    for (int i = 0; i < (int)mNodes.size(); ++i) {
+        if (mNodes[i].height < 0)
+            continue;
+        
+        if (mNodes[i].isLeaf()) {
+            mNodes[i].parent = NullNode;
+            leaves.push_back(i);
+        }
+        else {
+            freeNode(i);
+        }
+    }
+    
+    mRoot = buildTopDown(leaves.data(), (int)leaves.size());
+    mNodes[mRoot].parent = NullNode;
+}
+
+void AABBTree::clear()
+{
+    mNodes.clear();
+    mRoot = NullNode;
+    mFreeList = NullNode;
+    mProxyCount = 0;
+}
+
+ComponentCollider* AABBTree::getCollider(int proxy) const
+{
+    assert(proxy >= 0 && proxy < (int)mNodes.size());
+    return mNodes[proxy].collider;
+}
+
+const sf::FloatRect& AABBTree::getFatBounds(int proxy) const
+{
+    assert(proxy >= 0 && proxy < (int)mNodes.size());
+    return mNodes[proxy].bounds;
+}
+
+int AABBTree::getHeight() const
+{
+    return mRoot == NullNode ? 0 : mNodes[mRoot].height;
+}
+
+std::size_t AABBTree::getProxyCount() const
+{
+    return mProxyCount;
+}
+
+int AABBTree::allocateNode()
+{
+    int index;
+    
+    // Reuse a free node if possible, otherwise grow the pool
+    if (mFreeList != NullNode) {
+        index = mFreeList;
+        mFreeList = mNodes[index].parent;
+    }
+    else {
+        index = (int)mNodes.size();
+        mNodes.push_back(Node());
+    }
+    
+    mNodes[index].collider = nullptr;
+    mNodes[index].parent = NullNode;
+    mNodes[index].child1 = NullNode;
+    mNodes[index].child2 = NullNode;
+    mNodes[index].height = 0;
+    
+    return index;
+}
+
+void AABBTree::freeNode(int index)
+{
+    mNodes[index].parent = mFreeList;
+    mNodes[index].height = -1;
+    mFreeList = index;
+}
+
+void AABBTree::insertLeaf(int leaf)
+{
+    if (mRoot == NullNode) {
+        mRoot = leaf;
+        mNodes[mRoot].parent = NullNode;
+        return;
+    }
+    
+    // Find the best sibling for the new leaf, descending to the child with the lowest cost increase
+    sf::FloatRect leafBounds = mNodes[leaf].bounds;
+    int index = mRoot;
+    
+    while (!mNodes[index].isLeaf()) {
+        int child1 = mNodes[index].child1;
+        int child2 = mNodes[index].child2;
+        
+        float perimeter = perimeterOf(mNodes[index].bounds);
+        float combinedPerimeter = perimeterOf(unionOf(mNodes[index].bounds, leafBounds));
+        
+        // Cost of creating a new parent for this node and the new leaf
+        float cost = 2.f * combinedPerimeter;
+        
+        // Minimum cost of pushing the leaf further down the tree
+        float inheritanceCost = 2.f * (combinedPerimeter - perimeter);
+        
+        float cost1 = perimeterOf(unionOf(leafBounds, mNodes[child1].bounds)) + inheritanceCost;
+        if (!mNodes[child1].isLeaf())
+            cost1 -= perimeterOf(mNodes[child1].bounds);
+        
+        float cost2 = perimeterOf(unionOf(leafBounds, mNodes[child2].bounds)) + inheritanceCost;
+        if (!mNodes[child2].isLeaf())
+            cost2 -= perimeterOf(mNodes[child2].bounds);
+        
+        if (cost < cost1 && cost < cost2)
+            break;
+        
+        index = cost1 < cost2 ? child1 : child2;
+    }
+    
+    int sibling = index;
+    
+    // Create a new parent for the sibling and the leaf (allocateNode may reallocate mNodes, so no references are kept)
+    int oldParent = mNodes[sibling].parent;
+    int newParent = allocateNode();
+    mNodes[newParent].parent = oldParent;
+    mNodes[newParent].bounds = unionOf(leafBounds, mNodes[sibling].bounds);
+    mNodes[newParent].height = mNodes[sibling].height + 1;
+    mNodes[newParent].child1 = sibling;
+    mNodes[newParent].child2 = leaf;
+    mNodes[sibling].parent = newParent;
+    mNodes[leaf].parent = newParent;
+    
+    if (oldParent != NullNode) {
+        if (mNodes[oldParent].child1 == sibling)
+            mNodes[oldParent].child1 = newParent;
+        else
+            mNodes[oldParent].child2 = newParent;
+    }
+    else {
+        mRoot = newParent;
+    }
+    
+    // Walk back up the tree fixing heights and bounds
+    index = mNodes[leaf].parent;
+    while (index != NullNode) {
+        index = balance(index);
+        
+        int child1 = mNodes[index].child1;
+        int child2 = mNodes[index].child2;
+        
+        mNodes[index].height = 1 + std::max(mNodes[child1].height, mNodes[child2].height);
+        mNodes[index].bounds = unionOf(mNodes[child1].bounds, mNodes[child2].bounds);
+        
+        index = mNodes[index].parent;
+    }
+}
+
+void AABBTree::removeLeaf(int leaf)
+{
+    if (leaf == mRoot) {
+        mRoot = NullNode;
+        return;
+    }
+    
+    int parent = mNodes[leaf].parent;
+    int grandParent = mNodes[parent].parent;
+    int sibling = mNodes[parent].child1 == leaf ? mNodes[parent].child2 : mNodes[parent].child1;
+    
+    // Replace the parent with the sibling, and free the parent
+    if (grandParent != NullNode) {
+        if (mNodes[grandParent].child1 == parent)
+            mNodes[grandParent].child1 = sibling;
+        else
+            mNodes[grandParent].child2 = sibling;
+        mNodes[sibling].parent = grandParent;
+        freeNode(parent);
+        
+        // Walk back up the tree fixing heights and bounds
+        int index = grandParent;
+        while (index != NullNode) {
+            index = balance(index);
+            
+            int child1 = mNodes[index].child1;
+            int child2 = mNodes[index].child2;
+            
+            mNodes[index].bounds = unionOf(mNodes[child1].bounds, mNodes[child2].bounds);
+            mNodes[index].height = 1 + std::max(mNodes[child1].height, mNodes[child2].height);
+            
+            index = mNodes[index].parent;
+        }
+    }
+    else {
+        mRoot = sibling;
+        mNodes[sibling].parent = NullNode;
+        freeNode(parent);
+    }
+    
+    mNodes[leaf].parent = NullNode;
+}
+
+// Performs a left or right rotation if node A is imbalanced. Returns the new root of the branch
+int AABBTree::balance(int iA)
+{
+    Node& A = mNodes[iA];
+    if (A.isLeaf() || A.height < 2)
+        return iA;
+    
+    int iB = A.child1;
+    int iC = A.child2;
+    Node& B = mNodes[iB];
+    Node& C = mNodes[iC];
+    
+    int balanceFactor = C.height - B.height;
+    
+    // Rotate C up
+    if (balanceFactor > 1) {
+        int iF = C.child1;
+        int iG = C.child2;
+        Node& F = mNodes[iF];
+        Node& G = mNodes[iG];
+        
+        // Swap A and C
+        C.child1 = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+        
+        // A's old parent should point to C
+        if (C.parent != NullNode) {
+            if (mNodes[C.parent].child1 == iA)
+                mNodes[C.parent].child1 = iC;
+            else
+                mNodes[C.parent].child2 = iC;
+        }
+        else {
+            mRoot = iC;
+        }
+        
+        // Rotate
+        if (F.height > G.height) {
+            C.child2 = iF;
+            A.child2 = iG;
+            G.parent = iA;
+            A.bounds = unionOf(B.bounds, G.bounds);
+            C.bounds = unionOf(A.bounds, F.bounds);
+            A.height = 1 + std::max(B.height, G.height);
+            C.height = 1 + std::max(A.height, F.height);
+        }
+        else {
+            C.child2 = iG;
+            A.child2 = iF;
+            F.parent = iA;
+            A.bounds = unionOf(B.bounds, F.bounds);
+            C.bounds = unionOf(A.bounds, G.bounds);
+            A.height = 1 + std::max(B.height, F.height);
+            C.height = 1 + std::max(A.height, G.height);
+        }
+        
+        return iC;
+    }
+    
+    // Rotate B up
+    if (balanceFactor < -1) {
+        int iD = B.child1;
+        int iE = B.child2;
+        Node& D = mNodes[iD];
+        Node& E = mNodes[iE];
+        
+        // Swap A and B
+        B.child1 = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+        
+        // A's old parent should point to B
+        if (B.parent != NullNode) {
+            if (mNodes[B.parent].child1 == iA)
+                mNodes[B.parent].child1 = iB;
+            else
+                mNodes[B.parent].child2 = iB;
+        }
+        else {
+            mRoot = iB;
+        }
+        
+        // Rotate
+        if (D.height > E.height) {
+            B.child2 = iD;
+            A.child1 = iE;
+            E.parent = iA;
+            A.bounds = unionOf(C.bounds, E.bounds);
+            B.bounds = unionOf(A.bounds, D.bounds);
+            A.height = 1 + std::max(C.height, E.height);
+            B.height = 1 + std::max(A.height, D.height);
+        }
+        else {
+            B.child2 = iE;
+            A.child1 = iD;
+            D.parent = iA;
+            A.bounds = unionOf(C.bounds, D.bounds);
+            B.bounds = unionOf(A.bounds, E.bounds);
+            A.height = 1 + std::max(C.height, D.height);
+            B.height = 1 + std::max(A.height, E.height);
+        }
+        
+        return iB;
+    }
+    
+    return iA;
+}
+
+// Recursively builds a branch with the given leaves, splitting them in two halves along the longest axis
+int AABBTree::buildTopDown(int* leaves, int count)
+{
+    if (count == 1)
+        return leaves[0];
+    
+    // Compute the bounds of the centers of the leaves
+    float minX = mNodes[leaves[0]].bounds.left + mNodes[leaves[0]].bounds.width / 2.f;
+    float maxX = minX;
+    float minY = mNodes[leaves[0]].bounds.top + mNodes[leaves[0]].bounds.height / 2.f;
+    float maxY = minY;
+    
+    for (int i = 1; i < count; ++i) {
+        const sf::FloatRect& bounds = mNodes[leaves[i]].bounds;
+        minX = std::min(minX, bounds.left + bounds.width / 2.f);
+        maxX = std::max(maxX, bounds.left + bounds.width / 2.f);
+        minY = std::min(minY, bounds.top + bounds.height / 2.f);
+        maxY = std::max(maxY, bounds.top + bounds.height / 2.f);
+    }
+    
+    // Split at the median of the longest axis
+    bool splitX = (maxX - minX) >= (maxY - minY);
+    int half = count / 2;
+    
+    std::nth_element(leaves, leaves + half, leaves + count, [&] (int a, int b) {
+        const sf::FloatRect& boundsA = mNodes[a].bounds;
+        const sf::FloatRect& boundsB = mNodes[b].bounds;
+        
+        if (splitX)
+            return boundsA.left + boundsA.width / 2.f < boundsB.left + boundsB.width / 2.f;
+        else
+            return boundsA.top + boundsA.height / 2.f < boundsB.top + boundsB.height / 2.f;
+    });
+    
+    int child1 = buildTopDown(leaves, half);
+    int child2 = buildTopDown(leaves + half, count - half);
+    
+    int parent = allocateNode();
+    mNodes[parent].child1 = child1;
+    mNodes[parent].child2 = child2;
+    mNodes[parent].bounds = unionOf(mNodes[child1].bounds, mNodes[child2].bounds);
+    mNodes[parent].height = 1 + std::max(mNodes[child1].height, mNodes[child2].height);
+    mNodes[child1].parent = parent;
+    mNodes[child2].parent = parent;
+    
+    return parent;
+}
@@ -0,0 +1,266 @@
+#include <X-GSD/ArchetypeWorld.hpp>
+
+#include <algorithm>
+
+using namespace xgsd;
+
+const std::size_t ArchetypeWorld::MaxColumnTypes;
+const ArchetypeWorld::EntityId ArchetypeWorld::InvalidEntity;
+
+////// COLUMN //////
+
+ArchetypeWorld::Column::Column(ColumnTypeId typeId)
+: mType(getColumnType(typeId))
+, mData(nullptr)
+, mSize(0)
+, mCapacity(0)
+{
+    
+}
+
+ArchetypeWorld::Column::Column(Column&& other)
+: mType(other.mType)
+, mData(other.mData)
+, mSize(other.mSize)
+, mCapacity(other.mCapacity)
+{
+    other.mData = nullptr;
+    other.mSize = 0;
+    other.mCapacity = 0;
+}
+
+void* ArchetypeWorld::Column::at(std::size_t row)
+{
+    assert(row < mSize || (row == 0 && mSize == 0));
+    return mData + row * mType.size;
+}
+
+void* ArchetypeWorld::Column::pushBack()
+{
+    if (mSize == mCapacity)
+        reserve(std::max<std::size_t>(mCapacity * 2, 16));
+    
+    return mData + mSize++ * mType.size;
+}
+
+void ArchetypeWorld::Column::pushBackMoved(void* value)
+{
+    mType.moveConstruct(pushBack(), value);
+}
+
+// Destroys the value of the row, and moves the last value to its place
+void ArchetypeWorld::Column::swapAndPop(std::size_t row)
+{
+    assert(row < mSize);
+    
+    std::size_t last = --mSize;
+    mType.destroy(mData + row * mType.size);
+    
+    if (row != last) {
+        mType.moveConstruct(mData + row * mType.size, mData + last * mType.size);
+        mType.destroy(mData + last * mType.size);
+    }
+}
+
+void ArchetypeWorld::Column::reserve(std::size_t capacity)
+{
+    // operator new returns memory aligned for any standard type (see the static_assert of getColumnTypeId)
+    unsigned char* data = static_cast<unsigned char*>(::operator new(capacity * mType.size));
+    
+    for (std::size_t i = 0; i < mSize; ++i) {
+        mType.moveConstruct(data + i * mType.size, mData + i * mType.size);
+        mType.destroy(mData + i * mType.size);
+    }
+    
+    ::operator delete(mData);
+    mData = data;
+    mCapacity = capacity;
+}
+
+ArchetypeWorld::Column::~Column()
+{
+    // Cleanup
+    for (std::size_t i = 0; i < mSize; ++i)
+        mType.destroy(mData + i * mType.size);
+    
+    ::operator delete(mData);
+}
+
+////// WORLD //////
+
+ArchetypeWorld::ArchetypeWorld()
+: mEntityCount(0)
+, mIterating(0)
+{
+    // Load resources here (RAII)
+    
+    // Entities without columns live in the empty archetype
+    findOrCreateArchetype(Signature());
+}
+
+ArchetypeWorld::EntityId ArchetypeWorld::create()
+{
+    assert(mIterating == 0);
+    
+    // Reuse a free id if possible
+    EntityId entity;
+    
+    if (mFreeIds.empty()) {
+        entity = (EntityId)mRecords.size();
+        mRecords.push_back({ nullptr, 0 });
+    }
+    else {
+        entity = mFreeIds.back();
+        mFreeIds.pop_back();
+    }
+    
+    Archetype* empty = mArchetypes.front().get();
+    mRecords[entity] = { empty, empty->entities.size() };
+    empty->entities.push_back(entity);
+    ++mEntityCount;
+    
+    return entity;
+}
+
+void ArchetypeWorld::destroy(EntityId entity)
+{
+    assert(isAlive(entity) && mIterating == 0);
+    
+    EntityRecord& record = mRecords[entity];
+    removeRow(record.archetype, record.row);
+    
+    record.archetype = nullptr;
+    mFreeIds.push_back(entity);
+    --mEntityCount;
+}
+
+bool ArchetypeWorld::isAlive(EntityId entity) const
+{
+    return entity < mRecords.size() && mRecords[entity].archetype != nullptr;
+}
+
+// Destroys every entity and removes every system
+void ArchetypeWorld::clear()
+{
+    assert(mIterating == 0);
+    
+    mArchetypes.clear();
+    mArchetypesBySignature.clear();
+    mRecords.clear();
+    mFreeIds.clear();
+    mEntityCount = 0;
+    mSystems.clear();
+    
+    findOrCreateArchetype(Signature());
+}
+
+void ArchetypeWorld::addSystem(System system)
+{
+    mSystems.push_back(std::move(system));
+}
+
+// Runs every system, in the order they were added
+void ArchetypeWorld::update(const HiResDuration& dt)
+{
+    for (std::size_t i = 0; i < mSystems.size(); ++i)
+        mSystems[i](*this, dt);
+}
+
+std::size_t ArchetypeWorld::getEntityCount() const
+{
+    return mEntityCount;
+}
+
+std::size_t ArchetypeWorld::getArchetypeCount() const
+{
+    return mArchetypes.size();
+}
+
+ArchetypeWorld::Archetype* ArchetypeWorld::findOrCreateArchetype(const Signature& signature)
+{
+    auto found = mArchetypesBySignature.find(signature.to_ullong());
+    
+    if (found != mArchetypesBySignature.end())
+        return found->second;
+    
+    std::unique_ptr<Archetype> archetype(new Archetype());
+    archetype->signature = signature;
+    archetype->columnIndices.fill(-1);
+    
+    // Columns in ColumnTypeId order
+    for (std::size_t typeId = 0; typeId < MaxColumnTypes; ++typeId) {
+        if (signature.test(typeId)) {
+            archetype->columnIndices[typeId] = (int)archetype->columns.size();
+            archetype->types.push_back((ColumnTypeId)typeId);
+            archetype->columns.emplace_back((ColumnTypeId)typeId);
+        }
+    }
+    
+    Archetype* created = archetype.get();
+    mArchetypes.push_back(std::move(archetype));
+    mArchetypesBySignature[signature.to_ullong()] = created;
+    
+    return created;
+}
+
+/* Moves the entity to the end of the destination archetype. The values of the column types present in both
+ archetypes are moved, the rest are destroyed. Column types only present in the destination are left to the
+ caller, which must construct them right after. */
+void ArchetypeWorld::moveEntity(EntityId entity, Archetype* destination)
+{
+    EntityRecord& record = mRecords[entity];
+    Archetype* source = record.archetype;
+    std::size_t row = record.row;
+    
+    for (std::size_t i = 0; i < source->types.size(); ++i) {
+        int column = destination->columnIndices[source->types[i]];
+        
+        if (column >= 0)
+            destination->columns[column].pushBackMoved(source->columns[i].at(row));
+    }
+    
+    std::size_t destinationRow = destination->entities.size();
+    destination->entities.push_back(entity);
+    
+    removeRow(source, row);
+    
+    record.archetype = destination;
+    record.row = destinationRow;
+}
+
+// Removes a row keeping the archetype packed: the last entity is moved to its place (swap and pop)
+void ArchetypeWorld::removeRow(Archetype* archetype, std::size_t row)
+{
+    for (auto& column : archetype->columns)
+        column.swapAndPop(row);
+    
+    EntityId last = archetype->entities.back();
+    archetype->entities[row] = last;
+    archetype->entities.pop_back();
+    
+    if (row < archetype->entities.size())
+        mRecords[last].row = row;
+}
+
+ArchetypeWorld::ColumnTypeId ArchetypeWorld::registerColumnType(const ColumnType& type)
+{
+    std::vector<ColumnType>& types = getColumnTypes();
+    
+    assert(types.size() < MaxColumnTypes);
+    types.push_back(type);
+    
+    return (ColumnTypeId)(types.size() - 1);
+}
+
+const ArchetypeWorld::ColumnType& ArchetypeWorld::getColumnType(ColumnTypeId typeId)
+{
+    assert(typeId < getColumnTypes().size());
+    return getColumnTypes()[typeId];
+}
+
+// Column types registered by any world, indexed by ColumnTypeId
+std::vector<ArchetypeWorld::ColumnType>& ArchetypeWorld::getColumnTypes()
+{
+    static std::vector<ColumnType> columnTypes;
+    return columnTypes;
+}
@@ -1,7 +1,22 @@
 #include <X-GSD/Component.hpp>
 
+#include <unordered_map>
+#include <limits>
+#include <cassert>
+
 using namespace xgsd;
 
+// Assigns the TypeIds in order of first use. Called when a component is added to an entity, and once per type by getTypeId<T>
+Component::TypeId Component::getTypeId(const std::type_index& type)
+{
+    static std::unordered_map<std::type_index, TypeId> typeIds;
+    
+    auto inserted = typeIds.insert(std::make_pair(type, (TypeId)typeIds.size()));
+    assert(typeIds.size() <= std::numeric_limits<TypeId>::max());
+    
+    return inserted.first->second;
+}
+
 Component::Component()
 : entity()
 {
@@ -9,6 +24,25 @@ Component::Component()
 }
 
 
+void* Component::operator new(std::size_t size)
+{
+    return PoolAllocator::allocate(size);
+}
+
+// Called with the size of the most derived class, as the destructor is virtual
+void Component::operator delete(void* pointer, std::size_t size)
+{
+    PoolAllocator::deallocate(pointer, size);
+}
+
+
+unsigned Component::getCallbacks() const
+{
+    // Callbacks the entity must call on this component, read once when it is added. Override on derived classes to skip the unused ones (see getOverriddenCallbacks). All of them by default
+    return AllCallbacks;
+}
+
+
 void Component::attachedToEntity()
 {
     // Perform any task needed when the component is attached to a specific entity. Override on derived classes if needed. Does nothing by default
@@ -42,7 +76,7 @@ void Component::onPause(const HiResDuration &dt)
 }
 
 
-void Component::draw(sf::RenderTarget& target, sf::RenderStates states) const
+void Component::draw(RenderCommandList& target, sf::RenderStates states) const
 {
     // Render here. Override this method on derived classes if needed. Does nothing by default
 }
@@ -56,7 +90,22 @@ void Component::handleEvent(const Event& event)
 
 void Component::collisionHandler(xgsd::Entity *theOtherEntity, sf::FloatRect collision)
 {
-    // Handle collisions here. Override this method on derived classes if needed. Does nothing by default
+    // Handle collisions here. Called on every step while the entities overlap. Override this method on derived classes if needed. Does nothing by default
+}
+
+void Component::onCollisionEnter(xgsd::Entity *theOtherEntity, sf::FloatRect collision)
+{
+    // Handle the beginning of a contact here. Called once, on the first step the entities overlap. Override this method on derived classes if needed. Does nothing by default
+}
+
+void Component::onCollisionStay(xgsd::Entity *theOtherEntity, sf::FloatRect collision)
+{
+    // Handle an ongoing contact here. Called on every step the entities keep overlapping after the first one. Override this method on derived classes if needed. Does nothing by default
+}
+
+void Component::onCollisionExit(xgsd::Entity *theOtherEntity)
+{
+    // Handle the end of a contact here. Called once, when the entities stop overlapping or one of them is being destroyed. Override this method on derived classes if needed. Does nothing by default
 }
 
 
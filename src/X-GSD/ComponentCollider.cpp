@@ -5,7 +5,11 @@
 using namespace xgsd;
 
 ComponentCollider::ComponentCollider(sf::FloatRect rectBounds)
-: mRectBounds(rectBounds)
+: mStatic(false)
+, mRegistered(false)
+, mRectBounds(rectBounds)
+, mCategoryBits(0x0001)
+, mMaskBits(0xFFFF)
 {
     // Load resources here (RAII)
     
@@ -20,6 +24,16 @@ ComponentCollider::ComponentCollider(sf::FloatRect rectBounds)
 #endif
 }
 
+unsigned ComponentCollider::getCallbacks() const
+{
+    // The callbacks of the collider only handle its debug rectangle
+#ifdef DEBUG
+    return getOverriddenCallbacks<ComponentCollider>();
+#else
+    return NoCallbacks;
+#endif
+}
+
 void ComponentCollider::onEntityAttach()
 {
     // Check if the entity has a RigidBody component or not to decide the type of collider (static or dynamic)
@@ -31,6 +45,7 @@ void ComponentCollider::onEntityAttach()
         Game::instance().getPhysicsEngine().addStaticCollider(this);
         mStatic = true;
     }
+    mRegistered = true;
     
     // Check if the entity has a Sprite component and mRectBounds has not been set yet
     if (mRectBounds == sf::FloatRect()) {
@@ -44,11 +59,26 @@ void ComponentCollider::onEntityAttach()
     
 #ifdef DEBUG
     mDebugVisible = Game::instance().isDebugRenderingEnabled();
-    mDebugRectangle.setOutlineThickness(1.f/entity->mTransformable.getScale().x);
+    mDebugRectangle.setOutlineThickness(1.f/entity->getTransformable().getScale().x);
 #endif
     
 }
 
+void ComponentCollider::onEntityDetach()
+{
+    // Remove the collider from the PhysicsEngine, notifying the end of its contacts to the other entities
+    if (mRegistered) {
+        Game::instance().getPhysicsEngine().endContacts(this);
+        
+        if (mStatic)
+            Game::instance().getPhysicsEngine().deleteStaticCollider(this);
+        else
+            Game::instance().getPhysicsEngine().deleteDynamicCollider(this);
+        
+        mRegistered = false;
+    }
+}
+
 void ComponentCollider::update(const HiResDuration &dt)
 {
 #ifdef DEBUG
@@ -68,7 +98,7 @@ void ComponentCollider::update(const HiResDuration &dt)
 #endif
 }
 
-void ComponentCollider::draw(sf::RenderTarget& target, sf::RenderStates states) const
+void ComponentCollider::draw(RenderCommandList& target, sf::RenderStates states) const
 {
 #ifdef DEBUG
     if (mDebugVisible)
@@ -82,7 +112,7 @@ void ComponentCollider::handleEvent(const Event &event)
     // TODO: Get control/button binding dynamically
     if (event.type == Event::System && event.systemEvent.key.code == sf::Keyboard::V) {
         mDebugVisible = Game::instance().isDebugRenderingEnabled();
-        mDebugRectangle.setOutlineThickness(1.f/entity->mTransformable.getScale().x);
+        mDebugRectangle.setOutlineThickness(1.f/entity->getTransformable().getScale().x);
     }
 #endif
 }
@@ -108,7 +138,11 @@ void ComponentCollider::collisionHandler(Entity *theOtherEntity, sf::FloatRect c
 void ComponentCollider::setStatic(bool option)
 {
     // If mStatic is equal to option, there is no need to do anything as the Collider is already the desired type
-    if (mStatic != option) {
+    // If it has not been added to the PhysicsEngine yet, it will be added as the right type in onEntityAttach
+    if (mStatic != option && mRegistered) {
+        
+        // End its contacts, they will begin again in the next step with the new type of collider
+        Game::instance().getPhysicsEngine().endContacts(this);
         
         // Swap the collider from one type to the other
         if (option) {
@@ -119,8 +153,10 @@ void ComponentCollider::setStatic(bool option)
             Game::instance().getPhysicsEngine().addDynamicCollider(this);
             Game::instance().getPhysicsEngine().deleteStaticCollider(this);
         }
+        
     }
     
+    mStatic = option;
 }
 
 bool ComponentCollider::isStatic() {
@@ -140,11 +176,43 @@ sf::FloatRect ComponentCollider::getRectBounds()
     return mRectBounds;
 }
 
+void ComponentCollider::setCategoryBits(std::uint16_t categoryBits)
+{
+    mCategoryBits = categoryBits;
+}
+
+std::uint16_t ComponentCollider::getCategoryBits() const
+{
+    return mCategoryBits;
+}
+
+void ComponentCollider::setMaskBits(std::uint16_t maskBits)
+{
+    mMaskBits = maskBits;
+}
+
+std::uint16_t ComponentCollider::getMaskBits() const
+{
+    return mMaskBits;
+}
+
+void ComponentCollider::updateWorldBounds()
+{
+    mWorldBounds = entity->getWorldTransform().transformRect(mRectBounds);
+}
+
+const sf::FloatRect& ComponentCollider::getWorldBounds() const
+{
+    return mWorldBounds;
+}
+
 ComponentCollider::~ComponentCollider()
 {
     // Cleanup
-    if (mStatic)
-        Game::instance().getPhysicsEngine().deleteStaticCollider(this);
-    else
-        Game::instance().getPhysicsEngine().deleteDynamicCollider(this);
+    if (mRegistered) {
+        if (mStatic)
+            Game::instance().getPhysicsEngine().deleteStaticCollider(this);
+        else
+            Game::instance().getPhysicsEngine().deleteDynamicCollider(this);
+    }
 }
@@ -1,18 +1,27 @@
 #include <X-GSD/ComponentRigidBody.hpp>
 
 #include <X-GSD/ComponentCollider.hpp>
-#include <X-GSD/PhysicsEngine.hpp>
+#include <X-GSD/Game.hpp> // Included here to avoid circular reference
 
 using namespace xgsd;
 
 ComponentRigidBody::ComponentRigidBody(bool isKinematic)
 : mKinematic(isKinematic)
 , mPausedPhysics(false)
+, mAttached(false)
+, mStore(Game::instance().getPhysicsEngine().getRigidBodyStore())
+, mBody(mStore.create())
 {
     // Load resources here (RAII)
     
     // Set a default gravity force
-    mPhysics.setForce(sf::Vector2f(0.f, 200)); // TODO: Change this to be done only if an "affectedByGravity" flag is true
+    mStore.setForce(mBody, sf::Vector2f(0.f, 200)); // TODO: Change this to be done only if an "affectedByGravity" flag is true
+}
+
+unsigned ComponentRigidBody::getCallbacks() const
+{
+    // None, the body is integrated by the PhysicsEngine
+    return getOverriddenCallbacks<ComponentRigidBody>();
 }
 
 void ComponentRigidBody::onEntityAttach()
@@ -24,47 +33,84 @@ void ComponentRigidBody::onEntityAttach()
     else {
         DBGMSGC("WARNING: a RigidBody has been attached to " << entity->getName() << " but it has no Collider. This may cause undesired behaviour.");
     }
+    
+    // The body is integrated by the PhysicsEngine while the entity is in the scene
+    mStore.setNode(mBody, entity);
+    mAttached = true;
+    updateSimulated();
 }
 
-void ComponentRigidBody::update(const HiResDuration &dt)
+void ComponentRigidBody::onEntityDetach()
 {
-    // Do not update physics if is kinematic. Its movement will be updated manually elsewhere
-    if (mKinematic || mPausedPhysics)
-        return;
-    
-    // Advance the physics with RK4 integration
-    PhysicsEngine::integrateRK4(mPhysics, mLastPhysicsState, entity->mTransformable, mLastTransformable, dt);
+    mAttached = false;
+    updateSimulated();
+    mStore.setNode(mBody, nullptr);
+}
+
+// Do not update physics if is kinematic. Its movement will be updated manually elsewhere
+void ComponentRigidBody::updateSimulated()
+{
+    mStore.setSimulated(mBody, mAttached && !mKinematic && !mPausedPhysics);
 }
 
 void ComponentRigidBody::returnToLastPhysicsState()
 {
-    mPhysics = mLastPhysicsState;
-    entity->mTransformable = mLastTransformable;
+    mStore.returnToLastState(mBody);
+}
+
+void ComponentRigidBody::setVelocity(sf::Vector2f velocity)
+{
+    mStore.setVelocity(mBody, velocity);
+}
+
+sf::Vector2f ComponentRigidBody::getVelocity() const
+{
+    return mStore.getVelocity(mBody);
 }
 
-PhysicState& ComponentRigidBody::getPhysicsState()
+void ComponentRigidBody::setForce(sf::Vector2f force)
 {
-    return mPhysics;
+    mStore.setForce(mBody, force);
+}
+
+sf::Vector2f ComponentRigidBody::getForce() const
+{
+    return mStore.getForce(mBody);
+}
+
+void ComponentRigidBody::setMass(float mass)
+{
+    mStore.setMass(mBody, mass);
+}
+
+float ComponentRigidBody::getMass() const
+{
+    return mStore.getMass(mBody);
 }
 
 void ComponentRigidBody::pausePhysics()
 {
     if (mKinematic)
         DBGMSGC("Warning: Tried to pause the physics simulation of a kinematic ComponentRigidBody.");
-    else
+    else {
         mPausedPhysics = true;
+        updateSimulated();
+    }
 }
 
 void ComponentRigidBody::resumePhysics()
 {
     if (mKinematic)
         DBGMSGC("Warning: Tried to resume the physics simulation of a kinematic ComponentRigidBody.");
-    else
+    else {
         mPausedPhysics = false;
+        updateSimulated();
+    }
 }
 
 
 ComponentRigidBody::~ComponentRigidBody()
 {
     // Cleanup
+    mStore.destroy(mBody);
 }
\ No newline at end of file
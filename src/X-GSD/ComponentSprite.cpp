@@ -1,26 +1,82 @@
 #include <X-GSD/ComponentSprite.hpp>
 
+#include <X-GSD/ResourceManager.hpp>
+
 using namespace xgsd;
 
+namespace {
+    
+    sf::Vector2u getTextureSize(const sf::Texture& texture)
+    {
+        // Textures packed in an atlas are empty, but their region has their size
+        if (auto region = TextureManager::getAtlasRegion(texture))
+            return sf::Vector2u(region->rect.width, region->rect.height);
+        
+        // Placeholder textures (headless mode) are empty too, but their size is known
+        sf::Vector2u placeholderSize = TextureManager::getPlaceholderSize(texture);
+        
+        return placeholderSize != sf::Vector2u() ? placeholderSize : texture.getSize();
+    }
+    
+} // anonymous namespace
+
 ComponentSprite::ComponentSprite(const sf::Texture& texture)
-: mSprite(texture)
+: ComponentSprite(resolveTexture(texture))
 {
     // Load resources here (RAII)
-    
-    // If this constructor is used and no texture rect is specified it will be as big as the texture    
 }
 
 ComponentSprite::ComponentSprite(const sf::Texture& texture, sf::IntRect textureRect)
-: mSprite(texture)
+: ComponentSprite(resolveTexture(texture, textureRect))
+{
+    // Load resources here (RAII)
+}
+
+ComponentSprite::ComponentSprite(const ResolvedTexture& resolvedTexture)
+: mSprite()
+, mTexture(nullptr)
+, mAtlasOffset()
 {
     // Load resources here (RAII)
     
-    mSprite.setTextureRect(textureRect);
+    applyTexture(resolvedTexture);
+}
+
+// If no texture rect is specified it will be as big as the texture
+ComponentSprite::ResolvedTexture ComponentSprite::resolveTexture(const sf::Texture& texture)
+{
+    sf::Vector2u size = getTextureSize(texture);
+    return resolveTexture(texture, sf::IntRect(0, 0, size.x, size.y));
+}
+
+// Looks up the atlas page of the texture, if it is packed in one
+ComponentSprite::ResolvedTexture ComponentSprite::resolveTexture(const sf::Texture& texture, sf::IntRect textureRect)
+{
+    if (auto region = TextureManager::getAtlasRegion(texture))
+        return ResolvedTexture{ &texture, region->page, sf::Vector2i(region->rect.left, region->rect.top), textureRect };
+    
+    return ResolvedTexture{ &texture, &texture, sf::Vector2i(), textureRect };
+}
+
+// Sets the texture, or its atlas page, with the texture rect relative to the texture
+void ComponentSprite::applyTexture(const ResolvedTexture& resolvedTexture)
+{
+    mTexture = resolvedTexture.texture;
+    mAtlasOffset = resolvedTexture.atlasOffset;
+    mSprite.setTexture(*resolvedTexture.drawnTexture);
+    
+    setTextureRect(resolvedTexture.textureRect);
+}
+
+unsigned ComponentSprite::getCallbacks() const
+{
+    // Only drawn
+    return getOverriddenCallbacks<ComponentSprite>();
 }
 
-void ComponentSprite::draw(sf::RenderTarget& target, sf::RenderStates states) const
+void ComponentSprite::draw(RenderCommandList& target, sf::RenderStates states) const
 {
-    // Just draw the sprite on the render target
+    // Recorded as a sprite command, which is batched with the other sprites of its texture when replayed
     target.draw(mSprite, states);
 }
 
@@ -29,14 +85,15 @@ void ComponentSprite::setColor(sf::Color color)
     mSprite.setColor(color);
 }
 
+// The texture rect is kept
 void ComponentSprite::setTexture(sf::Texture &texture)
 {
-    mSprite.setTexture(texture);
+    applyTexture(resolveTexture(texture, getTextureRect()));
 }
 
 void ComponentSprite::setTextureRect(sf::IntRect textureRect)
 {
-    mSprite.setTextureRect(textureRect);
+    mSprite.setTextureRect(sf::IntRect(textureRect.left + mAtlasOffset.x, textureRect.top + mAtlasOffset.y, textureRect.width, textureRect.height));
 }
 
 sf::FloatRect ComponentSprite::getGlobalBounds()
@@ -51,12 +108,13 @@ sf::Color ComponentSprite::getColor()
 
 const sf::Texture& ComponentSprite::getTexture()
 {
-    return *mSprite.getTexture();
+    return *mTexture;
 }
 
 sf::IntRect ComponentSprite::getTextureRect()
 {
-    return mSprite.getTextureRect();
+    sf::IntRect textureRect = mSprite.getTextureRect();
+    return sf::IntRect(textureRect.left - mAtlasOffset.x, textureRect.top - mAtlasOffset.y, textureRect.width, textureRect.height);
 }
 
 ComponentSprite::~ComponentSprite()
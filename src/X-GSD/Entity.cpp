@@ -1,29 +1,31 @@
 #include <X-GSD/Entity.hpp>
 
+#include <X-GSD/Game.hpp> // Included here to avoid circular reference
+
 using namespace xgsd;
 
-// Static initialization
-std::unordered_map<std::string, Entity*> Entity::entities;
+// Looks for the entity in the current scene
+Entity* Entity::getEntityNamed(const std::string& name)
+{
+    return Game::instance().getSceneManager().getEntityRegistry().getNamed(name);
+}
 
-Entity* Entity::getEntityNamed(std::string name)
+// The entity of the handle in the current scene, or nullptr if it has been destroyed
+Entity* Entity::getEntity(EntityHandle handle)
 {
-    auto found = entities.find(name);
-    if (found != entities.end())
-        return found->second;
-    else
-        return nullptr;
+    return Game::instance().getSceneManager().getEntityRegistry().get(handle);
 }
 
-Entity::Entity(std::string name)
-: mName(name)
+Entity::Entity(const std::string& name)
+: mName(EntityRegistry::internName(name))
+, mRegistry(&Game::instance().getSceneManager().getEntityRegistry())
+, mWorld(nullptr)
+, mWorldEntity(ArchetypeWorld::InvalidEntity)
 {
     // Load resources here (RAII)
     
-    // Insert a reference of the new Entity in a collection of pairs name-entityPointer
-    auto inserted = entities.insert(std::make_pair(name, this));
-    
-    if (inserted.second == false)
-        throw std::runtime_error("Insertion of entity with name [" + name + "] failed.");
+    // Register the entity in the current scene. Throws if the name is already taken
+    mHandle = mRegistry->add(this, mName);
 }
 
 
@@ -35,34 +37,77 @@ void Entity::addComponent(Component::Ptr component)
     // Notify the component that it has been added to an entity
     component->attachedToEntity();
     
-    // Store the component according to its type
-    mComponents[std::type_index(typeid(*component))] = std::move(component);
+    // Store the component in the slot of its type, replacing any previous component of the same type
+    Component::TypeId typeId = Component::getTypeId(std::type_index(typeid(*component)));
+    
+    if (typeId >= mComponentSlots.size())
+        mComponentSlots.resize(typeId + 1, nullptr);
+    
+    Component* previous = mComponentSlots[typeId];
+    mComponentSlots[typeId] = component.get();
+    
+    if (previous) {
+        auto found = std::find_if(mComponents.begin(), mComponents.end(), [previous] (const Component::Ptr& ptr) {
+            return ptr.get() == previous;
+        });
+        *found = std::move(component);
+    }
+    else {
+        mComponents.push_back(std::move(component));
+    }
+    
+    updateCallbackLists();
+}
+
+// Rebuilds the list of components of every callback. Components are rarely added or removed, while callbacks are called every frame
+void Entity::updateCallbackLists()
+{
+    mUpdateComponents.clear();
+    mDrawComponents.clear();
+    mEventComponents.clear();
+    mPauseComponents.clear();
+    mCollisionComponents.clear();
+    
+    for (auto& component : mComponents) {
+        unsigned callbacks = component->getCallbacks();
+        
+        if (callbacks & Component::UpdateCallback)
+            mUpdateComponents.push_back(component.get());
+        if (callbacks & Component::DrawCallback)
+            mDrawComponents.push_back(component.get());
+        if (callbacks & Component::HandleEventCallback)
+            mEventComponents.push_back(component.get());
+        if (callbacks & Component::PauseCallback)
+            mPauseComponents.push_back(component.get());
+        if (callbacks & Component::CollisionCallbacks)
+            mCollisionComponents.push_back(component.get());
+    }
 }
 
 void Entity::onAttachThis()
 {
-    // Perform onEntityAttach call of components/controllers
-    for (auto iter = mComponents.begin(); iter != mComponents.end(); ++iter)
+    // Perform onEntityAttach call of components/controllers. Indices are used in these loops, as the callbacks may add components
+    for (std::size_t i = 0; i < mComponents.size(); ++i)
     {
-        iter->second->onEntityAttach();
+        mComponents[i]->onEntityAttach();
     }
 }
 
 void Entity::onDetachThis()
 {
     // Perform onEntityDetach call of components/controllers
-    for (auto iter = mComponents.begin(); iter != mComponents.end(); ++iter)
+    for (std::size_t i = 0; i < mComponents.size(); ++i)
     {
-        iter->second->onEntityDetach();
+        mComponents[i]->onEntityDetach();
     }
 }
 
 void Entity::updateThis(const HiResDuration& dt)
 {
     // Perform update call of components/controllers
-    for (auto iter = mComponents.begin(); iter != mComponents.end(); ++iter)
+    for (std::size_t i = 0; i < mUpdateComponents.size(); ++i)
     {
-        iter->second->update(dt);
+        mUpdateComponents[i]->update(dt);
     }
 }
 
@@ -70,19 +115,19 @@ void Entity::updateThis(const HiResDuration& dt)
 void Entity::onPauseThis(const HiResDuration& dt)
 {
     // Perform update call of components/controllers
-    for (auto iter = mComponents.begin(); iter != mComponents.end(); ++iter)
+    for (std::size_t i = 0; i < mPauseComponents.size(); ++i)
     {
-        iter->second->onPause(dt);
+        mPauseComponents[i]->onPause(dt);
     }
 }
 
 
-void Entity::drawThis(sf::RenderTarget& target, sf::RenderStates states) const
+void Entity::drawThis(RenderCommandList& target, sf::RenderStates states) const
 {
     // Perform draw call of components/controllers
-    for (auto iter = mComponents.begin(); iter != mComponents.end(); ++iter)
+    for (std::size_t i = 0; i < mDrawComponents.size(); ++i)
     {
-        iter->second->draw(target, states);
+        mDrawComponents[i]->draw(target, states);
     }
 }
 
@@ -90,29 +135,79 @@ void Entity::drawThis(sf::RenderTarget& target, sf::RenderStates states) const
 void Entity::handleEventThis(const Event& event)
 {
     // Perform handleEvent call of components/controllers
-    for (auto iter = mComponents.begin(); iter != mComponents.end(); ++iter)
+    for (std::size_t i = 0; i < mEventComponents.size(); ++i)
     {
-        iter->second->handleEvent(event);
+        mEventComponents[i]->handleEvent(event);
     }
 }
 
 void Entity::collisionHandler(Entity *theOtherEntity, sf::FloatRect collision)
 {
     // Perform collisionHandler call of components/controllers
-    for (auto iter = mComponents.begin(); iter != mComponents.end(); ++iter)
+    for (std::size_t i = 0; i < mCollisionComponents.size(); ++i)
     {
-        iter->second->collisionHandler(theOtherEntity, collision);
+        mCollisionComponents[i]->collisionHandler(theOtherEntity, collision);
     }
 }
 
-std::string Entity::getName()
+void Entity::collisionEnter(Entity *theOtherEntity, sf::FloatRect collision)
 {
-    return mName;
+    // Perform onCollisionEnter call of components/controllers
+    for (std::size_t i = 0; i < mCollisionComponents.size(); ++i)
+    {
+        mCollisionComponents[i]->onCollisionEnter(theOtherEntity, collision);
+    }
+}
+
+void Entity::collisionStay(Entity *theOtherEntity, sf::FloatRect collision)
+{
+    // Perform onCollisionStay call of components/controllers
+    for (std::size_t i = 0; i < mCollisionComponents.size(); ++i)
+    {
+        mCollisionComponents[i]->onCollisionStay(theOtherEntity, collision);
+    }
+}
+
+void Entity::collisionExit(Entity *theOtherEntity)
+{
+    // Perform onCollisionExit call of components/controllers
+    for (std::size_t i = 0; i < mCollisionComponents.size(); ++i)
+    {
+        mCollisionComponents[i]->onCollisionExit(theOtherEntity);
+    }
+}
+
+// Empty if the entity has no name
+const std::string& Entity::getName() const
+{
+    return EntityRegistry::getInternedName(mName);
+}
+
+EntityHandle Entity::getHandle() const
+{
+    return mHandle;
+}
+
+/* Id of this entity in the ArchetypeWorld of the current scene, created on first use. The world entity has
+ an Entity* column pointing back to this entity, and is destroyed with it. */
+ArchetypeWorld::EntityId Entity::getWorldEntity()
+{
+    if (!mWorld) {
+        mWorld = &Game::instance().getSceneManager().getWorld();
+        mWorldEntity = mWorld->create();
+        mWorld->add<Entity*>(mWorldEntity, this);
+    }
+    
+    return mWorldEntity;
 }
 
 Entity::~Entity()
 {
     // Cleanup
     
-    Entity::entities.erase(mName);
+    mRegistry->remove(mHandle);
+    
+    // The world may have been cleared since (e.g. on a scene change), so check that the world entity is still this one's
+    if (mWorld && mWorld->isAlive(mWorldEntity) && mWorld->has<Entity*>(mWorldEntity) && *mWorld->get<Entity*>(mWorldEntity) == this)
+        mWorld->destroy(mWorldEntity);
 }
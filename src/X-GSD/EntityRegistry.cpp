@@ -0,0 +1,167 @@
+#include <X-GSD/EntityRegistry.hpp>
+
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+
+using namespace xgsd;
+
+const EntityRegistry::NameId EntityRegistry::NoName;
+
+namespace {
+    
+    const std::uint32_t NoSlot = 0xFFFFFFFF;
+    
+    // Names interned by any registry. A deque keeps the references to them valid while it grows
+    struct NameTable
+    {
+        std::mutex                                  mutex;
+        std::deque<std::string>                     names; // Indexed by NameId, the first one is the empty name
+        std::unordered_map<std::string, EntityRegistry::NameId> ids;
+        
+        NameTable()
+        : names(1)
+        {
+            
+        }
+    };
+    
+    NameTable& getNameTable()
+    {
+        static NameTable table;
+        return table;
+    }
+    
+} // anonymous namespace
+
+bool xgsd::operator==(const EntityHandle& left, const EntityHandle& right)
+{
+    return left.index == right.index && left.generation == right.generation;
+}
+
+bool xgsd::operator!=(const EntityHandle& left, const EntityHandle& right)
+{
+    return !(left == right);
+}
+
+EntityRegistry::EntityRegistry()
+: mSlots()
+, mFirstFree(NoSlot)
+, mNamedEntities()
+, mEntityCount(0)
+{
+    // Load resources here (RAII)
+}
+
+EntityHandle EntityRegistry::add(Entity* entity, NameId name)
+{
+    assert(entity);
+    
+    if (name != NoName && mNamedEntities.count(name))
+        throw std::runtime_error("Insertion of entity with name [" + getInternedName(name) + "] failed.");
+    
+    // Reuse a free slot if possible
+    std::uint32_t index;
+    
+    if (mFirstFree == NoSlot) {
+        index = (std::uint32_t)mSlots.size();
+        mSlots.push_back({ nullptr, 1, NoSlot, NoName });
+    }
+    else {
+        index = mFirstFree;
+        mFirstFree = mSlots[index].nextFree;
+    }
+    
+    Slot& slot = mSlots[index];
+    slot.entity = entity;
+    slot.name = name;
+    ++mEntityCount;
+    
+    EntityHandle handle;
+    handle.index = index;
+    handle.generation = slot.generation;
+    
+    if (name != NoName)
+        mNamedEntities[name] = handle;
+    
+    return handle;
+}
+
+void EntityRegistry::remove(EntityHandle handle)
+{
+    assert(get(handle) && "Removing an entity which is not in the registry");
+    
+    Slot& slot = mSlots[handle.index];
+    
+    if (slot.name != NoName)
+        mNamedEntities.erase(slot.name);
+    
+    // A new generation invalidates all the handles to the removed entity. Generation 0 is skipped, as it means null
+    if (++slot.generation == 0)
+        slot.generation = 1;
+    
+    slot.entity = nullptr;
+    slot.name = NoName;
+    slot.nextFree = mFirstFree;
+    mFirstFree = handle.index;
+    --mEntityCount;
+}
+
+// The entity of the handle, or nullptr if it has been destroyed (or the handle is null)
+Entity* EntityRegistry::get(EntityHandle handle) const
+{
+    if (handle.index >= mSlots.size() || mSlots[handle.index].generation != handle.generation)
+        return nullptr;
+    
+    return mSlots[handle.index].entity;
+}
+
+Entity* EntityRegistry::getNamed(const std::string& name) const
+{
+    NameTable& table = getNameTable();
+    NameId id;
+    
+    {
+        std::lock_guard<std::mutex> lock(table.mutex);
+        
+        auto found = table.ids.find(name);
+        if (found == table.ids.end())
+            return nullptr;
+        
+        id = found->second;
+    }
+    
+    auto found = mNamedEntities.find(id);
+    return found != mNamedEntities.end() ? get(found->second) : nullptr;
+}
+
+std::size_t EntityRegistry::getEntityCount() const
+{
+    return mEntityCount;
+}
+
+// Returns the NameId of the name, adding it to the table the first time. The empty name is NoName
+EntityRegistry::NameId EntityRegistry::internName(const std::string& name)
+{
+    if (name.empty())
+        return NoName;
+    
+    NameTable& table = getNameTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    
+    auto inserted = table.ids.insert(std::make_pair(name, (NameId)table.names.size()));
+    
+    if (inserted.second)
+        table.names.push_back(name);
+    
+    return inserted.first->second;
+}
+
+const std::string& EntityRegistry::getInternedName(NameId name)
+{
+    NameTable& table = getNameTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    
+    assert(name < table.names.size());
+    return table.names[name];
+}
@@ -3,6 +3,9 @@
 #include <json/json.h>
 
 #include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
 
 using namespace xgsd;
 
@@ -10,11 +13,22 @@ Game Game::globalInstance; // Static initialization of the Game globalInstance
 
 // Constructor
 Game::Game()
-: mVSync(false)
-, mTimeSinceStart(0)
+: mTimeSinceStart(0)
+, mInitialized(false)
+, mWindow(nullptr)
+, mVSync(false)
+, mRenderInterpolation(false)
+, mSpriteBatch()
+, mCommandList()
+, mRenderThread()
+, mHeadless(false)
+, mHeadlessFromCommandLine(false)
+, mHeadlessSteps(0)
+, mHeadlessStepsFromCommandLine(false)
+, mRunning(false)
+, mScene(nullptr)
 {
-    // Load configuration (window properties, first scene to load...)
-    loadConfigurationFromFile();
+    // The configuration is loaded when the game starts running, so that the command line can be parsed first
     
 #ifdef DEBUG
     mDebugRendering = false;
@@ -22,16 +36,48 @@ Game::Game()
     mStatisticsNumFrames = 0;
     mStatisticsNumSimulationSteps = 0;
     mStatisticsUpdateTime = HiResDuration(0);
+    mStatisticsAllocations = PoolAllocator::Statistics();
     
     // Statistics
     mStatisticsText.setPosition(18.f, 18.f);
     mStatisticsText.setCharacterSize(8);
     mStatisticsText.setColor(sf::Color::Green);
-    mStatisticsBackground.setPosition(mStatisticsText.getPosition());
-    mStatisticsBackground.setFillColor(sf::Color(0, 0, 0, 200));
+    mStatisticsBackgroundColor = sf::Color(0, 0, 0, 200);
 #endif
 }
 
+// Command line options override the ones of gameconfig.json. Call it before running the game
+void Game::parseCommandLine(int argc, char* argv[])
+{
+    assert(!mInitialized);
+    
+    for (int i = 1; i < argc; ++i) {
+        
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            mHeadless = true;
+            mHeadlessFromCommandLine = true;
+        }
+        else if (std::strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+            mHeadlessSteps = std::strtoul(argv[++i], nullptr, 10);
+            mHeadlessStepsFromCommandLine = true;
+        }
+        else {
+            DBGMSGC("Unknown command line option " << argv[i] << " - Ignoring it.");
+        }
+    }
+}
+
+// Load the configuration (window properties, first scene to load...) the first time the game runs
+void Game::initialize()
+{
+    if (mInitialized)
+        return;
+    
+    mInitialized = true;
+    loadConfigurationFromFile();
+    mRunning = true;
+}
+
 void Game::loadConfigurationFromFile()
 {
     Json::Value root;   // will contains the root value after parsing
@@ -121,6 +167,101 @@ void Game::loadConfigurationFromFile()
         mouseCursorVisible = keyRepetitionJson.asBool();
     }
     
+    // Get spriteBatching
+    auto spriteBatchingJson = root["spriteBatching"];
+    bool spriteBatching = true;
+    
+    if (!spriteBatchingJson || !spriteBatchingJson.isBool())
+        DBGMSGC("No spriteBatching properly defined on gameconfig.json - Applying default spriteBatching on.");
+    else
+        spriteBatching = spriteBatchingJson.asBool();
+    
+    // Get renderInterpolation
+    auto renderInterpolationJson = root["renderInterpolation"];
+    
+    if (!renderInterpolationJson || !renderInterpolationJson.isBool()) {
+        mRenderInterpolation = false;
+        DBGMSGC("No renderInterpolation properly defined on gameconfig.json - Applying default renderInterpolation off.");
+    }
+    else {
+        mRenderInterpolation = renderInterpolationJson.asBool();
+    }
+    
+    // Get renderThread
+    auto renderThreadJson = root["renderThread"];
+    bool renderThread = false;
+    
+    if (!renderThreadJson || !renderThreadJson.isBool())
+        DBGMSGC("No renderThread properly defined on gameconfig.json - Applying default renderThread off.");
+    else
+        renderThread = renderThreadJson.asBool();
+    
+    // Get headless mode, unless given by the command line
+    auto headlessJson = root["headless"];
+    
+    if (!mHeadlessFromCommandLine) {
+        if (!headlessJson || !headlessJson.isBool())
+            DBGMSGC("No headless properly defined on gameconfig.json - Applying default headless off.");
+        else
+            mHeadless = headlessJson.asBool();
+    }
+    
+    // Get headless steps limit, unless given by the command line
+    auto headlessStepsJson = root["headlessSteps"];
+    
+    if (!mHeadlessStepsFromCommandLine && !headlessStepsJson.isNull()) {
+        if (!headlessStepsJson.isIntegral() || headlessStepsJson.asInt() < 0)
+            DBGMSGC("headlessSteps wrongly defined on gameconfig.json - Applying default headlessSteps 0 (no limit).");
+        else
+            mHeadlessSteps = headlessStepsJson.asUInt();
+    }
+    
+    // Get physics settings
+    auto physicsJson = root["physics"];
+    
+    if (!physicsJson) {
+        DBGMSGC("No physics settings defined on gameconfig.json - Applying default uniformGrid broadphase.");
+    }
+    else {
+        // Get broadphase mode
+        std::string broadphase = physicsJson.get("broadphase", "").asString();
+        
+        if (broadphase == "bruteForce")
+            mPhysicsEngine.setBroadphaseMode(PhysicsEngine::BruteForce);
+        else if (broadphase == "uniformGrid")
+            mPhysicsEngine.setBroadphaseMode(PhysicsEngine::UniformGrid);
+        else if (broadphase == "sweepAndPrune")
+            mPhysicsEngine.setBroadphaseMode(PhysicsEngine::SweepAndPrune);
+        else
+            DBGMSGC("No broadphase properly defined on gameconfig.json - Applying default uniformGrid broadphase.");
+        
+        // Get grid cell size
+        auto gridCellSizeJson = physicsJson["gridCellSize"];
+        
+        if (!gridCellSizeJson || !gridCellSizeJson.isNumeric() || gridCellSizeJson.asFloat() <= 0.f)
+            DBGMSGC("No gridCellSize properly defined on gameconfig.json - Applying default gridCellSize " << mPhysicsEngine.getGridCellSize() << ".");
+        else
+            mPhysicsEngine.setGridCellSize(gridCellSizeJson.asFloat());
+        
+        // Get sweep axis (only used by the sweepAndPrune broadphase)
+        std::string sweepAxis = physicsJson.get("sweepAxis", "x").asString();
+        
+        if (sweepAxis == "x")
+            mPhysicsEngine.setSweepAxis(PhysicsEngine::AxisX);
+        else if (sweepAxis == "y")
+            mPhysicsEngine.setSweepAxis(PhysicsEngine::AxisY);
+        else
+            DBGMSGC("No sweepAxis properly defined on gameconfig.json - Applying default sweepAxis x.");
+        
+        // Get collision detection threads (0 uses one thread per hardware core)
+        auto threadsJson = physicsJson["threads"];
+        
+        if (!threadsJson || !threadsJson.isIntegral() || threadsJson.asInt() < 0)
+            DBGMSGC("No threads properly defined on gameconfig.json - Applying default threads " << mPhysicsEngine.getThreadCount() << ".");
+        else
+            mPhysicsEngine.setThreadCount(threadsJson.asUInt());
+    }
+    
 #ifdef DEBUG
     // Get debug font
     std::string debugFontPath = root.get("debugFont", "").asString();
@@ -137,6 +278,18 @@ void Game::loadConfigurationFromFile()
     if (initialScene == "")
         throw std::runtime_error("Game::loadConfigurationFromFile - Failed to load " + resourcePath() + jsonPath + "  - No 'initialScene' found");
     
+    // Without a window there is no graphics context: textures are only placeholders with the size of their images
+    if (mHeadless) {
+        DBGMSGC("Running in headless mode" << (mHeadlessSteps > 0 ? " for " + std::to_string(mHeadlessSteps) + " steps" : "") << ".");
+        
+        mView = sf::View(sf::FloatRect(0.f, 0.f, windowSize.x, windowSize.y));
+        mTextureManager.setPlaceholderMode(true);
+        
+        mScene = new Scene(nullptr, mView);
+        mScene->loadSceneFromFile(initialScene);
+        return;
+    }
+    
     // Create the window with the loaded preferences
     mWindow = new sf::RenderWindow(sf::VideoMode(windowSize.x, windowSize.y), windowName, fullscreen ? sf::Style::Fullscreen : sf::Style::Close);
     
@@ -154,15 +307,50 @@ void Game::loadConfigurationFromFile()
     mWindow->setKeyRepeatEnabled(keyRepetition);
     mWindow->setMouseCursorVisible(mouseCursorVisible);
     
-    sf::View view = mWindow->getView();
-    view.setViewport(sf::FloatRect(0.f, 0.f, 1.f, 1.f));
-    mWindow->setView(view);
+    mView = mWindow->getView();
+    mView.setViewport(sf::FloatRect(0.f, 0.f, 1.f, 1.f));
+    mWindow->setView(mView);
     
     // Create the scene with that window
-    mScene = new Scene(*mWindow);
+    mScene = new Scene(mWindow, mView);
+    mSpriteBatch.setEnabled(spriteBatching);
     
     // And finally, load the initial scene
     mScene->loadSceneFromFile(initialScene);
+    
+    // From now on the window is drawn by its own thread, if enabled
+    if (renderThread)
+        mRenderThread.reset(new RenderThread(*mWindow, mSpriteBatch));
+}
+
+// Size of the view of the window, or of the view it would have in headless mode
+sf::Vector2f Game::getViewSize()
+{
+    return mWindow ? mWindow->getView().getSize() : mView.getSize();
+}
+
+// Waits until the render thread, if any, has finished the frames which may use the current resources
+void Game::synchronizeRendering()
+{
+    if (mRenderThread)
+        mRenderThread->synchronize();
+}
+
+// Stop running the game (closes the window, if any)
+void Game::quit()
+{
+    // The render thread must stop using the window before it is closed
+    mRenderThread.reset();
+    
+    if (mWindow)
+        mWindow->close();
+    
+    mRunning = false;
+}
+
+bool Game::isRunning()
+{
+    return mWindow ? mWindow->isOpen() : mRunning;
 }
 
 void Game::update(const xgsd::HiResDuration& dt)
@@ -192,7 +380,7 @@ void Game::update(const xgsd::HiResDuration& dt)
     
 }
 
-void Game::render()
+void Game::render(float interpolation)
 {
     // Draw calls here
     
@@ -207,22 +395,34 @@ void Game::render()
      
      NOTE:
      The recommended approach is to ask the Scene to render
-     itself, which will invoke the current scene's render method.
+     itself, which will invoke the current scene's render method
+     to record its draws on a RenderCommandList.
      This is the default implementation:
      */
     
-    mWindow->clear(); // Clear the window before drawing the new frame
-    mScene->render();
+    // Record the frame on the list of the render thread, or on our own if there is none
+    RenderCommandList& commands = mRenderThread ? mRenderThread->getCommandList() : mCommandList;
+    commands.clear();
+    
+    mScene->render(commands, interpolation);
     
 #ifdef DEBUG
     // Statistics will only be rendered if the flag is true and DEBUG mode
     if(mEnableStatistics) {
-        mWindow->draw(mStatisticsBackground);
-        mWindow->draw(mStatisticsText);
+        // The background is sized to the text by the replay, which is the only one using its font
+        commands.drawText(mStatisticsText, sf::Vector2f(0.f, 0.f), mStatisticsBackgroundColor);
     }
     mStatisticsNumFrames++;
 #endif
     
+    // The render thread draws it while the next frame is simulated
+    if (mRenderThread) {
+        mRenderThread->submit();
+        return;
+    }
+    
+    mWindow->clear(); // Clear the window before drawing the new frame
+    commands.replay(*mWindow, mSpriteBatch);
     mWindow->display();
 }
 
@@ -241,7 +441,7 @@ void Game::handleEvents()
         {
                 // window closed
             case sf::Event::Closed:
-                mWindow->close();
+                quit();
                 break;
                 
                 // key pressed
@@ -256,7 +456,11 @@ void Game::handleEvents()
                 // Toggle vSync
                 if (mEvent.key.code == sf::Keyboard::B) {
                     mVSync = !mVSync;
-                    mWindow->setVerticalSyncEnabled(mVSync);
+                    
+                    if (mRenderThread)
+                        mRenderThread->setVerticalSyncEnabled(mVSync);
+                    else
+                        mWindow->setVerticalSyncEnabled(mVSync);
                 }
                 
                 // Print total running time on console
@@ -302,19 +506,28 @@ void Game::updateStatistics(const xgsd::HiResDuration& elapsedTime)
     
     if (mStatisticsUpdateTime >= ONE_SECOND)
     {
+        // Allocations of entities, components and their containers. Steady gameplay should not need the heap
+        PoolAllocator::Statistics allocations = PoolAllocator::getStatistics();
+        
+        // Sprites merged by the sprite batch, and the draw calls it took
+        SpriteBatch& spriteBatch = mSpriteBatch;
+        std::size_t frames = std::max<std::size_t>(mStatisticsNumFrames, 1);
+        
         mStatisticsText.setString(
                                   "Frames / Second       = " + std::to_string(mStatisticsNumFrames) + " (" + std::to_string((float)mStatisticsUpdateTime.count()/mStatisticsNumFrames/1000000) + " ms per frame)\n" +
                                   "Simulations / Second  = " + std::to_string(mStatisticsNumSimulationSteps) + " (" + std::to_string((float)mStatisticsUpdateTime.count()/mStatisticsNumSimulationSteps/1000000) + " ms per simulation)\n" +
                                   "Simulations / Frame   = " + std::to_string((float)mStatisticsNumSimulationSteps / mStatisticsNumFrames) + "\n" +
+                                  "Sprites / Frame       = " + std::to_string(spriteBatch.getSpriteCount() / frames) + " (" + std::to_string(spriteBatch.getDrawCallCount() / frames) + " batched draw calls)\n" +
+                                  "Allocations / Second  = " + std::to_string(allocations.allocations - mStatisticsAllocations.allocations) + " (" + std::to_string(allocations.slabAllocations - mStatisticsAllocations.slabAllocations) + " pool slabs)\n" +
+                                  "Pooled memory         = " + std::to_string(allocations.reservedBytes / 1024) + " KB\n" +
                                   "Vertical Sync enabled = " + (mVSync ? "Yes" : "No"));
         
+        mStatisticsAllocations = allocations;
+        spriteBatch.resetStatistics();
         mStatisticsUpdateTime -= ONE_SECOND;
         mStatisticsNumFrames = 0;
         mStatisticsNumSimulationSteps = 0;
     }
-    
-    mStatisticsBackground.setSize(sf::Vector2f(mStatisticsText.getLocalBounds().width, mStatisticsText.getLocalBounds().height));
-    
 }
 #endif
 
@@ -345,12 +558,19 @@ void Game::runFixedDeltaTime(int simulationFrequency)
 {
     HiResDuration simulationFixedDuration(ONE_SECOND/simulationFrequency); // Simulation step
     
+    initialize();
+    
+    if (mHeadless) {
+        runHeadless(simulationFixedDuration);
+        return;
+    }
+    
     HiResDuration lastRenderDuration; // Frame time (update + handleEvents + render times = 1 loop iteration time)
     
     HiResTime lastTimeMeasure = HiResClock::now();
     HiResTime newTimeMeasure;
     
-    while (mWindow->isOpen())
+    while (isRunning())
     {
         newTimeMeasure = HiResClock::now();
         lastRenderDuration = newTimeMeasure - lastTimeMeasure;
@@ -385,12 +605,20 @@ void Game::runFixedDeltaTime(int simulationFrequency)
 
 void Game::runVariableDeltaTime()
 {
+    initialize();
+    
+    // Without frames, there is no frame time to use as step: use a fixed 60 Hz step
+    if (mHeadless) {
+        runHeadless(ONE_SECOND/60);
+        return;
+    }
+    
     HiResDuration lastRenderDuration(0); // FrameTime (aka dt)
     
     HiResTime lastTimeMeasure = HiResClock::now();
     HiResTime newTimeMeasure;
     
-    while (mWindow->isOpen())
+    while (isRunning())
     {
         newTimeMeasure = HiResClock::now();
         lastRenderDuration = newTimeMeasure - lastTimeMeasure;
@@ -440,6 +668,13 @@ void Game::runSemiFixedDeltaTime(int minSimulationFrequency, int stepLimit)
     
     HiResDuration simulationFixedDuration(ONE_SECOND/minSimulationFrequency); // Simulation step time (aka dt)
     
+    initialize();
+    
+    if (mHeadless) {
+        runHeadless(simulationFixedDuration);
+        return;
+    }
+    
     const short multipleStepLimit = stepLimit; // Limit of steps to consume the frameTime. Needed to avoid the spiral of death effect. Tuning is recommended
     short multipleStepCounter = 0;
     
@@ -449,7 +684,7 @@ void Game::runSemiFixedDeltaTime(int minSimulationFrequency, int stepLimit)
     HiResTime lastTimeMeasure = HiResClock::now();
     HiResTime newTimeMeasure;
     
-    while (mWindow->isOpen())
+    while (isRunning())
     {
         newTimeMeasure = HiResClock::now();
         lastRenderDuration = newTimeMeasure - lastTimeMeasure;
@@ -488,7 +723,7 @@ void Game::runSemiFixedDeltaTime(int minSimulationFrequency, int stepLimit)
  * where the Renderer produces (the time it takes to render) and the Simulation consumes that time
  * in fixed dt chunks.
  * If the Simulation frequency is not divisible by Rendering FPS, a tiny temporal aliasing can appear.
- * To solve it, enable VSync and set simulationFixedDuration to the display Hz, or implement interpolation.
+ * To solve it, enable VSync and set simulationFixedDuration to the display Hz, or enable renderInterpolation.
  *
  * Examples:
  * - 60 fps and 60 Hz of simulation would require 1 simulation per frame (no temporal aliasing).
@@ -498,6 +733,11 @@ void Game::runSemiFixedDeltaTime(int minSimulationFrequency, int stepLimit)
  * - 50 fps and 60 Hz of simulation would require 1.2 simulations per frame. Same as before.
  *
  *
+ * With renderInterpolation on gameconfig.json, the render time left in the accumulator is not wasted: each
+ * frame draws the nodes between their transforms of the last two simulations, at alpha = accumulator / dt.
+ * This removes the temporal aliasing at any framerate, so the simulation can run at a low rate (e.g. 30 Hz)
+ * and still be rendered smoothly, at the cost of showing it one simulation behind.
+ *
  * Uses: General, deterministic simulations (different runs with the same result), network-related games
  * Needs high resolution time compatibility (hardware/OS)
  */
@@ -507,12 +747,19 @@ void Game::runFixedSimulationVariableFramerate(int simulationFrequency)
     HiResDuration accumulatedRenderTime(0); // Accumulator of render time to be consumed by simulations
     HiResDuration simulationFixedDuration(ONE_SECOND/simulationFrequency); // This determines the Simulation frequency (in Hz)
     
+    initialize();
+    
+    if (mHeadless) {
+        runHeadless(simulationFixedDuration);
+        return;
+    }
+    
     HiResDuration lastRenderDuration; // FrameTime
     
     HiResTime lastTimeMeasure = HiResClock::now();
     HiResTime newTimeMeasure;
     
-    while (mWindow->isOpen())
+    while (isRunning())
     {
         newTimeMeasure = HiResClock::now();
         lastRenderDuration = newTimeMeasure - lastTimeMeasure;
@@ -535,6 +782,47 @@ void Game::runFixedSimulationVariableFramerate(int simulationFrequency)
         updateStatistics(lastRenderDuration);
 #endif
         
-        render();
+        if (mRenderInterpolation)
+            render((float)accumulatedRenderTime.count() / simulationFixedDuration.count());
+        else
+            render();
     }
 }
+
+
+
+/* ------------------
+ * Headless Timestep
+ * ------------------
+ *
+ * Advances the simulation in fixed dt steps as fast as the CPU allows, without handling events nor
+ * rendering. Used by all the run methods in headless mode, so that the simulation steps are the same
+ * with or without a window.
+ *
+ * Uses: Soak tests, benchmarks, server-side simulation
+ */
+
+void Game::runHeadless(const HiResDuration& simulationFixedDuration)
+{
+    std::size_t steps = 0;
+
+#ifdef DEBUG
+    HiResTime startTime = HiResClock::now();
+    PoolAllocator::Statistics startAllocations = PoolAllocator::getStatistics();
+#endif
+    
+    while (isRunning() && (mHeadlessSteps == 0 || steps < mHeadlessSteps))
+    {
+        update(simulationFixedDuration);
+        mTimeSinceStart += simulationFixedDuration;
+        ++steps;
+    }
+
+#ifdef DEBUG
+    double elapsedMilliseconds = (double)(HiResClock::now() - startTime).count()/1000000;
+    DBGMSGC("Headless run finished: " << steps << " steps in " << elapsedMilliseconds << " ms (" << (steps > 0 ? elapsedMilliseconds/steps : 0.) << " ms per step)");
+    
+    PoolAllocator::Statistics allocations = PoolAllocator::getStatistics();
+    DBGMSGC("Pooled allocations: " << allocations.allocations - startAllocations.allocations << " (" << allocations.slabAllocations - startAllocations.slabAllocations << " pool slabs, " << allocations.reservedBytes / 1024 << " KB pooled)");
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,378 @@
+#include <X-GSD/JsonReader.hpp>
+
+#include <cstdlib>
+#include <cstring>
+
+using namespace xgsd;
+
+namespace {
+    
+    // Thrown on syntax errors, caught by parse. The message is already in mError
+    struct ParseError
+    {
+    };
+    
+    bool isDigit(char character)
+    {
+        return character >= '0' && character <= '9';
+    }
+    
+} // anonymous namespace
+
+const std::size_t JsonReader::MaxDepth;
+
+JsonReader::JsonReader()
+: mBegin(nullptr)
+, mEnd(nullptr)
+, mCurrent(nullptr)
+, mHandler(nullptr)
+, mKey()
+, mString()
+, mError()
+{
+    // Load resources here (RAII)
+}
+
+/* Parses a whole document, calling the handler for each value. Returns false on syntax errors (see
+ getFormattedErrorMessages); the handler may have been called for the values before the error. */
+bool JsonReader::parse(const char* begin, const char* end, Handler& handler)
+{
+    mBegin = begin;
+    mEnd = end;
+    mCurrent = begin;
+    mHandler = &handler;
+    mError.clear();
+    
+    try {
+        skipWhitespace();
+        parseValue(0);
+        skipWhitespace();
+        
+        if (mCurrent != mEnd)
+            fail("Extra characters after the value", mCurrent);
+    }
+    catch (ParseError&) {
+        return false;
+    }
+    
+    return true;
+}
+
+// Same format as Json::Reader, so that errors read the same with both
+std::string JsonReader::getFormattedErrorMessages() const
+{
+    return mError;
+}
+
+void JsonReader::parseValue(std::size_t depth)
+{
+    if (mCurrent == mEnd)
+        fail("Syntax error: value, object or array expected.", mCurrent);
+    
+    switch (*mCurrent) {
+        case '{':
+            parseObject(depth + 1);
+            break;
+        case '[':
+            parseArray(depth + 1);
+            break;
+        case '"':
+            parseString(mString);
+            mHandler->stringValue(mString);
+            break;
+        case 't':
+            parseLiteral("true");
+            mHandler->boolValue(true);
+            break;
+        case 'f':
+            parseLiteral("false");
+            mHandler->boolValue(false);
+            break;
+        case 'n':
+            parseLiteral("null");
+            mHandler->nullValue();
+            break;
+        default:
+            parseNumber();
+            break;
+    }
+}
+
+void JsonReader::parseObject(std::size_t depth)
+{
+    if (depth > MaxDepth)
+        fail("Too many nested objects and arrays", mCurrent);
+    
+    ++mCurrent; // '{'
+    mHandler->beginObject();
+    
+    skipWhitespace();
+    if (consume('}')) {
+        mHandler->endObject();
+        return;
+    }
+    
+    while (true) {
+        skipWhitespace();
+        if (mCurrent == mEnd || *mCurrent != '"')
+            fail("Missing '}' or object member name", mCurrent);
+        
+        parseString(mKey);
+        mHandler->key(mKey);
+        
+        skipWhitespace();
+        expect(':', "Missing ':' after object member name");
+        skipWhitespace();
+        parseValue(depth);
+        skipWhitespace();
+        
+        if (consume('}'))
+            break;
+        
+        expect(',', "Missing ',' or '}' in object declaration");
+    }
+    
+    mHandler->endObject();
+}
+
+void JsonReader::parseArray(std::size_t depth)
+{
+    if (depth > MaxDepth)
+        fail("Too many nested objects and arrays", mCurrent);
+    
+    ++mCurrent; // '['
+    mHandler->beginArray();
+    
+    skipWhitespace();
+    if (consume(']')) {
+        mHandler->endArray();
+        return;
+    }
+    
+    while (true) {
+        skipWhitespace();
+        parseValue(depth);
+        skipWhitespace();
+        
+        if (consume(']'))
+            break;
+        
+        expect(',', "Missing ',' or ']' in array declaration");
+    }
+    
+    mHandler->endArray();
+}
+
+void JsonReader::parseString(std::string& string)
+{
+    const char* start = mCurrent;
+    ++mCurrent; // '"'
+    string.clear();
+    
+    while (true) {
+        // Copy the plain characters at once
+        const char* plain = mCurrent;
+        while (mCurrent != mEnd && *mCurrent != '"' && *mCurrent != '\\')
+            ++mCurrent;
+        string.append(plain, mCurrent);
+        
+        if (mCurrent == mEnd)
+            fail("Missing '\"', end of string expected", start);
+        
+        if (*mCurrent++ == '"')
+            return;
+        
+        if (mCurrent == mEnd)
+            fail("Empty escape sequence in string", mCurrent);
+        
+        switch (*mCurrent++) {
+            case '"':   string += '"'; break;
+            case '/':   string += '/'; break;
+            case '\\':  string += '\\'; break;
+            case 'b':   string += '\b'; break;
+            case 'f':   string += '\f'; break;
+            case 'n':   string += '\n'; break;
+            case 'r':   string += '\r'; break;
+            case 't':   string += '\t'; break;
+            case 'u': {
+                unsigned long codePoint = parseHex4();
+                
+                // Surrogate pairs, for characters beyond the basic plane
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                    if (mEnd - mCurrent < 2 || mCurrent[0] != '\\' || mCurrent[1] != 'u')
+                        fail("Additional six characters expected to parse unicode surrogate pair.", mCurrent);
+                    
+                    mCurrent += 2;
+                    unsigned long low = parseHex4();
+                    if (low < 0xDC00 || low > 0xDFFF)
+                        fail("Bad unicode escape sequence in string: expecting another \\u token to begin the second half of a unicode surrogate pair", mCurrent);
+                    
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                }
+                
+                appendCodePoint(string, codePoint);
+                break;
+            }
+            default:
+                fail("Bad escape sequence in string", mCurrent - 1);
+        }
+    }
+}
+
+void JsonReader::parseNumber()
+{
+    const char* start = mCurrent;
+    
+    if (mCurrent != mEnd && *mCurrent == '-')
+        ++mCurrent;
+    
+    if (mCurrent == mEnd || !isDigit(*mCurrent))
+        fail("Syntax error: value, object or array expected.", start);
+    
+    while (mCurrent != mEnd && isDigit(*mCurrent))
+        ++mCurrent;
+    
+    if (mCurrent != mEnd && *mCurrent == '.') {
+        ++mCurrent;
+        while (mCurrent != mEnd && isDigit(*mCurrent))
+            ++mCurrent;
+    }
+    
+    if (mCurrent != mEnd && (*mCurrent == 'e' || *mCurrent == 'E')) {
+        ++mCurrent;
+        if (mCurrent != mEnd && (*mCurrent == '+' || *mCurrent == '-'))
+            ++mCurrent;
+        while (mCurrent != mEnd && isDigit(*mCurrent))
+            ++mCurrent;
+    }
+    
+    // strtod needs a terminated string, and numbers are short
+    char buffer[64];
+    std::size_t length = mCurrent - start;
+    
+    if (length >= sizeof(buffer))
+        fail("Number too long", start);
+    
+    std::memcpy(buffer, start, length);
+    buffer[length] = '\0';
+    
+    mHandler->numberValue(std::strtod(buffer, nullptr));
+}
+
+void JsonReader::parseLiteral(const char* literal)
+{
+    std::size_t length = std::strlen(literal);
+    
+    if ((std::size_t)(mEnd - mCurrent) < length || std::strncmp(mCurrent, literal, length) != 0)
+        fail("Syntax error: value, object or array expected.", mCurrent);
+    
+    mCurrent += length;
+}
+
+// UTF-8, as Json::Reader stores strings
+void JsonReader::appendCodePoint(std::string& string, unsigned long codePoint)
+{
+    if (codePoint < 0x80)
+        string += (char)codePoint;
+    else if (codePoint < 0x800) {
+        string += (char)(0xC0 | (codePoint >> 6));
+        string += (char)(0x80 | (codePoint & 0x3F));
+    }
+    else if (codePoint < 0x10000) {
+        string += (char)(0xE0 | (codePoint >> 12));
+        string += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+        string += (char)(0x80 | (codePoint & 0x3F));
+    }
+    else {
+        string += (char)(0xF0 | (codePoint >> 18));
+        string += (char)(0x80 | ((codePoint >> 12) & 0x3F));
+        string += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+        string += (char)(0x80 | (codePoint & 0x3F));
+    }
+}
+
+unsigned long JsonReader::parseHex4()
+{
+    if (mEnd - mCurrent < 4)
+        fail("Bad unicode escape sequence in string: four digits expected.", mCurrent);
+    
+    unsigned long value = 0;
+    
+    for (int i = 0; i < 4; ++i) {
+        char digit = *mCurrent++;
+        value <<= 4;
+        
+        if (digit >= '0' && digit <= '9')
+            value += digit - '0';
+        else if (digit >= 'a' && digit <= 'f')
+            value += digit - 'a' + 10;
+        else if (digit >= 'A' && digit <= 'F')
+            value += digit - 'A' + 10;
+        else
+            fail("Bad unicode escape sequence in string: hexadecimal digit expected.", mCurrent - 1);
+    }
+    
+    return value;
+}
+
+// Whitespace and comments
+void JsonReader::skipWhitespace()
+{
+    while (mCurrent != mEnd) {
+        char character = *mCurrent;
+        
+        if (character == ' ' || character == '\t' || character == '\n' || character == '\r') {
+            ++mCurrent;
+        }
+        else if (character == '/' && mEnd - mCurrent >= 2 && mCurrent[1] == '/') {
+            while (mCurrent != mEnd && *mCurrent != '\n')
+                ++mCurrent;
+        }
+        else if (character == '/' && mEnd - mCurrent >= 2 && mCurrent[1] == '*') {
+            const char* start = mCurrent;
+            mCurrent += 2;
+            
+            while (mEnd - mCurrent >= 2 && !(mCurrent[0] == '*' && mCurrent[1] == '/'))
+                ++mCurrent;
+            
+            if (mEnd - mCurrent < 2)
+                fail("Missing '*/' at the end of the comment", start);
+            
+            mCurrent += 2;
+        }
+        else
+            return;
+    }
+}
+
+bool JsonReader::consume(char character)
+{
+    if (mCurrent == mEnd || *mCurrent != character)
+        return false;
+    
+    ++mCurrent;
+    return true;
+}
+
+void JsonReader::expect(char character, const char* message)
+{
+    if (!consume(character))
+        fail(message, mCurrent);
+}
+
+void JsonReader::fail(const char* message, const char* at)
+{
+    // Lines and columns start at 1
+    int line = 1;
+    const char* lineStart = mBegin;
+    
+    for (const char* current = mBegin; current < at; ++current) {
+        if (*current == '\n') {
+            ++line;
+            lineStart = current + 1;
+        }
+    }
+    
+    mError = "* Line " + std::to_string(line) + ", Column " + std::to_string(at - lineStart + 1) + "\n  " + message + "\n";
+    throw ParseError();
+}
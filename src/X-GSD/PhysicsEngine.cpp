@@ -2,73 +2,608 @@
 
 #include <SFML/Graphics/Rect.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 using namespace xgsd;
 
-// Very basic collision detection algorithm based on axis-aligned bounding boxes intersection
+namespace {
+    
+    // Colliders covering more cells than this are not inserted in the uniform grid, but tested against all the others
+    const int MaxGridCellsPerCollider = 64;
+    
+    /* Items taken at once by each thread during the pair generation. Small enough to balance the load (the
+     brute force loop tests fewer pairs for the last colliders), big enough to keep the threads busy */
+    const std::size_t CollidersPerTask = 16;
+    const std::size_t GridCellsPerTask = 32;
+    
+    std::uint64_t gridCellKey(int x, int y)
+    {
+        return ((std::uint64_t)(std::uint32_t)x << 32) | (std::uint32_t)y;
+    }
+    
+    int gridCoordinate(float value, float cellSize)
+    {
+        return (int)std::floor(value / cellSize);
+    }
+    
+} // anonymous namespace
+
+const int PhysicsEngine::NoSweepProxy;
+
+PhysicsEngine::PhysicsEngine()
+: mBroadphaseMode(UniformGrid)
+, mDispatching(false)
+, mThreadPool(1)
+, mGridCellSize(64.f)
+, mSweepAxis(AxisX)
+, mStaticCategoryBits(0)
+{
+    
+}
+
+// Advance the physics state of every ComponentRigidBody
+void PhysicsEngine::integrate(const HiResDuration& dt)
+{
+    mRigidBodies.integrate(dt);
+}
+
+// Collision detection based on axis-aligned bounding boxes intersection
 void PhysicsEngine::checkCollisions() {
     
-    // Check between dynamic colliders first (entities which have a collider and a rigidBody)
-    for (auto iterD = dynamicColliders.begin(); iterD != dynamicColliders.end(); ++iterD) {
+    // Transform the bounds of every collider to world coordinates only once per step
+    updateWorldBounds();
+    
+    // Parallel phase: every thread writes the pairs it finds to its own buffer
+    mWorkerBuffers.resize(mThreadPool.getThreadCount());
+    
+    for (auto& buffers : mWorkerBuffers)
+        buffers.pairs.clear();
+    
+    switch (mBroadphaseMode) {
+        case BruteForce:
+            findPairsBruteForce();
+            break;
+            
+        case UniformGrid:
+            findPairsUniformGrid();
+            break;
+        
+        case SweepAndPrune:
+            findPairsSweepAndPrune();
+            break;
+    }
+    
+    // Serial phase: the callbacks are called on this thread, in an order which does not depend on the threads
+    gatherPairs();
+    dispatchPairs();
+}
+
+// Not parallel: getWorldTransform updates the cache of the nodes
+void PhysicsEngine::updateWorldBounds()
+{
+    mActiveDynamicColliders.clear();
+    
+    // Colliders filtered out of every pair are skipped: their world bounds are never used
+    for (auto& dynamicCollider : dynamicColliders) {
+        if (!dynamicCollider.first->canCollide())
+            continue;
+        
+        dynamicCollider.first->updateWorldBounds();
         
-        // If the entity containing this collider is pending of destruction, skip it
-        if ((*iterD)->entity->isDestroyPending())
+        // If the entity containing a collider is pending of destruction, it is not tested either
+        if (!dynamicCollider.first->entity->isDestroyPending())
+            mActiveDynamicColliders.push_back(dynamicCollider.first);
+    }
+    
+    // Static colliders rarely move, so their proxies in the tree are usually left untouched
+    mStaticCategoryBits = 0;
+    
+    for (auto& staticCollider : staticColliders) {
+        if (!staticCollider.first->canCollide())
             continue;
         
+        staticCollider.first->updateWorldBounds();
+        mStaticTree.move(staticCollider.second, staticCollider.first->getWorldBounds());
+        mStaticCategoryBits |= staticCollider.first->getCategoryBits();
+    }
+}
+
+void PhysicsEngine::findPairsBruteForce()
+{
+    // Pack the world bounds of the colliders to test, in the same order as the collections, so that the overlap kernel can test them in batches
+    mDynamicBoxes.clear();
+    mStaticBoxes.clear();
+    mStaticBoxColliders.clear();
+    
+    for (auto dynamicCollider : mActiveDynamicColliders)
+        mDynamicBoxes.push_back(dynamicCollider->getWorldBounds());
+    
+    // If the entity containing a collider is pending of destruction, or it is filtered out of every pair, skip it
+    for (auto& staticCollider : staticColliders) {
+        if (!staticCollider.first->entity->isDestroyPending() && staticCollider.first->canCollide()) {
+            mStaticBoxes.push_back(staticCollider.first->getWorldBounds());
+            mStaticBoxColliders.push_back(staticCollider.first);
+        }
+    }
+    
+    // Every thread tests a range of dynamic colliders (entities which have a collider and a rigidBody)
+    mThreadPool.parallelFor(mActiveDynamicColliders.size(), CollidersPerTask, [this] (std::size_t begin, std::size_t end, std::size_t thread) {
+        WorkerBuffers& buffers = mWorkerBuffers[thread];
         sf::FloatRect intersection;
         
-        // Get the global bounds rect of one entity
-        sf::FloatRect rectD = (*iterD)->entity->getWorldTransform().transformRect((*iterD)->getRectBounds());
-        
-        // Check between dynamic colliders (entities which have a collider and a rigidBody)
-        for (auto iterD2 = std::next(iterD); iterD2 != dynamicColliders.end(); ++iterD2) {
+        for (std::size_t i = begin; i < end; ++i) {
+            ComponentCollider* colliderD = mActiveDynamicColliders[i];
+            const sf::FloatRect& rectD = colliderD->getWorldBounds();
             
-            /* The starting point of the iterator is the next item of iterD because dynamic colliders
-             must check collision between them avoiding repetition (1-2 is the same as 2-1). Also,
-             it avoids self-collision detecton (1-1, 2-2, etc).
+            /* Check between dynamic colliders (entities which have a collider and a rigidBody). The range starts
+             at the next collider because dynamic colliders must check collision between them avoiding repetition
+             (1-2 is the same as 2-1). Also, it avoids self-collision detecton (1-1, 2-2, etc).
              */
+            mDynamicBoxes.findOverlaps(rectD, i + 1, mDynamicBoxes.size(), buffers.overlaps);
             
-            // If the entity containing this collider is pending of destruction, skip it
-            if ((*iterD2)->entity->isDestroyPending() || (*iterD)->entity->isDestroyPending())
-                continue;
+            for (std::uint32_t j : buffers.overlaps) {
+                
+                // Reject the pair if the collision layers filter it
+                if (!colliderD->canCollideWith(*mActiveDynamicColliders[j]))
+                    continue;
+                
+                rectD.intersects(mActiveDynamicColliders[j]->getWorldBounds(), intersection);
+                addPair(buffers.pairs, colliderD, mActiveDynamicColliders[j], false, intersection);
+            }
+            
+            // Check between dynamic (entities which have a collider and a rigidBody) and static colliders (entities which have a collider but no rigidBody)
+            mStaticBoxes.findOverlaps(rectD, 0, mStaticBoxes.size(), buffers.overlaps);
             
-            // Get the global bounds rect of the other entity
-            sf::FloatRect rectD2 = (*iterD2)->entity->getWorldTransform().transformRect((*iterD2)->getRectBounds());
+            for (std::uint32_t j : buffers.overlaps) {
+                
+                // Reject the pair if the collision layers filter it
+                if (!colliderD->canCollideWith(*mStaticBoxColliders[j]))
+                    continue;
+                
+                rectD.intersects(mStaticBoxColliders[j]->getWorldBounds(), intersection);
+                addPair(buffers.pairs, colliderD, mStaticBoxColliders[j], true, intersection);
+            }
+        }
+    });
+}
+
+/* Uniform grid (spatial hash) broadphase. Every dynamic collider is inserted in all the cells its world
+ bounds overlap, and the entries are sorted by cell so that colliders sharing a cell are contiguous. Only
+ those colliders are tested against each other. A pair of colliders sharing several cells is only reported
+ in the cell which contains the top-left corner of their intersection, so no duplicates are generated.
+ The cells are tested in parallel.
+ */
+void PhysicsEngine::findPairsUniformGrid()
+{
+    mGridEntries.clear();
+    mOversizedColliders.clear();
+    
+    for (auto dynamicCollider : mActiveDynamicColliders)
+        insertInGrid(dynamicCollider);
+    
+    std::sort(mGridEntries.begin(), mGridEntries.end(), [] (const GridEntry& a, const GridEntry& b) {
+        return a.cell < b.cell;
+    });
+    
+    // Pack the bounds of the entries in the same order, so that the overlap kernel tests them in batches
+    mDynamicBoxes.clear();
+    
+    mGridCells.clear();
+    
+    for (std::size_t i = 0; i < mGridEntries.size(); ++i) {
+        mDynamicBoxes.push_back(mGridEntries[i].collider->getWorldBounds());
+        
+        if (i == 0 || mGridEntries[i].cell != mGridEntries[i - 1].cell)
+            mGridCells.push_back(i);
+    }
+    
+    mGridCells.push_back(mGridEntries.size());
+    
+    // Test the colliders of each cell between them
+    mThreadPool.parallelFor(mGridCells.size() - 1, GridCellsPerTask, [this] (std::size_t begin, std::size_t end, std::size_t thread) {
+        WorkerBuffers& buffers = mWorkerBuffers[thread];
+        sf::FloatRect intersection;
+        
+        for (std::size_t cellIndex = begin; cellIndex < end; ++cellIndex) {
+            std::size_t cellBegin = mGridCells[cellIndex];
+            std::size_t cellEnd = mGridCells[cellIndex + 1];
+            std::uint64_t cell = mGridEntries[cellBegin].cell;
             
-            // Check collision with SFML and call collisionHandler of both entities
-            if(rectD.intersects(rectD2, intersection)){
-                (*iterD)->entity->collisionHandler((*iterD2)->entity, intersection);
-                (*iterD2)->entity->collisionHandler((*iterD)->entity, intersection);
+            for (std::size_t i = cellBegin; i < cellEnd; ++i) {
+                ComponentCollider* a = mGridEntries[i].collider;
+                
+                mDynamicBoxes.findOverlaps(a->getWorldBounds(), i + 1, cellEnd, buffers.overlaps);
+                
+                for (std::uint32_t j : buffers.overlaps) {
+                    ComponentCollider* b = mGridEntries[j].collider;
+                    
+                    if (!a->canCollideWith(*b))
+                        continue;
+                    
+                    a->getWorldBounds().intersects(b->getWorldBounds(), intersection);
+                    
+                    // Report the pair only once, in the cell containing the top-left corner of the intersection
+                    if (gridCellKey(gridCoordinate(intersection.left, mGridCellSize), gridCoordinate(intersection.top, mGridCellSize)) != cell)
+                        continue;
+                    
+                    addPair(buffers.pairs, a, b, false, intersection);
+                }
+            }
+        }
+    });
+    
+    // Test oversized colliders against every other dynamic collider
+    mThreadPool.parallelFor(mOversizedColliders.size(), 1, [this] (std::size_t begin, std::size_t end, std::size_t thread) {
+        WorkerBuffers& buffers = mWorkerBuffers[thread];
+        sf::FloatRect intersection;
+        
+        for (auto iterO = mOversizedColliders.begin() + begin; iterO != mOversizedColliders.begin() + end; ++iterO) {
+            for (auto collider : mActiveDynamicColliders) {
+                
+                if (collider == *iterO || !(*iterO)->canCollideWith(*collider))
+                    continue;
+                
+                // Pairs of two oversized colliders are only tested from the first one of the pair
+                if (std::find(mOversizedColliders.begin(), iterO, collider) != iterO)
+                    continue;
+                
+                if ((*iterO)->getWorldBounds().intersects(collider->getWorldBounds(), intersection))
+                    addPair(buffers.pairs, *iterO, collider, false, intersection);
             }
         }
+    });
+    
+    findStaticPairs();
+}
+
+void PhysicsEngine::insertInGrid(ComponentCollider* collider)
+{
+    const sf::FloatRect& bounds = collider->getWorldBounds();
+    
+    int minX = gridCoordinate(bounds.left, mGridCellSize);
+    int minY = gridCoordinate(bounds.top, mGridCellSize);
+    int maxX = gridCoordinate(bounds.left + bounds.width, mGridCellSize);
+    int maxY = gridCoordinate(bounds.top + bounds.height, mGridCellSize);
+    
+    if ((long long)(maxX - minX + 1) * (maxY - minY + 1) > MaxGridCellsPerCollider) {
+        mOversizedColliders.push_back(collider);
+        return;
+    }
+    
+    for (int x = minX; x <= maxX; ++x)
+        for (int y = minY; y <= maxY; ++y)
+            mGridEntries.push_back({ gridCellKey(x, y), collider });
+}
+
+/* Sweep and prune (sort and sweep) broadphase. Both bounds of every dynamic collider along the sweep axis are
+ kept in a list sorted by value. As bodies only move a little each step, the list from the previous step is
+ almost sorted and insertion sort fixes it in nearly linear time. Then the list is swept keeping the colliders
+ whose interval contains the current position: a collider only needs to be tested against those. The sweep
+ depends on the previous endpoints, so it runs on the calling thread, and only the static pairs run in parallel.
+ */
+void PhysicsEngine::findPairsSweepAndPrune()
+{
+    updateSweepEndpoints();
+    
+    mSweepActive.clear();
+    mSweepActiveBoxes.clear();
+    
+    WorkerBuffers& buffers = mWorkerBuffers[0];
+    sf::FloatRect intersection;
+    
+    for (auto& endpoint : mSweepEndpoints) {
+        ComponentCollider* collider = mSweepProxies[endpoint.proxy];
         
-        // Check between dynamic (entities which have a collider and a rigidBody) and static colliders (entities which have a collider but no rigidBody)
-        for (auto iterS = staticColliders.begin(); iterS != staticColliders.end(); ++iterS) {
+        if (collider->entity->isDestroyPending() || !collider->canCollide())
+            continue;
+        
+        if (endpoint.isMin) {
+            // The interval starts: test it against every open interval and open it
+            mSweepActiveBoxes.findOverlaps(collider->getWorldBounds(), 0, mSweepActiveBoxes.size(), buffers.overlaps);
+            
+            for (std::uint32_t i : buffers.overlaps) {
+                ComponentCollider* activeCollider = mSweepProxies[mSweepActive[i]];
+                
+                if (!collider->canCollideWith(*activeCollider))
+                    continue;
+                
+                collider->getWorldBounds().intersects(activeCollider->getWorldBounds(), intersection);
+                addPair(buffers.pairs, collider, activeCollider, false, intersection);
+            }
             
-            // If the entity containing this collider is pending of destruction, skip it
-            if ((*iterS)->entity->isDestroyPending() || (*iterD)->entity->isDestroyPending())
+            mSweepActive.push_back(endpoint.proxy);
+            mSweepActiveBoxes.push_back(collider->getWorldBounds());
+        }
+        else {
+            // The interval ends: close it (the order of the open intervals does not matter)
+            auto found = std::find(mSweepActive.begin(), mSweepActive.end(), endpoint.proxy);
+            
+            if (found != mSweepActive.end()) {
+                mSweepActiveBoxes.swapAndPop(found - mSweepActive.begin());
+                *found = mSweepActive.back();
+                mSweepActive.pop_back();
+            }
+        }
+    }
+    
+    findStaticPairs();
+}
+
+void PhysicsEngine::updateSweepEndpoints()
+{
+    // Remove the endpoints of deleted colliders all at once, and only then allow their proxies to be reused
+    if (!mSweepRemovedProxies.empty()) {
+        mSweepEndpoints.erase(std::remove_if(mSweepEndpoints.begin(), mSweepEndpoints.end(), [this] (const SweepEndpoint& endpoint) {
+            return mSweepProxies[endpoint.proxy] == nullptr;
+        }), mSweepEndpoints.end());
+        
+        mSweepFreeProxies.insert(mSweepFreeProxies.end(), mSweepRemovedProxies.begin(), mSweepRemovedProxies.end());
+        mSweepRemovedProxies.clear();
+    }
+    
+    // Refresh the values with the current world bounds
+    for (auto& endpoint : mSweepEndpoints) {
+        const sf::FloatRect& bounds = mSweepProxies[endpoint.proxy]->getWorldBounds();
+        
+        if (mSweepAxis == AxisX)
+            endpoint.value = endpoint.isMin ? bounds.left : bounds.left + bounds.width;
+        else
+            endpoint.value = endpoint.isMin ? bounds.top : bounds.top + bounds.height;
+    }
+    
+    // Insertion sort: O(n) when the list is almost sorted, as it usually is between consecutive steps
+    for (std::size_t i = 1; i < mSweepEndpoints.size(); ++i) {
+        SweepEndpoint endpoint = mSweepEndpoints[i];
+        std::size_t j = i;
+        
+        while (j > 0 && mSweepEndpoints[j - 1].value > endpoint.value) {
+            mSweepEndpoints[j] = mSweepEndpoints[j - 1];
+            --j;
+        }
+        
+        mSweepEndpoints[j] = endpoint;
+    }
+}
+
+// Query the static colliders tree with the bounds of every dynamic collider: O(D log S), split between the threads
+void PhysicsEngine::findStaticPairs()
+{
+    mThreadPool.parallelFor(mActiveDynamicColliders.size(), CollidersPerTask, [this] (std::size_t begin, std::size_t end, std::size_t thread) {
+        WorkerBuffers& buffers = mWorkerBuffers[thread];
+        sf::FloatRect intersection;
+        
+        for (std::size_t i = begin; i < end; ++i) {
+            ComponentCollider* dynamicCollider = mActiveDynamicColliders[i];
+            
+            // Skip the query if no static collider belongs to a category accepted by its mask
+            if ((dynamicCollider->getMaskBits() & mStaticCategoryBits) == 0)
                 continue;
             
-            // Get the global bounds rect of the other entity
-            sf::FloatRect rectS = (*iterS)->entity->getWorldTransform().transformRect((*iterS)->getRectBounds());
+            const sf::FloatRect& bounds = dynamicCollider->getWorldBounds();
             
-            // Check collision with SFML and call collisionHandler of both entities
-            if(rectD.intersects(rectS, intersection)){
-                (*iterD)->entity->collisionHandler((*iterS)->entity, intersection);
-                (*iterS)->entity->collisionHandler((*iterD)->entity, intersection);
+            mStaticTree.query(bounds, [&] (ComponentCollider* staticCollider) {
+                if (!staticCollider->entity->isDestroyPending() && dynamicCollider->canCollideWith(*staticCollider) && bounds.intersects(staticCollider->getWorldBounds(), intersection))
+                    addPair(buffers.pairs, dynamicCollider, staticCollider, true, intersection);
+            });
+        }
+    });
+}
+
+void PhysicsEngine::addPair(std::vector<CollisionPair>& pairs, ComponentCollider* dynamicCollider, ComponentCollider* otherCollider, bool otherIsStatic, const sf::FloatRect& intersection)
+{
+    // Dynamic pairs are stored with the lowest collider first, as the brute force loop finds them
+    if (!otherIsStatic && std::less<ComponentCollider*>()(otherCollider, dynamicCollider))
+        std::swap(dynamicCollider, otherCollider);
+    
+    pairs.push_back({ dynamicCollider, otherCollider, otherIsStatic, intersection });
+}
+
+/* Joins the pairs found by every thread, and sorts them in the same order the brute force loop finds them.
+ Which thread finds a pair depends on the scheduling, but the sorted list does not, so the collisionHandlers
+ are always called in the same order. */
+void PhysicsEngine::gatherPairs()
+{
+    mPairs.clear();
+    
+    for (auto& buffers : mWorkerBuffers)
+        mPairs.insert(mPairs.end(), buffers.pairs.begin(), buffers.pairs.end());
+    
+    std::sort(mPairs.begin(), mPairs.end(), comparePairs);
+}
+
+// Order in which the brute force loop finds the pairs. Both mPairs and mContacts are sorted with it
+bool PhysicsEngine::comparePairs(const CollisionPair& a, const CollisionPair& b)
+{
+    if (a.first != b.first)
+        return std::less<ComponentCollider*>()(a.first, b.first);
+    if (a.secondIsStatic != b.secondIsStatic)
+        return !a.secondIsStatic; // Dynamic-dynamic pairs are checked before dynamic-static pairs
+    return std::less<ComponentCollider*>()(a.second, b.second);
+}
+
+/* Calls the collision callbacks of the pairs found in this step. As both the pairs and the contacts of the
+ previous step are sorted, they are merged in a single pass: pairs which were already in contact stay, new
+ pairs enter, and contacts which have not been found again exit. The callbacks may end the contacts of a
+ collider (e.g. with ComponentCollider::setStatic) while mContacts is iterated, so that is done afterwards.
+ */
+void PhysicsEngine::dispatchPairs()
+{
+    mNewContacts.clear();
+    mDispatching = true;
+    
+    auto contact = mContacts.begin();
+    
+    for (auto& pair : mPairs) {
+        
+        // Contacts sorted before this pair have not been found in this step, so they have ended
+        for (; contact != mContacts.end() && comparePairs(*contact, pair); ++contact) {
+            contact->first->entity->collisionExit(contact->second->entity);
+            contact->second->entity->collisionExit(contact->first->entity);
+        }
+        
+        bool wasInContact = contact != mContacts.end() && !comparePairs(pair, *contact);
+        if (wasInContact)
+            ++contact;
+        
+        // A previous collisionHandler may have requested the destruction of one of the entities, skip them
+        if (pair.first->entity->isDestroyPending() || pair.second->entity->isDestroyPending()) {
+            if (wasInContact) {
+                pair.first->entity->collisionExit(pair.second->entity);
+                pair.second->entity->collisionExit(pair.first->entity);
             }
+            continue;
+        }
+        
+        // Call collisionHandler of both entities
+        pair.first->entity->collisionHandler(pair.second->entity, pair.intersection);
+        pair.second->entity->collisionHandler(pair.first->entity, pair.intersection);
+        
+        if (wasInContact) {
+            pair.first->entity->collisionStay(pair.second->entity, pair.intersection);
+            pair.second->entity->collisionStay(pair.first->entity, pair.intersection);
+        }
+        else {
+            pair.first->entity->collisionEnter(pair.second->entity, pair.intersection);
+            pair.second->entity->collisionEnter(pair.first->entity, pair.intersection);
         }
+        
+        mNewContacts.push_back(pair);
+    }
+    
+    // The remaining contacts have not been found in this step either
+    for (; contact != mContacts.end(); ++contact) {
+        contact->first->entity->collisionExit(contact->second->entity);
+        contact->second->entity->collisionExit(contact->first->entity);
+    }
+    
+    mContacts.swap(mNewContacts);
+    mDispatching = false;
+    
+    // Contacts ended by the callbacks, including the ones entered in this step
+    for (auto& removal : mPendingContactRemovals) {
+        if (removal.second)
+            endContacts(removal.first);
+        else
+            removeContacts(removal.first);
     }
+    
+    mPendingContactRemovals.clear();
+}
+
+// Calls onCollisionExit for every contact of the collider, and forgets them. Used when a collider is about to be removed
+void PhysicsEngine::endContacts(ComponentCollider* collider)
+{
+    if (mDispatching) {
+        mPendingContactRemovals.push_back(std::make_pair(collider, true));
+        return;
+    }
+    
+    // Copy the contacts to end first, as the callbacks could modify the cache
+    std::vector<CollisionPair> endedContacts;
+    
+    for (auto& contact : mContacts)
+        if (contact.first == collider || contact.second == collider)
+            endedContacts.push_back(contact);
+    
+    removeContacts(collider);
+    
+    for (auto& contact : endedContacts) {
+        contact.first->entity->collisionExit(contact.second->entity);
+        contact.second->entity->collisionExit(contact.first->entity);
+    }
+}
+
+void PhysicsEngine::removeContacts(ComponentCollider* collider)
+{
+    if (mDispatching) {
+        mPendingContactRemovals.push_back(std::make_pair(collider, false));
+        return;
+    }
+    
+    mContacts.erase(std::remove_if(mContacts.begin(), mContacts.end(), [collider] (const CollisionPair& contact) {
+        return contact.first == collider || contact.second == collider;
+    }), mContacts.end());
+}
+
+// The sweep and prune lists are only kept while that broadphase is used, so they are built again when switching to it
+void PhysicsEngine::setBroadphaseMode(BroadphaseMode mode)
+{
+    if (mode == mBroadphaseMode)
+        return;
+    
+    mBroadphaseMode = mode;
+    clearSweepProxies();
+    
+    for (auto& dynamicCollider : dynamicColliders)
+        dynamicCollider.second = mode == SweepAndPrune ? addSweepProxy(dynamicCollider.first) : NoSweepProxy;
+}
+
+PhysicsEngine::BroadphaseMode PhysicsEngine::getBroadphaseMode()
+{
+    return mBroadphaseMode;
+}
+
+void PhysicsEngine::setGridCellSize(float cellSize)
+{
+    assert(cellSize > 0.f);
+    mGridCellSize = cellSize;
+}
+
+float PhysicsEngine::getGridCellSize()
+{
+    return mGridCellSize;
+}
+
+void PhysicsEngine::setSweepAxis(Axis axis)
+{
+    // The endpoints are sorted again in the next step
+    mSweepAxis = axis;
+}
+
+PhysicsEngine::Axis PhysicsEngine::getSweepAxis()
+{
+    return mSweepAxis;
+}
+
+// Number of threads used to find the collision pairs, including the calling one. 0 uses one per hardware core
+void PhysicsEngine::setThreadCount(std::size_t threadCount)
+{
+    mThreadPool.setThreadCount(threadCount);
+}
+
+std::size_t PhysicsEngine::getThreadCount()
+{
+    return mThreadPool.getThreadCount();
+}
+
+// Rebuild the static tree from scratch. Call it after adding many static colliders at once (e.g. loading a scene)
+void PhysicsEngine::rebuildStaticColliderTree()
+{
+    mStaticTree.rebuild();
+}
+
+RigidBodyStore& PhysicsEngine::getRigidBodyStore()
+{
+    return mRigidBodies;
 }
 
 void PhysicsEngine::addStaticCollider(xgsd::ComponentCollider *collider)
 {
-    auto inserted = staticColliders.insert(collider);
+    // Insert the collider in the static tree with its current world bounds
+    collider->updateWorldBounds();
+    int proxy = mStaticTree.insert(collider->getWorldBounds(), collider);
+    
+    auto inserted = staticColliders.insert(std::make_pair(collider, proxy));
     assert(inserted.second);
 }
 
 void PhysicsEngine::addDynamicCollider(xgsd::ComponentCollider *collider)
 {
-    auto inserted = dynamicColliders.insert(collider);
+    // Only the sweep and prune broadphase needs a proxy
+    int proxy = mBroadphaseMode == SweepAndPrune ? addSweepProxy(collider) : NoSweepProxy;
+    
+    auto inserted = dynamicColliders.insert(std::make_pair(collider, proxy));
     assert(inserted.second);
 }
 
@@ -76,14 +611,58 @@ void PhysicsEngine::deleteStaticCollider(xgsd::ComponentCollider *collider)
 {
     auto found = staticColliders.find(collider);
     assert(found != staticColliders.end());
-    staticColliders.erase(collider);
+    mStaticTree.remove(found->second);
+    staticColliders.erase(found);
+    
+    // Forget its contacts without notifying them (see endContacts)
+    removeContacts(collider);
 }
 
 void PhysicsEngine::deleteDynamicCollider(xgsd::ComponentCollider *collider)
 {
     auto found = dynamicColliders.find(collider);
     assert(found != dynamicColliders.end());
-    dynamicColliders.erase(collider);
+    
+    // The endpoints of the proxy are removed in the next step, so deleting many colliders at once is cheap
+    if (found->second != NoSweepProxy) {
+        mSweepProxies[found->second] = nullptr;
+        mSweepRemovedProxies.push_back(found->second);
+    }
+    dynamicColliders.erase(found);
+    
+    // Forget its contacts without notifying them (see endContacts)
+    removeContacts(collider);
+}
+
+// Create a proxy in the sweep and prune list. Its endpoints are placed at their sorted position in the next step
+int PhysicsEngine::addSweepProxy(ComponentCollider* collider)
+{
+    int proxy;
+    
+    if (mSweepFreeProxies.empty()) {
+        proxy = (int)mSweepProxies.size();
+        mSweepProxies.push_back(collider);
+    }
+    else {
+        proxy = mSweepFreeProxies.back();
+        mSweepFreeProxies.pop_back();
+        mSweepProxies[proxy] = collider;
+    }
+    
+    mSweepEndpoints.push_back({ 0.f, proxy, true });
+    mSweepEndpoints.push_back({ 0.f, proxy, false });
+    
+    return proxy;
+}
+
+void PhysicsEngine::clearSweepProxies()
+{
+    mSweepEndpoints.clear();
+    mSweepProxies.clear();
+    mSweepFreeProxies.clear();
+    mSweepRemovedProxies.clear();
+    mSweepActive.clear();
+    mSweepActiveBoxes.clear();
 }
 
 // Simple integrator. Cheap, but accumulates a lot of error as time advances.
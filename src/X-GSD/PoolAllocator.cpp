@@ -0,0 +1,128 @@
+#include <X-GSD/PoolAllocator.hpp>
+
+#include <mutex>
+#include <atomic>
+#include <new>
+#include <cassert>
+
+using namespace xgsd;
+
+const std::size_t PoolAllocator::Granularity = alignof(std::max_align_t);
+const std::size_t PoolAllocator::MaxPooledSize = 1024;
+const std::size_t PoolAllocator::BlocksPerSlab = 64;
+
+namespace {
+    
+    // Free blocks store the pointer to the next free block in their first bytes
+    struct FreeBlock
+    {
+        FreeBlock*      next;
+    };
+    
+    // Blocks of one size class
+    struct Pool
+    {
+        std::mutex      mutex;
+        FreeBlock*      freeList = nullptr;
+        std::size_t     allocations = 0;
+        std::size_t     deallocations = 0;
+        std::size_t     slabs = 0;
+    };
+    
+    const std::size_t PoolCount = PoolAllocator::MaxPooledSize / PoolAllocator::Granularity;
+    
+    // Allocations and deallocations of objects too big to be pooled
+    std::atomic<std::size_t> unpooledAllocations(0);
+    std::atomic<std::size_t> unpooledDeallocations(0);
+    
+    /* The pools are never destroyed: objects owned by other static objects (e.g. the scene of the Game) may be
+     freed after the destruction of any static of this file. The operating system takes the slabs back on exit. */
+    Pool* getPools()
+    {
+        static Pool* pools = new Pool[PoolCount];
+        return pools;
+    }
+    
+    std::size_t getPoolIndex(std::size_t size)
+    {
+        return size == 0 ? 0 : (size - 1) / PoolAllocator::Granularity;
+    }
+    
+} // anonymous namespace
+
+void* PoolAllocator::allocate(std::size_t size)
+{
+    if (size > MaxPooledSize) {
+        ++unpooledAllocations;
+        return ::operator new(size);
+    }
+    
+    std::size_t index = getPoolIndex(size);
+    Pool& pool = getPools()[index];
+    
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    
+    // Out of free blocks, so take a new slab and chain all its blocks in the free list
+    if (!pool.freeList) {
+        std::size_t blockSize = (index + 1) * Granularity;
+        char* slab = static_cast<char*>(::operator new(blockSize * BlocksPerSlab));
+        
+        for (std::size_t i = BlocksPerSlab; i-- > 0;) {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + i * blockSize);
+            block->next = pool.freeList;
+            pool.freeList = block;
+        }
+        
+        ++pool.slabs;
+    }
+    
+    FreeBlock* block = pool.freeList;
+    pool.freeList = block->next;
+    ++pool.allocations;
+    
+    return block;
+}
+
+// The size must be the same given to allocate
+void PoolAllocator::deallocate(void* pointer, std::size_t size)
+{
+    if (!pointer)
+        return;
+    
+    if (size > MaxPooledSize) {
+        ++unpooledDeallocations;
+        ::operator delete(pointer);
+        return;
+    }
+    
+    Pool& pool = getPools()[getPoolIndex(size)];
+    
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    
+    FreeBlock* block = static_cast<FreeBlock*>(pointer);
+    block->next = pool.freeList;
+    pool.freeList = block;
+    ++pool.deallocations;
+}
+
+PoolAllocator::Statistics PoolAllocator::getStatistics()
+{
+    Statistics statistics;
+    statistics.allocations = unpooledAllocations;
+    statistics.deallocations = unpooledDeallocations;
+    statistics.slabAllocations = unpooledAllocations;
+    statistics.reservedBytes = 0;
+    
+    Pool* pools = getPools();
+    
+    for (std::size_t index = 0; index < PoolCount; ++index) {
+        std::lock_guard<std::mutex> lock(pools[index].mutex);
+        
+        statistics.allocations += pools[index].allocations;
+        statistics.deallocations += pools[index].deallocations;
+        statistics.slabAllocations += pools[index].slabs;
+        statistics.reservedBytes += pools[index].slabs * BlocksPerSlab * (index + 1) * Granularity;
+    }
+    
+    return statistics;
+}
@@ -0,0 +1,129 @@
+#include <X-GSD/Prefab.hpp>
+#include <X-GSD/ComponentSprite.hpp>
+#include <X-GSD/ComponentCollider.hpp>
+#include <X-GSD/ComponentRigidBody.hpp>
+#include <X-GSD/Game.hpp>
+
+using namespace xgsd;
+
+/* Resolves the record of an entity or a prefab of the file, which was checked when loaded. Textures are taken
+ from the given manager, or from the Game's one if they are global. Positions relative to the view are resolved
+ with its size. */
+Prefab::Prefab(const SceneFile& file, const SceneFile::EntityRecord& record, TextureManager& textureManager, ControllersManager& controllersManager, const sf::Vector2f& viewSize)
+: mName(file.getString(record.name))
+, mTransformable()
+, mComponents()
+{
+    // Load resources here (RAII)
+    
+    // Set the Transformable (the default zeroed values are already in the record if the scene defined none)
+    mTransformable.setOrigin(record.origin[0], record.origin[1]);
+    
+    if (record.flags & SceneFile::RelativePosition)
+        mTransformable.setPosition(record.position[0] * viewSize.x, record.position[1] * viewSize.y); // TODO: Relative to the parent node instead of view
+    else
+        mTransformable.setPosition(record.position[0], record.position[1]);
+    
+    mTransformable.setScale(record.scale[0], record.scale[1]);
+    mTransformable.setRotation(record.rotation);
+    
+    // Resolve the components, in the order they were defined
+    mComponents.reserve(record.componentCount);
+    
+    for (std::size_t c = record.firstComponent; c < record.firstComponent + record.componentCount; ++c) {
+        
+        const SceneFile::ComponentRecord& component = file.getComponent(c);
+        
+        ComponentTemplate newComponent = ComponentTemplate();
+        newComponent.type = (SceneFile::ComponentType)component.type;
+        newComponent.flags = component.flags;
+        
+        switch (component.type) {
+            
+            case SceneFile::SpriteComponent: {
+                std::string textureName = file.getString(component.string);
+                const sf::Texture& texture = (component.flags & SceneFile::GlobalTexture) ? Game::instance().getGlobalTextureManager().get(textureName) : textureManager.get(textureName);
+                
+                // Its atlas region and size are looked up here, once
+                if (component.flags & SceneFile::HasTextureRect)
+                    newComponent.sprite = ComponentSprite::resolveTexture(texture, sf::IntRect(component.textureRect[0], component.textureRect[1], component.textureRect[2], component.textureRect[3]));
+                else
+                    newComponent.sprite = ComponentSprite::resolveTexture(texture);
+                break;
+            }
+            
+            case SceneFile::ColliderComponent:
+                newComponent.boundsRect = sf::FloatRect(component.boundsRect[0], component.boundsRect[1], component.boundsRect[2], component.boundsRect[3]);
+                newComponent.categoryBits = (std::uint16_t)component.categoryBits;
+                newComponent.maskBits = (std::uint16_t)component.maskBits;
+                break;
+            
+            case SceneFile::RigidBodyComponent:
+                break;
+            
+            case SceneFile::ControllerComponent:
+                // TODO: Define a way of loading controller-specific values, i.e: number of lives, speed or jump height. It may be implemented with a map from string to... any? or to string and parse to int/float if needed?
+                newComponent.controllerFactory = controllersManager.getControllerFactory(file.getString(component.string));
+                break;
+        }
+        
+        mComponents.push_back(std::move(newComponent));
+    }
+}
+
+// With the transformable of the prefab
+Entity::Ptr Prefab::instantiate(const std::string& name) const
+{
+    return instantiate(mTransformable, name);
+}
+
+/* Creates an entity from the template, to be attached to the scene graph. Instances need no name unless they are
+ looked up by it (see Entity::getEntityNamed). */
+Entity::Ptr Prefab::instantiate(const sf::Transformable& transformable, const std::string& name) const
+{
+    Entity::Ptr newEntity(new Entity(name));
+    newEntity->setTransformable(transformable);
+    
+    for (const ComponentTemplate& component : mComponents) {
+        
+        switch (component.type) {
+            
+            case SceneFile::SpriteComponent:
+                newEntity->addComponent(Component::Ptr(new ComponentSprite(component.sprite)));
+                break;
+            
+            case SceneFile::ColliderComponent: {
+                ComponentCollider* newCollider = new ComponentCollider(component.boundsRect);
+                
+                // Set the collision layers (if any, otherwise the default ones are kept)
+                if (component.flags & SceneFile::HasCategoryBits)
+                    newCollider->setCategoryBits(component.categoryBits);
+                if (component.flags & SceneFile::HasMaskBits)
+                    newCollider->setMaskBits(component.maskBits);
+                
+                newEntity->addComponent(Component::Ptr(newCollider));
+                break;
+            }
+            
+            case SceneFile::RigidBodyComponent:
+                newEntity->addComponent(Component::Ptr(new ComponentRigidBody((component.flags & SceneFile::Kinematic) != 0)));
+                break;
+            
+            case SceneFile::ControllerComponent:
+                newEntity->addComponent(component.controllerFactory());
+                break;
+        }
+    }
+    
+    return newEntity;
+}
+
+const std::string& Prefab::getName() const
+{
+    return mName;
+}
+
+const sf::Transformable& Prefab::getTransformable() const
+{
+    return mTransformable;
+}
@@ -0,0 +1,108 @@
+#include <X-GSD/RenderCommandList.hpp>
+
+#include <SFML/Graphics/RectangleShape.hpp>
+
+#include <unordered_map>
+
+using namespace xgsd;
+
+RenderCommandList::RenderCommandList()
+: mCommands()
+, mPools()
+{
+    // Load resources here (RAII)
+}
+
+void RenderCommandList::draw(const sf::Sprite& sprite, const sf::RenderStates& states)
+{
+    // Sprites with a shader are not batched, so there is no need to break them down
+    if (states.shader) {
+        draw<sf::Sprite>(sprite, states);
+        return;
+    }
+    
+    // Nothing is drawn for a sprite without texture
+    if (!sprite.getTexture())
+        return;
+    
+    sf::RenderStates spriteStates(states);
+    spriteStates.transform *= sprite.getTransform();
+    spriteStates.texture = sprite.getTexture();
+    
+    mCommands.push_back(Command{ spriteStates, sprite.getTextureRect(), sprite.getColor(), nullptr, nullptr, sf::Vector2f() });
+}
+
+/* Records a copy of the text, whose origin is set by the replay so that the anchor (relative to its bounds, i.e:
+ (0.5, 0.5) for its center) lies at its position. A background of the size of the bounds is drawn behind it unless
+ the color is transparent. The text is never measured here, since its font may be in use by the replay. */
+void RenderCommandList::drawText(const sf::Text& text, const sf::Vector2f& anchor, const sf::Color& backgroundColor, const sf::RenderStates& states)
+{
+    sf::Text* copy = getPool<sf::Text>().copy(text);
+    
+    mCommands.push_back(Command{ states, sf::IntRect(), backgroundColor, copy, copy, anchor });
+}
+
+// Draws the commands in the order they were recorded. Sprites are batched unless the batch is disabled
+void RenderCommandList::replay(sf::RenderTarget& target, SpriteBatch& spriteBatch) const
+{
+    for (const Command& command : mCommands) {
+        if (command.drawable) {
+            // Anything drawn directly must be drawn over the sprites batched before it
+            spriteBatch.flush(target);
+            
+            // The copies belong to the list, and the bounds of texts can only be taken here
+            if (command.alignedText) {
+                sf::FloatRect bounds = command.alignedText->getLocalBounds();
+                command.alignedText->setOrigin(bounds.left + bounds.width * command.anchor.x, bounds.top + bounds.height * command.anchor.y);
+                
+                if (command.color.a > 0) {
+                    sf::RectangleShape background(sf::Vector2f(bounds.width, bounds.height));
+                    background.setPosition(bounds.left, bounds.top);
+                    background.setFillColor(command.color);
+                    
+                    sf::RenderStates backgroundStates(command.states);
+                    backgroundStates.transform *= command.alignedText->getTransform();
+                    target.draw(background, backgroundStates);
+                }
+            }
+            
+            target.draw(*command.drawable, command.states);
+            continue;
+        }
+        
+        // The transform of the sprite is already in the states
+        sf::Sprite sprite(*command.states.texture, command.textureRect);
+        sprite.setColor(command.color);
+        
+        if (spriteBatch.isEnabled())
+            spriteBatch.add(sprite, command.states);
+        else
+            target.draw(sprite, command.states);
+    }
+    
+    spriteBatch.flush(target);
+}
+
+// The pooled copies are kept, to be assigned over by the next frame
+void RenderCommandList::clear()
+{
+    mCommands.clear();
+    
+    for (std::unique_ptr<DrawablePool>& pool : mPools)
+        if (pool)
+            pool->reset();
+}
+
+bool RenderCommandList::isEmpty() const
+{
+    return mCommands.empty();
+}
+
+// Assigns the indices in order of first use, once per type (see getPool)
+std::size_t RenderCommandList::getPoolIndex(const std::type_index& type)
+{
+    static std::unordered_map<std::type_index, std::size_t> poolIndices;
+    
+    auto inserted = poolIndices.insert(std::make_pair(type, poolIndices.size()));
+    return inserted.first->second;
+}
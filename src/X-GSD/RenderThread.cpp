@@ -0,0 +1,123 @@
+#include <X-GSD/RenderThread.hpp>
+
+#include <utility>
+
+using namespace xgsd;
+
+RenderThread::RenderThread(sf::RenderWindow& window, SpriteBatch& spriteBatch)
+: mWindow(window)
+, mSpriteBatch(spriteBatch)
+, mRecording(0)
+, mSubmitted(1)
+, mDrawing(2)
+, mSubmittedPending(false)
+, mDrawingBusy(false)
+, mVSync(false)
+, mVSyncChanged(false)
+, mStopping(false)
+{
+    // Load resources here (RAII)
+    
+    // The context of the window can only be active on one thread at a time
+    mWindow.setActive(false);
+    mThread = std::thread(&RenderThread::renderLoop, this);
+}
+
+RenderThread::~RenderThread()
+{
+    // Cleanup
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mFrameSubmitted.notify_all();
+    mFrameTaken.notify_all();
+    
+    mThread.join();
+    
+    // Give the context back to the thread which owns the window
+    mWindow.setActive(true);
+}
+
+// The list to record the next frame on. Only to be used by the simulation thread, until the list is submitted
+RenderCommandList& RenderThread::getCommandList()
+{
+    return mCommandLists[mRecording];
+}
+
+void RenderThread::submit()
+{
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        
+        // Do not get more than one frame ahead of the render thread
+        mFrameTaken.wait(lock, [this] { return !mSubmittedPending || mStopping; });
+        
+        std::swap(mRecording, mSubmitted);
+        mSubmittedPending = true;
+    }
+    mFrameSubmitted.notify_one();
+}
+
+// Waits until the render thread is not drawing, and drops the submitted frame. Call it before releasing resources which may be in use by a frame
+void RenderThread::synchronize()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    
+    mSubmittedPending = false;
+    mCommandLists[mSubmitted].clear();
+    
+    mFrameTaken.wait(lock, [this] { return !mDrawingBusy; });
+}
+
+// Applied by the render thread before drawing the next frame
+void RenderThread::setVerticalSyncEnabled(bool option)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mVSync = option;
+    mVSyncChanged = true;
+}
+
+void RenderThread::renderLoop()
+{
+    mWindow.setActive(true);
+    
+    while (true)
+    {
+        bool vSyncChanged;
+        bool vSync;
+        
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mFrameSubmitted.wait(lock, [this] { return mSubmittedPending || mStopping; });
+            
+            if (mStopping)
+                break;
+            
+            // Take the latest frame. The list drawn before becomes free to be recorded on
+            std::swap(mDrawing, mSubmitted);
+            mSubmittedPending = false;
+            mDrawingBusy = true;
+            
+            vSyncChanged = mVSyncChanged;
+            vSync = mVSync;
+            mVSyncChanged = false;
+        }
+        mFrameTaken.notify_all();
+        
+        if (vSyncChanged)
+            mWindow.setVerticalSyncEnabled(vSync);
+        
+        mWindow.clear();
+        mCommandLists[mDrawing].replay(mWindow, mSpriteBatch);
+        mWindow.display();
+        
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mDrawingBusy = false;
+        }
+        mFrameTaken.notify_all();
+    }
+    
+    mWindow.setActive(false);
+}
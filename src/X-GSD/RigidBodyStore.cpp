@@ -0,0 +1,236 @@
+#include <X-GSD/RigidBodyStore.hpp>
+
+#include <X-GSD/SceneGraphNode.hpp>
+
+#include <algorithm>
+
+using namespace xgsd;
+
+namespace {
+    
+    /* This loop only touches the arrays, without branches, so it can be vectorized. Bodies which are not
+     simulated advance a step of 0, so their state is left untouched. */
+    void integrateAxis(float* positions, float* velocities, const float* forces, const float* inverseMasses, const std::uint8_t* simulated, std::size_t count, float dt)
+    {
+        for (std::size_t i = 0; i < count; ++i) {
+            float step = simulated[i] * dt;
+            float acceleration = forces[i] * inverseMasses[i];
+            
+            positions[i] += (velocities[i] + acceleration * step * 0.5f) * step;
+            velocities[i] += acceleration * step;
+        }
+    }
+    
+} // anonymous namespace
+
+RigidBodyStore::RigidBodyStore()
+: mIndices()
+, mIds()
+, mFreeIds()
+{
+    
+}
+
+int RigidBodyStore::create()
+{
+    // Reuse a free id if possible
+    int id;
+    
+    if (mFreeIds.empty()) {
+        id = (int)mIndices.size();
+        mIndices.push_back(-1);
+    }
+    else {
+        id = mFreeIds.back();
+        mFreeIds.pop_back();
+    }
+    
+    // The new body is appended at the end of the arrays, with the same defaults as PhysicState
+    mIndices[id] = (int)mIds.size();
+    mIds.push_back(id);
+    
+    mPositionsX.push_back(0.f);
+    mPositionsY.push_back(0.f);
+    mVelocitiesX.push_back(0.f);
+    mVelocitiesY.push_back(0.f);
+    mForcesX.push_back(0.f);
+    mForcesY.push_back(0.f);
+    mInverseMasses.push_back(1.f);
+    mLastPositionsX.push_back(0.f);
+    mLastPositionsY.push_back(0.f);
+    mLastVelocitiesX.push_back(0.f);
+    mLastVelocitiesY.push_back(0.f);
+    mLastTransforms.push_back(LastTransform{ 0.f, sf::Vector2f(1.f, 1.f), sf::Vector2f() });
+    mSimulated.push_back(0);
+    mNodes.push_back(nullptr);
+    
+    return id;
+}
+
+void RigidBodyStore::destroy(int id)
+{
+    int index = getIndex(id);
+    int last = (int)mIds.size() - 1;
+    
+    // Move the last body to the place of the destroyed one, so that the arrays stay packed
+    if (index != last) {
+        mIds[index] = mIds[last];
+        mIndices[mIds[index]] = index;
+        
+        mPositionsX[index] = mPositionsX[last];
+        mPositionsY[index] = mPositionsY[last];
+        mVelocitiesX[index] = mVelocitiesX[last];
+        mVelocitiesY[index] = mVelocitiesY[last];
+        mForcesX[index] = mForcesX[last];
+        mForcesY[index] = mForcesY[last];
+        mInverseMasses[index] = mInverseMasses[last];
+        mLastPositionsX[index] = mLastPositionsX[last];
+        mLastPositionsY[index] = mLastPositionsY[last];
+        mLastVelocitiesX[index] = mLastVelocitiesX[last];
+        mLastVelocitiesY[index] = mLastVelocitiesY[last];
+        mLastTransforms[index] = mLastTransforms[last];
+        mSimulated[index] = mSimulated[last];
+        mNodes[index] = mNodes[last];
+    }
+    
+    mIds.pop_back();
+    mPositionsX.pop_back();
+    mPositionsY.pop_back();
+    mVelocitiesX.pop_back();
+    mVelocitiesY.pop_back();
+    mForcesX.pop_back();
+    mForcesY.pop_back();
+    mInverseMasses.pop_back();
+    mLastPositionsX.pop_back();
+    mLastPositionsY.pop_back();
+    mLastVelocitiesX.pop_back();
+    mLastVelocitiesY.pop_back();
+    mLastTransforms.pop_back();
+    mSimulated.pop_back();
+    mNodes.pop_back();
+    
+    mIndices[id] = -1;
+    mFreeIds.push_back(id);
+}
+
+/* Integrates all the simulated bodies at once. The forces are constant during a step, so the result of the
+ RK4 integrator (see PhysicsEngine::integrateRK4) reduces to the exact closed form used here:
+ p' = p + (v + a * dt / 2) * dt, v' = v + a * dt
+ */
+void RigidBodyStore::integrate(const HiResDuration& dt)
+{
+    float dtValue = ((float)dt.count()/ONE_SECOND.count());
+    std::size_t count = mIds.size();
+    
+    // Gather the positions from the nodes, and save the rest of their transform with the last state
+    for (std::size_t i = 0; i < count; ++i) {
+        if (mSimulated[i]) {
+            const sf::Transformable& transformable = mNodes[i]->getTransformable();
+            mPositionsX[i] = transformable.getPosition().x;
+            mPositionsY[i] = transformable.getPosition().y;
+            mLastTransforms[i] = LastTransform{ transformable.getRotation(), transformable.getScale(), transformable.getOrigin() };
+        }
+    }
+    
+    // Save last state
+    std::copy(mPositionsX.begin(), mPositionsX.end(), mLastPositionsX.begin());
+    std::copy(mPositionsY.begin(), mPositionsY.end(), mLastPositionsY.begin());
+    std::copy(mVelocitiesX.begin(), mVelocitiesX.end(), mLastVelocitiesX.begin());
+    std::copy(mVelocitiesY.begin(), mVelocitiesY.end(), mLastVelocitiesY.begin());
+    
+    // Integrate each axis separately, so that every loop only touches a few arrays
+    integrateAxis(mPositionsX.data(), mVelocitiesX.data(), mForcesX.data(), mInverseMasses.data(), mSimulated.data(), count, dtValue);
+    integrateAxis(mPositionsY.data(), mVelocitiesY.data(), mForcesY.data(), mInverseMasses.data(), mSimulated.data(), count, dtValue);
+    
+    // Write the new positions back to the nodes
+    for (std::size_t i = 0; i < count; ++i)
+        if (mSimulated[i])
+            mNodes[i]->setPosition(mPositionsX[i], mPositionsY[i]);
+}
+
+// Restores the velocity and the whole transform of the node as they were before the last step
+void RigidBodyStore::returnToLastState(int id)
+{
+    int index = getIndex(id);
+    
+    mVelocitiesX[index] = mLastVelocitiesX[index];
+    mVelocitiesY[index] = mLastVelocitiesY[index];
+    
+    if (mNodes[index]) {
+        const LastTransform& last = mLastTransforms[index];
+        
+        mNodes[index]->setPosition(mLastPositionsX[index], mLastPositionsY[index]);
+        mNodes[index]->setRotation(last.rotation);
+        mNodes[index]->setScale(last.scale);
+        mNodes[index]->setOrigin(last.origin);
+    }
+}
+
+void RigidBodyStore::setNode(int id, SceneGraphNode* node)
+{
+    int index = getIndex(id);
+    mNodes[index] = node;
+    
+    // Start from the current position, in case the body returns to its last state before its first step
+    if (node) {
+        const sf::Transformable& transformable = node->getTransformable();
+        mPositionsX[index] = mLastPositionsX[index] = transformable.getPosition().x;
+        mPositionsY[index] = mLastPositionsY[index] = transformable.getPosition().y;
+        mLastTransforms[index] = LastTransform{ transformable.getRotation(), transformable.getScale(), transformable.getOrigin() };
+    }
+}
+
+void RigidBodyStore::setSimulated(int id, bool simulated)
+{
+    int index = getIndex(id);
+    assert(!simulated || mNodes[index]);
+    mSimulated[index] = simulated;
+}
+
+void RigidBodyStore::setVelocity(int id, const sf::Vector2f& velocity)
+{
+    int index = getIndex(id);
+    mVelocitiesX[index] = velocity.x;
+    mVelocitiesY[index] = velocity.y;
+}
+
+sf::Vector2f RigidBodyStore::getVelocity(int id) const
+{
+    int index = getIndex(id);
+    return sf::Vector2f(mVelocitiesX[index], mVelocitiesY[index]);
+}
+
+void RigidBodyStore::setForce(int id, const sf::Vector2f& force)
+{
+    int index = getIndex(id);
+    mForcesX[index] = force.x;
+    mForcesY[index] = force.y;
+}
+
+sf::Vector2f RigidBodyStore::getForce(int id) const
+{
+    int index = getIndex(id);
+    return sf::Vector2f(mForcesX[index], mForcesY[index]);
+}
+
+void RigidBodyStore::setMass(int id, float mass)
+{
+    assert(mass > 0);
+    mInverseMasses[getIndex(id)] = 1.f / mass;
+}
+
+float RigidBodyStore::getMass(int id) const
+{
+    return 1.f / mInverseMasses[getIndex(id)];
+}
+
+std::size_t RigidBodyStore::getBodyCount() const
+{
+    return mIds.size();
+}
+
+int RigidBodyStore::getIndex(int id) const
+{
+    assert(id >= 0 && id < (int)mIndices.size() && mIndices[id] != -1);
+    return mIndices[id];
+}
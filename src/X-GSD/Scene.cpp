@@ -12,17 +12,15 @@
 #include "ResourcePath.hpp"
 #include "ControllersRegistration.hpp" // Include here to avoid reference cycles
 
-#include <json/json.h>
-
+#include <unordered_set>
 #include <cassert>
 #include <stdexcept>
-#include <fstream>
 
 using namespace xgsd;
 
-Scene::Scene(sf::RenderWindow& window)
+Scene::Scene(sf::RenderWindow* window, const sf::View& view)
 : mWindow(window)
-, mSceneView(mWindow.getView())
+, mSceneView(view)
 , mName("")
 , mSceneGraph(new SceneGraphNode)
 , mPhysicsEngine(Game::instance().getPhysicsEngine())
@@ -35,96 +33,82 @@ Scene::Scene(sf::RenderWindow& window)
 {
     // Load resources here (RAII)
     
-    mTransitionFadingRectangle.setSize(sf::Vector2f(mWindow.getSize().x, mWindow.getSize().y));
+    mTransitionFadingRectangle.setSize(mSceneView.getSize());
+    
+    // Progress of the next scene, shown while it is loaded after the fade-out
+    mTransitionLoadingBar.setSize(sf::Vector2f(0.f, 4.f));
+    mTransitionLoadingBar.setPosition(mSceneView.getSize().x / 4.f, mSceneView.getSize().y * 0.9f);
+    mTransitionLoadingBar.setFillColor(sf::Color::White);
 }
 
-// TODO: Prefab loading
-void Scene::readJsonSceneFile(std::string jsonPath)
+/* Creates the resources, the entities and the prefabs of a scene loaded by the SceneLoader. Everything which
+ could be done on other threads (parsing, decoding and packing) is already done, so only what needs the graphics
+ and audio contexts or the scene itself is left. The entities and prefabs are created from the records of the
+ compiled scene file, which were checked when loaded. */
+void Scene::loadScene(SceneLoader::LoadedScene& scene)
 {
-    Json::Value root;   // will contains the root value after parsing
-    Json::Reader reader;
-    
-    DBGMSGC("Scene JSON file to parse: " << resourcePath() << jsonPath);
-    
-    std::ifstream jsonFile(resourcePath() + jsonPath, std::ifstream::binary);
-    
-    bool parsingSuccessful = reader.parse(jsonFile, root);
-    if ( !parsingSuccessful )
-    {
-        // report to the user the failure and their locations in the document.
-        throw std::runtime_error("Failed to parse file\n" + reader.getFormattedErrorMessages());
-    }
+    const SceneFile& file = scene.file;
+    const std::string& path = scene.path;
     
     
     ///////////////////////////////////////////////
     //  1.-  Fill scene info and load resources  //
     ///////////////////////////////////////////////
     
-    // Get the value of the member of root named 'name', return a "" string if there is no such member
-    std::string sceneName = root.get("name", "").asString();
-    DBGMSGC("Scene name: " << sceneName);
-    if (sceneName == "")
-        throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + resourcePath() + jsonPath + "  - No 'name' found");
-    
     // Fill the scene's member variables
-    mName = sceneName;
-    
-    // Get the value of the member of root named 'resources', return a 'null' value if
-    // there is no such member.
-    const Json::Value resources = root["resources"];
-    if (!resources)
-        DBGMSGC("No resources to load on this scene");
-    else {
-        
-        const Json::Value textures = resources["textures"];
+    mName = file.getName();
+    
+    // Resources which were loaded already (e.g. by the previous scene) are shared
+    for (auto& texture : scene.cachedTextures)
+        mTextureManager->insert(texture.first, texture.second);
+    for (auto& font : scene.cachedFonts)
+        mFontManager->insert(font.first, font.second);
+    for (auto& sound : scene.cachedSounds)
+        mSoundManager->insert(sound.first, sound.second);
+    
+    // Upload the decoded textures, which were checked and packed by the loader
+    for (std::size_t i = 0; i < scene.textureFiles.size(); ++i)
+        mTextureManager->loadFromImage(scene.textureFiles[i].name, scene.textures[i]);
+    
+    std::vector<std::string> atlasNames;
+    for (auto& file : scene.atlasFiles)
+        atlasNames.push_back(file.name);
+    
+    mTextureManager->loadAtlas(atlasNames, scene.atlasImages, scene.atlasLayout);
+    
+    for (auto& file : scene.textureFiles)
+        mTextureManager->addToCache(file.name, file.path, file.hash);
+    for (auto& file : scene.atlasFiles)
+        mTextureManager->addToCache(file.name, file.path, file.hash);
+    
+    // Fonts are ready, and sounds only need their buffer. In placeholder mode they are checked by their managers
+    for (std::size_t i = 0; i < scene.fontFiles.size(); ++i) {
+        const SceneLoader::File& file = scene.fontFiles[i];
         
-        // Iterate through textures
-        for (auto texture : textures) {
-            
-            std::string name = texture.get("name", "").asString();
-            std::string path = texture.get("path", "").asString();
-            
-            if (name == "")
-                throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + resourcePath() + jsonPath + "  - No 'name' (textures) found");
-            if (path == "")
-                throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + resourcePath() + jsonPath + "  - No 'path' (textures) found");
-            
-            // Load texture into the scene's texture manager
-            mTextureManager->load(name, path);
+        if (scene.placeholderMode) {
+            mFontManager->load(file.name, file.path);
+            continue;
         }
         
-        const Json::Value fonts = resources["fonts"];
+        mFontManager->insert(file.name, std::move(scene.fonts[i]));
+        mFontManager->addToCache(file.name, file.path, file.hash);
+    }
+    
+    for (std::size_t i = 0; i < scene.soundFiles.size(); ++i) {
+        const SceneLoader::File& file = scene.soundFiles[i];
+        const SceneLoader::SoundData& sound = scene.sounds[i];
         
-        // Iterate through fonts
-        for (auto iter = fonts.begin(); iter != fonts.end(); iter++) {
-            
-            std::string name = iter->get("name", "").asString();
-            std::string path = iter->get("path", "").asString();
-            if (name == "")
-                throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + resourcePath() + jsonPath + "  - No 'name' (fonts) found");
-            if (path == "")
-                throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + resourcePath() + jsonPath + "  - No 'path' (fonts) found");
-            
-            // Load font into the scene's font manager
-            mFontManager->load(name, path);
+        if (scene.placeholderMode) {
+            mSoundManager->load(file.name, file.path);
+            continue;
         }
         
+        std::unique_ptr<sf::SoundBuffer> buffer(new sf::SoundBuffer());
+        if (!buffer->loadFromSamples(sound.samples.data(), sound.samples.size(), sound.channelCount, sound.sampleRate))
+            throw std::runtime_error("ResourceManager::load - Failed to load " + resourcePath() + file.path);
         
-        const Json::Value sounds = resources["sounds"];
-        
-        // Iterate through sounds
-        for (auto sound : sounds) {
-            
-            std::string name = sound.get("name", "").asString();
-            std::string path = sound.get("path", "").asString();
-            if (name == "")
-                throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + resourcePath() + jsonPath + "  - No 'name' (sounds) found");
-            if (path == "")
-                throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + resourcePath() + jsonPath + "  - No 'path' (sounds) found");
-            
-            // Load font into the scene's font manager
-            mSoundManager->load(name, path);
-        }
+        mSoundManager->insert(file.name, std::move(buffer));
+        mSoundManager->addToCache(file.name, file.path, file.hash);
     }
     
     ////////////////////////////////////////////
@@ -137,149 +121,28 @@ void Scene::readJsonSceneFile(std::string jsonPath)
     // Temporary map to store entity-parent names to check circle parent reference between entities (a.parent = b, b.parent = a)
     std::unordered_map<std::string, std::string> entitiyParentRelations;
     
+    // Names of the entities, which the prefabs can not take (see Scene::getPrefab and Entity::getEntityNamed)
+    std::unordered_set<std::string> entityNames;
+    
     // Register user-defined controllers
     ControllersRegistration controllersRegistration;
     controllersRegistration.registerControllers(mControllersManager);
     
     
-    // Get the value of the member of root named 'entities', return a 'null' value if there is no such member.
-    const Json::Value entities = root["entities"];
-    if (!entities)
-        throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + resourcePath() + jsonPath + "  - No 'entities' found");
-    
     // Iterate through entities
-    for (auto entity : entities) {
-        
-        std::string name = entity.get("name", "").asString();
-        if (name == "")
-            throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + resourcePath() + jsonPath + "  - No 'name' (entity) found");
-        
-        // Create the entity
-        Entity::Ptr newEntity(new Entity(name));
-        
-        // Set the Transformable
-        sf::Transformable newTransformable;
-        
-        const Json::Value transform = entity["transform"];
-        if (!transform.isNull()) {
-            
-            // If there is a "transform" in the JSON file, read its contents and use it. Else, keep the default transformable zeroed values
-            const Json::Value origin = transform["origin"];
-            const Json::Value position = transform["position"];
-            const Json::Value scale = transform["scale"];
-            const Json::Value rotation = transform["rotation"];
-            
-            
-            // Set the origin (from the JSON if any, or a default value)
-            if (!origin)
-                newTransformable.setOrigin(0, 0);
-            else
-                newTransformable.setOrigin(origin["x"].asFloat(), origin["y"].asFloat()); // TODO: Add relative to bounding box
-            
-            // Set the position (from the JSON if any, or a default value)
-            if (!position)
-                newTransformable.setPosition(0, 0);
-            else if (position["relative"].asBool())
-                newTransformable.setPosition(position["x"].asFloat() * mWindow.getView().getSize().x, position["y"].asFloat() * mWindow.getView().getSize().y); // TODO: Relative to the parent node instead of view
-            else
-                newTransformable.setPosition(position["x"].asFloat(), position["y"].asFloat());
-            
-            // Set the scale (from the JSON if any, or a default value)
-            if (!scale)
-                newTransformable.setScale(1, 1);
-            else
-                newTransformable.setScale(scale["x"].asFloat(), scale["y"].asFloat());
-            
-            // Set the rotation (from the JSON if any, or a default value)
-            if (!rotation)
-                newTransformable.setRotation(0);
-            else
-                newTransformable.setRotation(rotation.asFloat());
-        }
+    for (std::size_t i = 0; i < file.getEntityCount(); ++i) {
         
-        newEntity->mTransformable = newTransformable;
+        const SceneFile::EntityRecord& entity = file.getEntity(i);
+        std::string name = file.getString(entity.name);
+        entityNames.insert(name);
         
-        // Get the "components" JSON element of this entity
-        const Json::Value components = entity["components"];
-        
-        if (!components.isNull()) {
-            
-            // Look for a ComponentSprite. If it existis, create and add it to the entity.
-            const Json::Value sprite = components["ComponentSprite"];
-            
-            if (!sprite.isNull()) {
-                
-                bool globalTexture = sprite["globalTexture"].asBool();
-                std::string textureName = sprite.get("texture", "").asString();
-                
-                if (textureName == "")
-                    throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + resourcePath() + jsonPath + "  - No 'texture' found in 'ComponentSprite'");
-                
-                const Json::Value rect = sprite["textureRect"];
-                if (!rect) {
-                    Component::Ptr componentSprite(new ComponentSprite(globalTexture ? Game::instance().getGlobalTextureManager().get(textureName) : mTextureManager->get(textureName)));
-                    newEntity->addComponent(std::move(componentSprite));
-                }
-                else {
-                    sf::IntRect textureRect;
-                    
-                    textureRect.top = rect["top"].asInt();
-                    textureRect.left = rect["left"].asInt();
-                    textureRect.height = rect["height"].asInt();
-                    textureRect.width = rect["width"].asInt();
-                    
-                    Component::Ptr componentSprite(new ComponentSprite(globalTexture ? Game::instance().getGlobalTextureManager().get(textureName) : mTextureManager->get(textureName), textureRect));
-                    newEntity->addComponent(std::move(componentSprite));
-                }
-            }
-            
-            // Look for a ComponentCollider. If it existis, create and add it to the entity.
-            const Json::Value collider = components["ComponentCollider"];
-            if (!collider.isNull()) {
-                
-                const Json::Value rect = collider["boundsRect"];
-                sf::FloatRect boundsRect;
-                
-                if (!rect) {
-                    boundsRect = sf::FloatRect(0, 0, 0, 0);
-                }
-                else {
-                    boundsRect.top = rect["top"].asFloat();
-                    boundsRect.left = rect["left"].asFloat();
-                    boundsRect.height = rect["height"].asFloat();
-                    boundsRect.width = rect["width"].asFloat();
-                }
-                
-                Component::Ptr componentCollider(new ComponentCollider(boundsRect));
-                newEntity->addComponent(std::move(componentCollider));
-            }
-            
-            // Look for a ComponentRigidBody. If it existis, create and add it to the entity.
-            const Json::Value rigidBody = components["ComponentRigidBody"];
-            if (!rigidBody.isNull()) {
-                
-                bool kinematic = rigidBody["kinematic"].asBool();
-                Component::Ptr componentRigidBody(new ComponentRigidBody(kinematic));
-                newEntity->addComponent(std::move(componentRigidBody));
-            }
-            
-            // Look for a list of user-defined controllers
-            const Json::Value controllers = components["controllers"];
-            
-            // Iterate through controllers
-            for (auto controller : controllers) {
-                
-                // TODO: Define a way of loading controller-specific values, i.e: number of lives, speed or jump height. It may be implemented with a map from string to... any? or to string and parse to int/float if needed?
-                std::string type = controller["type"].asString();
-                Component:: Ptr newController(mControllersManager.getController(type));
-                newEntity->addComponent(std::move(newController));
-            }
-            
-        } // End of components
+        // Create the entity, from a template of its record
+        Prefab entityTemplate(file, entity, *mTextureManager, mControllersManager, mSceneView.getSize());
+        Entity::Ptr newEntity = entityTemplate.instantiate(name);
         
         
         // And finally attach the entity to the scene's root node or the specified parent entity
-        std::string parentEntityName = entity.get("parentEntityName", "root").asString();
+        std::string parentEntityName = entity.parentName == SceneFile::NoString ? "root" : file.getString(entity.parentName);
         
         if (parentEntityName == "root")
             mSceneGraph->requestAttach(std::move(newEntity));
@@ -302,6 +165,20 @@ void Scene::readJsonSceneFile(std::string jsonPath)
     } // End of entities loop
     
     
+    // Prefabs, resolved once to be instantiated while the scene is loaded
+    for (std::size_t i = 0; i < file.getPrefabCount(); ++i) {
+        
+        Prefab prefab(file, file.getPrefab(i), *mTextureManager, mControllersManager, mSceneView.getSize());
+        std::string name = prefab.getName();
+        
+        if (entityNames.count(name))
+            throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + resourcePath() + path + "  - Prefab with the name of an entity: [" + name + "]");
+        
+        if (!mPrefabs.emplace(name, std::move(prefab)).second)
+            throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + resourcePath() + path + "  - Duplicated prefab: [" + name + "]");
+    }
+    
+    
     /////////////////////////////////////////////////
     //  3.-  Perform final operations and checks   //
     /////////////////////////////////////////////////
@@ -325,11 +202,14 @@ void Scene::readJsonSceneFile(std::string jsonPath)
         std::string parentName = iter->second;
         
         if (entitiyParentRelations[parentName] == entityName)
-            throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + resourcePath() + jsonPath + "  - Circular parent reference: [" + entityName + "] parent is [" + parentName + "], and [" + parentName + "] parent is [" + entityName + "].");
+            throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + resourcePath() + path + "  - Circular parent reference: [" + entityName + "] parent is [" + parentName + "], and [" + parentName + "] parent is [" + entityName + "].");
     }
     
     // Ensure scene graph operations (attachments) get done
     mSceneGraph->performPendingSceneGraphOperations();
+    
+    // Static colliders have been inserted one by one during the attachments, build their tree again at once
+    mPhysicsEngine.rebuildStaticColliderTree();
 }
 
 
@@ -338,10 +218,40 @@ void Scene::addNode(SceneGraphNode::Ptr node)
     mSceneGraph->requestAttach(std::move(node));
 }
 
-void Scene::loadSceneFromFile(std::string jsonPath)
+// Prefabs live as long as the scene, so they can be looked up once (e.g. when a controller is attached)
+const Prefab& Scene::getPrefab(const std::string& name) const
 {
+    auto found = mPrefabs.find(name);
+    if (found == mPrefabs.end())
+        throw std::runtime_error("Scene::getPrefab - Prefab not found: " + name);
+    
+    return found->second;
+}
+
+/* Creates an entity from the prefab and adds it to the scene. It is attached with the pending scene graph
+ operations, until then it can still be set up through the returned pointer. */
+Entity* Scene::instantiate(const Prefab& prefab, const sf::Transformable& transformable)
+{
+    Entity::Ptr newEntity = prefab.instantiate(transformable);
+    Entity* entity = newEntity.get();
+    
+    addNode(std::move(newEntity));
+    
+    return entity;
+}
+
+// The scene (a JSON or a compiled scene file, see SceneFile) is loaded in the background while the transition fades out, and changed once both have finished
+void Scene::loadSceneFromFile(std::string path)
+{
+    // Already on its way
+    if (mSceneChangeRequest && path == mNextScenePath)
+        return;
+    
     mSceneChangeRequest = true;
-    mNextScenePath = jsonPath;
+    mNextScenePath = path;
+    
+    // Without a window there are only placeholders, which need no atlas
+    mSceneLoader.start(path, mWindow == nullptr, mWindow ? TextureManager::getAtlasPageSize() : 0);
     
     if (!mTransitionEnabled)
         performSceneChange();
@@ -349,33 +259,60 @@ void Scene::loadSceneFromFile(std::string jsonPath)
         mTransitionState = out;
 }
 
+// From 0 to 1, while a scene is being loaded
+float Scene::getLoadingProgress() const
+{
+    return mSceneLoader.getProgress();
+}
+
 void Scene::performSceneChange()
 {
+    // Wait for the loader, if it has not finished yet
+    std::unique_ptr<SceneLoader::LoadedScene> loadedScene = mSceneLoader.finish();
+    
+    // Keep the current scene's resources until the new scene is loaded, so that its managers find those they share in the cache
+    FontManager::Ptr previousFontManager = std::move(mFontManager);
+    TextureManager::Ptr previousTextureManager = std::move(mTextureManager);
+    SoundManager::Ptr previousSoundManager = std::move(mSoundManager);
+    
     // Unload current scene's resources, nodes, values, etc.
     unloadScene();
     
     // Load the new scene's resources, entities, etc.
-    readJsonSceneFile(mNextScenePath);
+    loadScene(*loadedScene);
     
     mNextScenePath = "";
 }
 
 void Scene::unloadScene()
 {
+    // The frames being drawn may use the resources of the scene
+    Game::instance().synchronizeRendering();
+    
     mName = "";
     
     // Reset the scene graph
     mSceneGraph.reset(new SceneGraphNode);
     
+    // The prefabs refer to the textures of the scene
+    mPrefabs.clear();
+    
+    // Remove the systems and the remaining world entities (those of the scene graph are already gone)
+    mWorld.clear();
+    
     // Reset resources managers
     mFontManager.reset(new FontManager);
     mTextureManager.reset(new TextureManager);
+    mTextureManager->setPlaceholderMode(mWindow == nullptr);
     mSoundManager.reset(new SoundManager);
     
 }
 
 void Scene::update(const HiResDuration &dt)
 {
+    // The transforms at the start of the step, to draw the nodes between them and the ones at its end
+    mSceneGraph->savePreviousTransforms();
+    
     if (mPaused)
         mSceneGraph->onPause(dt);
     
@@ -383,6 +320,8 @@ void Scene::update(const HiResDuration &dt)
     else if (!mSceneChangeRequest) {
         mPhysicsEngine.checkCollisions();
         mSceneGraph->update(dt);
+        mWorld.update(dt);
+        mPhysicsEngine.integrate(dt);
         mSceneGraph->performPendingSceneGraphOperations();
     }
     
@@ -391,13 +330,16 @@ void Scene::update(const HiResDuration &dt)
         updateTransition(dt);
 }
 
-void Scene::render()
+// Interpolation goes from the transforms at the start of the last step (0) to the current ones (1)
+void Scene::render(RenderCommandList& commands, float interpolation)
 {
     // If a scene change is requested, don't render (for safety)
+    assert(mWindow);
+    
     if (!mSceneChangeRequest)
-        mWindow.draw(*mSceneGraph);
+        mSceneGraph->draw(commands, sf::RenderStates::Default, interpolation);
     else if (mTransitionEnabled)
-        renderTransition();
+        renderTransition(commands);
 }
 
 void Scene::handleEvent(const Event &event)
@@ -448,6 +390,13 @@ void Scene::updateTransition(const HiResDuration &dt)
         case outFinished:
             mTransitionFadingRectangle.setFillColor(sf::Color::Black);
             
+            // Keep the screen black, showing the progress, until the next scene has been loaded. Headless games
+            // do not wait, so that the number of steps until the change does not depend on the loading time
+            if (mWindow && !mSceneLoader.isFinished()) {
+                mTransitionLoadingBar.setSize(sf::Vector2f(mSceneLoader.getProgress() * mSceneView.getSize().x / 2.f, mTransitionLoadingBar.getSize().y));
+                break;
+            }
+            
             // Load the next scene
             performSceneChange();
             
@@ -456,7 +405,7 @@ void Scene::updateTransition(const HiResDuration &dt)
     }
 }
 
-void Scene::renderTransition()
+void Scene::renderTransition(RenderCommandList& commands)
 {
     // Draw the mFadingRectangle according to transition state
     switch (mTransitionState) {
@@ -464,9 +413,12 @@ void Scene::renderTransition()
         case inFinished:
         case in:
         case out:
-            mWindow.draw(*mSceneGraph);
+            mSceneGraph->draw(commands, sf::RenderStates::Default);
         case outFinished:
-            mWindow.draw(mTransitionFadingRectangle);
+            commands.draw(mTransitionFadingRectangle);
+            
+            if (mSceneLoader.isLoading())
+                commands.draw(mTransitionLoadingBar);
             break;
     }
 }
@@ -0,0 +1,777 @@
+#include <X-GSD/SceneFile.hpp>
+#include <X-GSD/JsonReader.hpp>
+#include <X-GSD/Debug.hpp>
+
+#include <map>
+#include <initializer_list>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <utility>
+#include <cstring>
+#include <stdexcept>
+#include <cassert>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace xgsd;
+
+namespace {
+    
+    static_assert(sizeof(SceneFile::Header) % 4 == 0 && sizeof(SceneFile::ResourceRecord) % 4 == 0 &&
+                  sizeof(SceneFile::EntityRecord) % 4 == 0 && sizeof(SceneFile::ComponentRecord) % 4 == 0,
+                  "Records must be made of 32-bit fields, to be swapped on big-endian hosts");
+    
+    bool isLittleEndian()
+    {
+        const std::uint32_t one = 1;
+        return *reinterpret_cast<const unsigned char*>(&one) == 1;
+    }
+    
+    // Reverses the bytes of every 32-bit word, between little-endian files and big-endian hosts
+    void swapWords(char* data, std::size_t size)
+    {
+        for (std::size_t i = 0; i + 4 <= size; i += 4) {
+            std::swap(data[i], data[i + 3]);
+            std::swap(data[i + 1], data[i + 2]);
+        }
+    }
+    
+    // Every string is stored once, records refer to it by its offset
+    class StringTable
+    {
+    public:
+        std::uint32_t add(const std::string& string)
+        {
+            auto found = mOffsets.find(string);
+            if (found != mOffsets.end())
+                return found->second;
+            
+            std::uint32_t offset = (std::uint32_t)mData.size();
+            mData.insert(mData.end(), string.begin(), string.end());
+            mData.push_back('\0');
+            mOffsets[string] = offset;
+            
+            return offset;
+        }
+        
+        const std::vector<char>& getData() const { return mData; }
+    
+    private:
+        std::vector<char>                       mData;
+        std::map<std::string, std::uint32_t>    mOffsets;
+    };
+    
+    template <typename Record>
+    std::uint32_t appendRecords(std::vector<char>& data, const std::vector<Record>& records)
+    {
+        std::uint32_t offset = (std::uint32_t)data.size();
+        const char* begin = reinterpret_cast<const char*>(records.data());
+        data.insert(data.end(), begin, begin + records.size() * sizeof(Record));
+        
+        return offset;
+    }
+    
+    /* Builds the records of a scene while its JSON text is parsed (see JsonReader), so that no document is kept
+     in memory: each entity or prefab is compiled when its object ends. Prefabs are defined as entities, but
+     have no parent. Anything missing keeps the same default as when
+     scenes were read from their document, and strings are only accepted where strings are expected. */
+    class SceneJsonHandler : public JsonReader::Handler
+    {
+    public:
+        explicit SceneJsonHandler(const std::string& filename)
+        : mFilename(filename)
+        , mPath()
+        , mInArray()
+        , mKey()
+        , mHasResources(false)
+        , mHasEntities(false)
+        {
+        }
+        
+        virtual void beginObject()
+        {
+            if (at({ "entities", "[]" }) || at({ "prefabs", "[]" })) {
+                mEntity = PendingEntity();
+                mEntity.record = { SceneFile::NoString, SceneFile::NoString, SceneFile::NoFlags, { 0.f, 0.f }, { 0.f, 0.f }, { 1.f, 1.f }, 0.f, 0, 0 };
+                mEntity.parentName = "root";
+            }
+            else if (at({ "resources", "textures", "[]" }) || at({ "resources", "fonts", "[]" }) || at({ "resources", "sounds", "[]" }))
+                mResource = PendingResource{ "", "", true };
+            else if (atEntity({ "transform", "scale" }))
+                mEntity.record.scale[0] = mEntity.record.scale[1] = 0.f; // Missing coordinates are 0 once there is a scale
+            else if (atEntity({ "components", "ComponentSprite" }))
+                mEntity.hasSprite = true;
+            else if (atEntity({ "components", "ComponentSprite", "textureRect" }))
+                mEntity.sprite.flags |= SceneFile::HasTextureRect;
+            else if (atEntity({ "components", "ComponentCollider" }))
+                mEntity.hasCollider = true;
+            else if (atEntity({ "components", "ComponentRigidBody" }))
+                mEntity.hasRigidBody = true;
+            else if (atEntity({ "components", "controllers", "[]" }))
+                mEntity.controllers.push_back("");
+            else if (at({ "resources" }))
+                mHasResources = true;
+            else if (at({ "entities" }))
+                mHasEntities = true;
+            
+            beginContainer(false);
+        }
+        
+        virtual void endObject()
+        {
+            if (isIn({ "entities", "[]" }) || isIn({ "prefabs", "[]" }))
+                finishEntity(mPath[0] == "prefabs");
+            else if (isIn({ "resources", "textures", "[]" }))
+                finishResource(mResource.atlas ? SceneFile::AtlasTextureResource : SceneFile::TextureResource, "textures");
+            else if (isIn({ "resources", "fonts", "[]" }))
+                finishResource(SceneFile::FontResource, "fonts");
+            else if (isIn({ "resources", "sounds", "[]" }))
+                finishResource(SceneFile::SoundResource, "sounds");
+            
+            endContainer();
+        }
+        
+        virtual void beginArray()
+        {
+            if (at({ "entities" }))
+                mHasEntities = true;
+            
+            beginContainer(true);
+        }
+        
+        virtual void endArray()
+        {
+            endContainer();
+        }
+        
+        virtual void key(const std::string& name)
+        {
+            mKey = name;
+        }
+        
+        virtual void stringValue(const std::string& value)
+        {
+            scalarValue(Scalar{ Scalar::String, 0.0, false, &value });
+        }
+        
+        virtual void numberValue(double value)
+        {
+            scalarValue(Scalar{ Scalar::Number, value, false, nullptr });
+        }
+        
+        virtual void boolValue(bool value)
+        {
+            scalarValue(Scalar{ Scalar::Bool, 0.0, value, nullptr });
+        }
+        
+        virtual void nullValue()
+        {
+            scalarValue(Scalar{ Scalar::Null, 0.0, false, nullptr });
+        }
+        
+        // Checks what can only be checked at the end of the document
+        void finish()
+        {
+            DBGMSGC("Scene name: " << mSceneName);
+            if (mSceneName == "")
+                throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + mFilename + "  - No 'name' found");
+            
+            if (!mHasResources)
+                DBGMSGC("No resources to load on this scene");
+            
+            if (!mHasEntities)
+                throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + mFilename + "  - No 'entities' found");
+        }
+        
+        const std::string&                      getSceneName() const    { return mSceneName; }
+        StringTable&                            getStrings()            { return mStrings; }
+        const std::vector<SceneFile::ResourceRecord>& getResources() const { return mResources; }
+        const std::vector<SceneFile::EntityRecord>& getEntities() const { return mEntities; }
+        const std::vector<SceneFile::EntityRecord>& getPrefabs() const { return mPrefabs; }
+        const std::vector<SceneFile::ComponentRecord>& getComponents() const { return mComponents; }
+    
+    private:
+        struct Scalar
+        {
+            enum Type { Null, Bool, Number, String } type;
+            double              number;
+            bool                boolean;
+            const std::string*  string;
+        };
+        
+        struct PendingResource
+        {
+            std::string         name;
+            std::string         path;
+            bool                atlas;
+        };
+        
+        // The components are kept apart until the entity ends, to add them in the same order as always
+        struct PendingEntity
+        {
+            SceneFile::EntityRecord     record;
+            std::string                 name;
+            std::string                 parentName;
+            bool                        hasSprite = false;
+            bool                        hasCollider = false;
+            bool                        hasRigidBody = false;
+            std::string                 textureName;
+            SceneFile::ComponentRecord  sprite = SceneFile::ComponentRecord();
+            SceneFile::ComponentRecord  collider = SceneFile::ComponentRecord();
+            SceneFile::ComponentRecord  rigidBody = SceneFile::ComponentRecord();
+            std::vector<std::string>    controllers;
+        };
+        
+        void scalarValue(const Scalar& value)
+        {
+            SceneFile::EntityRecord& record = mEntity.record;
+            
+            if (at({ "name" }))
+                mSceneName = asString(value);
+            
+            // Resources
+            else if (isIn({ "resources", "textures", "[]" }) || isIn({ "resources", "fonts", "[]" }) || isIn({ "resources", "sounds", "[]" })) {
+                if (mKey == "name")
+                    mResource.name = asString(value);
+                else if (mKey == "path")
+                    mResource.path = asString(value);
+                else if (mKey == "atlas")
+                    mResource.atlas = asBool(value);
+            }
+            
+            // Entities
+            else if (atEntity({ "name" }))
+                mEntity.name = asString(value);
+            else if (atEntity({ "parentEntityName" })) {
+                // Prefabs are attached wherever they are instantiated, so a parent would be ignored
+                if (mPath[0] == "prefabs")
+                    throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + mFilename + "  - 'parentEntityName' is not allowed in prefabs");
+                
+                mEntity.parentName = asString(value);
+            }
+            else if (atEntity({ "transform", "origin", "x" }))
+                record.origin[0] = asFloat(value); // TODO: Add relative to bounding box
+            else if (atEntity({ "transform", "origin", "y" }))
+                record.origin[1] = asFloat(value);
+            else if (atEntity({ "transform", "position", "x" }))
+                record.position[0] = asFloat(value);
+            else if (atEntity({ "transform", "position", "y" }))
+                record.position[1] = asFloat(value);
+            else if (atEntity({ "transform", "position", "relative" })) {
+                // Resolved with the size of the view when instantiated. TODO: Relative to the parent node instead of view
+                if (asBool(value))
+                    record.flags |= SceneFile::RelativePosition;
+                else
+                    record.flags &= ~SceneFile::RelativePosition;
+            }
+            else if (atEntity({ "transform", "scale", "x" }))
+                record.scale[0] = asFloat(value);
+            else if (atEntity({ "transform", "scale", "y" }))
+                record.scale[1] = asFloat(value);
+            else if (atEntity({ "transform", "rotation" }))
+                record.rotation = asFloat(value);
+            
+            // Components
+            else if (atEntity({ "components", "ComponentSprite", "texture" }))
+                mEntity.textureName = asString(value);
+            else if (atEntity({ "components", "ComponentSprite", "globalTexture" }))
+                setFlag(mEntity.sprite.flags, SceneFile::GlobalTexture, asBool(value));
+            else if (isInEntity({ "components", "ComponentSprite", "textureRect" }))
+                setRectValue(mEntity.sprite.textureRect, value);
+            else if (isInEntity({ "components", "ComponentCollider", "boundsRect" }))
+                setRectValue(mEntity.collider.boundsRect, value);
+            else if (atEntity({ "components", "ComponentCollider", "categoryBits" })) {
+                // The collision layers, if any (otherwise the default ones are kept)
+                setFlag(mEntity.collider.flags, SceneFile::HasCategoryBits, asCollisionBits(value, mEntity.collider.categoryBits));
+            }
+            else if (atEntity({ "components", "ComponentCollider", "maskBits" }))
+                setFlag(mEntity.collider.flags, SceneFile::HasMaskBits, asCollisionBits(value, mEntity.collider.maskBits));
+            else if (atEntity({ "components", "ComponentRigidBody", "kinematic" }))
+                setFlag(mEntity.rigidBody.flags, SceneFile::Kinematic, asBool(value));
+            else if (atEntity({ "components", "controllers", "[]", "type" }))
+                mEntity.controllers.back() = asString(value);
+        }
+        
+        void finishResource(SceneFile::ResourceType type, const std::string& kind)
+        {
+            if (mResource.name == "")
+                throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + mFilename + "  - No 'name' (" + kind + ") found");
+            if (mResource.path == "")
+                throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + mFilename + "  - No 'path' (" + kind + ") found");
+            
+            mResources.push_back(SceneFile::ResourceRecord{ (std::uint32_t)type, mStrings.add(mResource.name), mStrings.add(mResource.path) });
+        }
+        
+        void finishEntity(bool prefab)
+        {
+            SceneFile::EntityRecord& record = mEntity.record;
+            
+            if (mEntity.name == "")
+                throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + mFilename + "  - No 'name' (" + (prefab ? "prefab" : "entity") + ") found");
+            
+            record.name = mStrings.add(mEntity.name);
+            
+            // The parent is looked up by name when instantiated. Prefabs are attached wherever they are instantiated
+            if (mEntity.parentName != "root" && !prefab)
+                record.parentName = mStrings.add(mEntity.parentName);
+            
+            // The components are added in this order: sprite, collider, rigid body and controllers
+            record.firstComponent = (std::uint32_t)mComponents.size();
+            
+            if (mEntity.hasSprite) {
+                if (mEntity.textureName == "")
+                    throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + mFilename + "  - No 'texture' found in 'ComponentSprite'");
+                
+                mEntity.sprite.type = SceneFile::SpriteComponent;
+                mEntity.sprite.string = mStrings.add(mEntity.textureName);
+                mComponents.push_back(mEntity.sprite);
+            }
+            
+            if (mEntity.hasCollider) {
+                mEntity.collider.type = SceneFile::ColliderComponent;
+                mEntity.collider.string = SceneFile::NoString;
+                mComponents.push_back(mEntity.collider);
+            }
+            
+            if (mEntity.hasRigidBody) {
+                mEntity.rigidBody.type = SceneFile::RigidBodyComponent;
+                mEntity.rigidBody.string = SceneFile::NoString;
+                mComponents.push_back(mEntity.rigidBody);
+            }
+            
+            // User-defined controllers, created by type with the ControllersManager
+            for (const std::string& type : mEntity.controllers) {
+                SceneFile::ComponentRecord controller = SceneFile::ComponentRecord();
+                controller.type = SceneFile::ControllerComponent;
+                controller.string = mStrings.add(type);
+                mComponents.push_back(controller);
+            }
+            
+            record.componentCount = (std::uint32_t)mComponents.size() - record.firstComponent;
+            (prefab ? mPrefabs : mEntities).push_back(record);
+        }
+        
+        // Left, top, width and height
+        template <typename T>
+        void setRectValue(T (&rect)[4], const Scalar& value)
+        {
+            if (mKey == "left")
+                rect[0] = (T)asNumber(value);
+            else if (mKey == "top")
+                rect[1] = (T)asNumber(value);
+            else if (mKey == "width")
+                rect[2] = (T)asNumber(value);
+            else if (mKey == "height")
+                rect[3] = (T)asNumber(value);
+        }
+        
+        static void setFlag(std::uint32_t& flags, SceneFile::RecordFlags flag, bool set)
+        {
+            flags = set ? (flags | flag) : (flags & ~flag);
+        }
+        
+        double asNumber(const Scalar& value) const
+        {
+            if (value.type == Scalar::String)
+                throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + mFilename + "  - '" + mKey + "' must be a number");
+            
+            return value.type == Scalar::Number ? value.number : value.type == Scalar::Bool && value.boolean ? 1.0 : 0.0;
+        }
+        
+        float asFloat(const Scalar& value) const
+        {
+            return (float)asNumber(value);
+        }
+        
+        bool asBool(const Scalar& value) const
+        {
+            if (value.type == Scalar::String)
+                throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + mFilename + "  - '" + mKey + "' must be a boolean");
+            
+            return value.type == Scalar::Bool ? value.boolean : value.type == Scalar::Number && value.number != 0.0;
+        }
+        
+        std::string asString(const Scalar& value) const
+        {
+            if (value.type != Scalar::String && value.type != Scalar::Null)
+                throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + mFilename + "  - '" + mKey + "' must be a string");
+            
+            return value.type == Scalar::String ? *value.string : std::string();
+        }
+        
+        // Collision layers are 16 bits. Values which are not numbers are ignored, so that the default ones are kept
+        bool asCollisionBits(const Scalar& value, std::uint32_t& bits) const
+        {
+            bits = 0;
+            
+            if (value.type != Scalar::Number)
+                return false;
+            
+            if (!(value.number >= 0.0 && value.number <= 65535.0) || value.number != (double)(std::uint32_t)value.number)
+                throw std::runtime_error("SceneManager::loadSceneFromFile - Failed to load " + mFilename + "  - '" + mKey + "' must be an integer from 0 to 65535");
+            
+            bits = (std::uint32_t)value.number;
+            return true;
+        }
+        
+        ////// PATHS //////
+        
+        // Name of the current value in its container: its key, or "[]" in arrays ("" for the document itself)
+        const char* currentName() const
+        {
+            return mInArray.empty() ? "" : mInArray.back() ? "[]" : mKey.c_str();
+        }
+        
+        void beginContainer(bool array)
+        {
+            if (!mInArray.empty())
+                mPath.push_back(currentName());
+            mInArray.push_back(array);
+        }
+        
+        void endContainer()
+        {
+            mInArray.pop_back();
+            if (!mInArray.empty())
+                mPath.pop_back();
+        }
+        
+        // If the current value is at the path, from the document
+        bool at(std::initializer_list<const char*> path) const
+        {
+            return matches(0, path, true);
+        }
+        
+        // If the current value is at the path, from the entity object
+        bool atEntity(std::initializer_list<const char*> path) const
+        {
+            return isEntity() && matches(2, path, true);
+        }
+        
+        // If the current value is inside the container at the path, from the document
+        bool isIn(std::initializer_list<const char*> path) const
+        {
+            return matches(0, path, false);
+        }
+        
+        bool isInEntity(std::initializer_list<const char*> path) const
+        {
+            return isEntity() && matches(2, path, false);
+        }
+        
+        bool isEntity() const
+        {
+            return mPath.size() >= 2 && (mPath[0] == "entities" || mPath[0] == "prefabs") && mPath[1] == "[]";
+        }
+        
+        bool matches(std::size_t first, std::initializer_list<const char*> path, bool withCurrent) const
+        {
+            if (mPath.size() + (withCurrent ? 1 : 0) != first + path.size())
+                return false;
+            
+            auto expected = path.begin();
+            for (std::size_t i = first; i < mPath.size(); ++i)
+                if (mPath[i] != *expected++)
+                    return false;
+            
+            return !withCurrent || std::strcmp(currentName(), *expected) == 0;
+        }
+    
+    private:
+        std::string                             mFilename;
+        std::vector<std::string>                mPath;      // Names of the enclosing containers but the document
+        std::vector<bool>                       mInArray;   // For every enclosing container
+        std::string                             mKey;
+        
+        std::string                             mSceneName;
+        bool                                    mHasResources;
+        bool                                    mHasEntities;
+        PendingResource                         mResource;
+        PendingEntity                           mEntity;
+        
+        StringTable                             mStrings;
+        std::vector<SceneFile::ResourceRecord>  mResources;
+        std::vector<SceneFile::EntityRecord>    mEntities;
+        std::vector<SceneFile::EntityRecord>    mPrefabs;
+        std::vector<SceneFile::ComponentRecord> mComponents;
+    };
+    
+} // anonymous namespace
+
+SceneFile::SceneFile()
+: mOwnedData()
+, mData(nullptr)
+, mSize(0)
+, mMapping(nullptr)
+, mHeader(nullptr)
+, mResources(nullptr)
+, mEntities(nullptr)
+, mPrefabs(nullptr)
+, mComponents(nullptr)
+, mStrings(nullptr)
+{
+    // Load resources here (RAII)
+}
+
+SceneFile::~SceneFile()
+{
+    // Cleanup
+    unmap();
+}
+
+/* Maps a compiled file (full path), or reads it where files are not mapped: on Windows, and on big-endian
+ hosts, which need to swap it. */
+void SceneFile::loadFromFile(const std::string& filename)
+{
+    unmap();
+
+#ifndef _WIN32
+    if (isLittleEndian()) {
+        int file = open(filename.c_str(), O_RDONLY);
+        if (file < 0)
+            throw std::runtime_error("SceneFile::loadFromFile - Failed to load " + filename);
+        
+        struct stat status;
+        if (fstat(file, &status) == 0 && status.st_size > 0) {
+            void* mapping = mmap(nullptr, (std::size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+            
+            if (mapping != MAP_FAILED) {
+                mMapping = mapping;
+                mData = static_cast<const char*>(mapping);
+                mSize = (std::size_t)status.st_size;
+            }
+        }
+        close(file);
+        
+        if (mMapping) {
+            mOwnedData.clear();
+            check(filename);
+            return;
+        }
+    }
+#endif
+    
+    std::ifstream file(filename, std::ifstream::binary);
+    if (!file)
+        throw std::runtime_error("SceneFile::loadFromFile - Failed to load " + filename);
+    
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    takeData(std::move(data), filename);
+}
+
+/* Takes a file compiled in memory (see compile). */
+void SceneFile::loadFromMemory(std::vector<char> data)
+{
+    unmap();
+    takeData(std::move(data), "(compiled in memory)");
+}
+
+const char* SceneFile::getName() const
+{
+    return getString(mHeader->name);
+}
+
+std::size_t SceneFile::getResourceCount() const
+{
+    return mHeader->resourceCount;
+}
+
+const SceneFile::ResourceRecord& SceneFile::getResource(std::size_t index) const
+{
+    assert(index < mHeader->resourceCount);
+    return mResources[index];
+}
+
+std::size_t SceneFile::getEntityCount() const
+{
+    return mHeader->entityCount;
+}
+
+const SceneFile::EntityRecord& SceneFile::getEntity(std::size_t index) const
+{
+    assert(index < mHeader->entityCount);
+    return mEntities[index];
+}
+
+std::size_t SceneFile::getPrefabCount() const
+{
+    return mHeader->prefabCount;
+}
+
+const SceneFile::EntityRecord& SceneFile::getPrefab(std::size_t index) const
+{
+    assert(index < mHeader->prefabCount);
+    return mPrefabs[index];
+}
+
+const SceneFile::ComponentRecord& SceneFile::getComponent(std::size_t index) const
+{
+    assert(index < mHeader->componentCount);
+    return mComponents[index];
+}
+
+// The string at the offset, or an empty one for NoString
+const char* SceneFile::getString(std::uint32_t offset) const
+{
+    return offset == NoString ? "" : mStrings + offset;
+}
+
+/* Compiles a scene from its JSON text, without building its document: the records are written as the text is
+ parsed. The filename is only used in the error messages, which are the same as when scenes were read from
+ their document. */
+std::vector<char> SceneFile::compile(const char* begin, const char* end, const std::string& filename)
+{
+    SceneJsonHandler handler(filename);
+    JsonReader reader;
+    
+    if (!reader.parse(begin, end, handler)) {
+        // report to the user the failure and their locations in the document.
+        throw std::runtime_error("Failed to parse file\n" + reader.getFormattedErrorMessages());
+    }
+    
+    handler.finish();
+    
+    StringTable& strings = handler.getStrings();
+    
+    Header header = Header();
+    header.magic = Magic;
+    header.version = Version;
+    header.name = strings.add(handler.getSceneName());
+    
+    // Header, records and strings, in this order
+    std::vector<char> data(sizeof(Header));
+    
+    header.resourceCount = (std::uint32_t)handler.getResources().size();
+    header.resourceOffset = appendRecords(data, handler.getResources());
+    header.entityCount = (std::uint32_t)handler.getEntities().size();
+    header.entityOffset = appendRecords(data, handler.getEntities());
+    header.prefabCount = (std::uint32_t)handler.getPrefabs().size();
+    header.prefabOffset = appendRecords(data, handler.getPrefabs());
+    header.componentCount = (std::uint32_t)handler.getComponents().size();
+    header.componentOffset = appendRecords(data, handler.getComponents());
+    header.stringsSize = (std::uint32_t)strings.getData().size();
+    header.stringsOffset = (std::uint32_t)data.size();
+    
+    if (data.size() + strings.getData().size() > 0xFFFFFFFFull)
+        throw std::runtime_error("SceneFile::compile - " + filename + " is too big to be compiled");
+    
+    std::memcpy(data.data(), &header, sizeof(Header));
+    
+    if (!isLittleEndian())
+        swapWords(data.data(), data.size());
+    
+    data.insert(data.end(), strings.getData().begin(), strings.getData().end());
+    
+    return data;
+}
+
+void SceneFile::takeData(std::vector<char> data, const std::string& filename)
+{
+    mOwnedData.swap(data);
+    mData = mOwnedData.data();
+    mSize = mOwnedData.size();
+    
+    if (!isLittleEndian() && mSize >= sizeof(Header)) {
+        // The header tells where the records end
+        swapWords(mOwnedData.data(), sizeof(Header));
+        std::size_t recordsEnd = std::min<std::size_t>(reinterpret_cast<const Header*>(mData)->stringsOffset, mSize);
+        swapWords(mOwnedData.data() + sizeof(Header), recordsEnd - std::min(recordsEnd, sizeof(Header)));
+    }
+    
+    check(filename);
+}
+
+void SceneFile::check(const std::string& filename)
+{
+    if (mSize < sizeof(Header))
+        throw std::runtime_error("SceneFile::load - " + filename + " is not a compiled scene");
+    
+    mHeader = reinterpret_cast<const Header*>(mData);
+    
+    if (mHeader->magic != Magic)
+        throw std::runtime_error("SceneFile::load - " + filename + " is not a compiled scene");
+    if (mHeader->version != Version)
+        throw std::runtime_error("SceneFile::load - " + filename + " was compiled with version " + std::to_string(mHeader->version) + " of the format, instead of " + std::to_string(Version) + " - Compile it again");
+    
+    // Every table must be word-aligned, and fit in the file
+    auto checkTable = [this, &filename] (std::uint64_t offset, std::uint64_t count, std::uint64_t recordSize) {
+        if (offset % 4 != 0 || offset + count * recordSize > mSize)
+            throw std::runtime_error("SceneFile::load - " + filename + " is corrupt");
+    };
+    
+    checkTable(mHeader->resourceOffset, mHeader->resourceCount, sizeof(ResourceRecord));
+    checkTable(mHeader->entityOffset, mHeader->entityCount, sizeof(EntityRecord));
+    checkTable(mHeader->prefabOffset, mHeader->prefabCount, sizeof(EntityRecord));
+    checkTable(mHeader->componentOffset, mHeader->componentCount, sizeof(ComponentRecord));
+    checkTable(mHeader->stringsOffset, mHeader->stringsSize, 1);
+    
+    mResources = reinterpret_cast<const ResourceRecord*>(mData + mHeader->resourceOffset);
+    mEntities = reinterpret_cast<const EntityRecord*>(mData + mHeader->entityOffset);
+    mPrefabs = reinterpret_cast<const EntityRecord*>(mData + mHeader->prefabOffset);
+    mComponents = reinterpret_cast<const ComponentRecord*>(mData + mHeader->componentOffset);
+    mStrings = mData + mHeader->stringsOffset;
+    
+    // So that no string runs past the table
+    if (mHeader->stringsSize == 0 || mStrings[mHeader->stringsSize - 1] != '\0')
+        throw std::runtime_error("SceneFile::load - " + filename + " is corrupt");
+    
+    checkString(mHeader->name, filename);
+    
+    for (std::size_t i = 0; i < mHeader->resourceCount; ++i) {
+        if (mResources[i].type > SoundResource)
+            throw std::runtime_error("SceneFile::load - " + filename + " is corrupt");
+        
+        checkString(mResources[i].name, filename);
+        checkString(mResources[i].path, filename);
+    }
+    
+    // Prefabs are checked as entities
+    for (std::size_t i = 0; i < (std::size_t)mHeader->entityCount + mHeader->prefabCount; ++i) {
+        const EntityRecord& entity = i < mHeader->entityCount ? mEntities[i] : mPrefabs[i - mHeader->entityCount];
+        
+        checkString(entity.name, filename);
+        if (entity.parentName != NoString)
+            checkString(entity.parentName, filename);
+        
+        if ((std::uint64_t)entity.firstComponent + entity.componentCount > mHeader->componentCount)
+            throw std::runtime_error("SceneFile::load - " + filename + " is corrupt");
+    }
+    
+    for (std::size_t i = 0; i < mHeader->componentCount; ++i) {
+        const ComponentRecord& component = mComponents[i];
+        
+        if (component.type > ControllerComponent)
+            throw std::runtime_error("SceneFile::load - " + filename + " is corrupt");
+        
+        if (component.type == SpriteComponent || component.type == ControllerComponent)
+            checkString(component.string, filename);
+        
+        // Collision layers are 16 bits (see ComponentCollider)
+        if (component.type == ColliderComponent && (component.categoryBits > 0xFFFF || component.maskBits > 0xFFFF))
+            throw std::runtime_error("SceneFile::load - " + filename + " is corrupt");
+    }
+}
+
+void SceneFile::checkString(std::uint32_t offset, const std::string& filename) const
+{
+    if (offset >= mHeader->stringsSize)
+        throw std::runtime_error("SceneFile::load - " + filename + " is corrupt");
+}
+
+void SceneFile::unmap()
+{
+#ifndef _WIN32
+    if (mMapping)
+        munmap(mMapping, mSize);
+#endif
+    
+    mMapping = nullptr;
+    mData = nullptr;
+    mSize = 0;
+}
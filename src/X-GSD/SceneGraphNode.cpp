@@ -5,15 +5,30 @@
 using namespace xgsd;
 
 SceneGraphNode::SceneGraphNode()
-: mChildren()
+: mTransformable()
+, mPreviousTransformable()
+, mWorldTransform()
+, mWorldTransformDirty(true)
+, mChildren()
 , mParent(nullptr)
-, mTransformable()
+, mIndexInParent(0)
 , mPendingDetachments()
 , mPendingDestruction(false)
 {
     // Load resources here (RAII)
 }
 
+void* SceneGraphNode::operator new(std::size_t size)
+{
+    return PoolAllocator::allocate(size);
+}
+
+// Called with the size of the most derived class, as the destructor is virtual
+void SceneGraphNode::operator delete(void* pointer, std::size_t size)
+{
+    PoolAllocator::deallocate(pointer, size);
+}
+
 void SceneGraphNode::requestAttach(Ptr child)
 {
     mPendingAttachments.push_back(std::move(child));
@@ -42,10 +57,26 @@ void SceneGraphNode::performPendingSceneGraphOperations()
     }
     mPendingAttachments.clear();
     
-    for (auto nodeIter = mPendingDetachments.begin(); nodeIter != mPendingDetachments.end(); ++nodeIter) {
-        detachChild(**nodeIter);
+    if (!mPendingDetachments.empty()) {
+        // Those requested while detaching are left for the next time
+        PooledVector<SceneGraphNode*> detachments;
+        detachments.swap(mPendingDetachments);
+        
+        // Notify every child first, while the children are still in place (onDetach may go through the scene graph)
+        for (SceneGraphNode* child : detachments)
+            child->onDetach();
+        
+        // Take them out and remove their slots at once, instead of shifting the children for each of them
+        PooledVector<Ptr> detachedChildren;
+        detachedChildren.reserve(detachments.size());
+        
+        for (SceneGraphNode* child : detachments)
+            detachedChildren.push_back(detachChild(*child));
+        
+        removeDetachedChildren();
+        
+        // The detached children are destroyed here, once the scene graph is consistent again (their destructors may broadcast events)
     }
-    mPendingDetachments.clear();
     
     if (mPendingDestruction) {
         destroy();
@@ -55,27 +86,50 @@ void SceneGraphNode::performPendingSceneGraphOperations()
 void SceneGraphNode::attachChild(Ptr child)
 {
     child->mParent = this;
+    child->mIndexInParent = mChildren.size();
+    child->markWorldTransformDirty();
+    child->savePreviousTransforms(); // Nodes are drawn where they are attached, not interpolated from where they were created
     child->onAttach();
     mChildren.push_back(std::move(child));
 }
 
+/* Takes the child out in constant time, found by its index. Its slot is left empty until removeDetachedChildren
+ is called, which must be done before anything else goes through the children. The child must have been
+ notified with onDetach already. */
 SceneGraphNode::Ptr SceneGraphNode::detachChild(SceneGraphNode& child)
 {
-    auto found = std::find_if(mChildren.begin(), mChildren.end(), [&] (Ptr& p) { return p.get() == &child; });
-    assert(found != mChildren.end());
-    
-    child.onDetach();
+    assert(child.mIndexInParent < mChildren.size() && mChildren[child.mIndexInParent].get() == &child && "Attempted to detach a node which is not a child of this one, or twice");
     
-    Ptr result = std::move(*found);
+    Ptr result = std::move(mChildren[child.mIndexInParent]);
     result->mParent = nullptr;
-    mChildren.erase(found);
+    result->markWorldTransformDirty();
     return result;
 }
 
+// Removes the empty slots of the detached children in one pass, keeping the order of the others (their drawing order)
+void SceneGraphNode::removeDetachedChildren()
+{
+    std::size_t count = 0;
+    
+    for (std::size_t i = 0; i < mChildren.size(); ++i) {
+        if (!mChildren[i])
+            continue;
+        
+        if (count != i)
+            mChildren[count] = std::move(mChildren[i]);
+        
+        mChildren[count]->mIndexInParent = count;
+        ++count;
+    }
+    
+    mChildren.resize(count);
+}
+
 void SceneGraphNode::destroy()
 {
     assert(mParent && "Attempted to destroy the root scene graph node, or a node which has not been attached as a child of another yet!");
-    this->mChildren.clear();
+    
+    // The children are destroyed with this node once it is detached, so they are notified with onDetach too
     mParent->requestDetach(this);
     this->mParent = nullptr;
 }
@@ -111,7 +165,7 @@ void SceneGraphNode::onDetachThis()
 void SceneGraphNode::onDetachChildren()
 {
     for(Ptr& child : mChildren)
-        child->onAttach();
+        child->onDetach();
 }
 
 
@@ -149,25 +203,53 @@ void SceneGraphNode::updateChildren(const HiResDuration& dt)
         child->update(dt);
 }
 
-void SceneGraphNode::draw(sf::RenderTarget& target, sf::RenderStates states) const
+// Draws the nodes at alpha between their previous transform (0) and their current one (1)
+void SceneGraphNode::draw(RenderCommandList& target, sf::RenderStates states, float alpha) const
 {
     // Apply transform of current node
-    states.transform *= mTransformable.getTransform();
+    states.transform *= getInterpolatedTransform(alpha);
     
     // Draw node and children with changed transform
     drawThis(target, states);
-    drawChildren(target, states);
+    drawChildren(target, states, alpha);
 }
 
-void SceneGraphNode::drawThis(sf::RenderTarget& target, sf::RenderStates states) const
+void SceneGraphNode::drawThis(RenderCommandList& target, sf::RenderStates states) const
 {
     // Do nothing by default. Override this on a derived class or a custom Component controller
 }
 
-void SceneGraphNode::drawChildren(sf::RenderTarget& target, sf::RenderStates states) const
+void SceneGraphNode::drawChildren(RenderCommandList& target, sf::RenderStates states, float alpha) const
 {
     for(const Ptr& child : mChildren)
-        child->draw(target, states);
+        child->draw(target, states, alpha);
+}
+
+sf::Transform SceneGraphNode::getInterpolatedTransform(float alpha) const
+{
+    const sf::Transformable& previous = mPreviousTransformable;
+    const sf::Transformable& current = mTransformable;
+    
+    // Nodes which did not change during the last step (most of them) need no interpolation
+    if (alpha >= 1.f || (previous.getPosition() == current.getPosition() && previous.getRotation() == current.getRotation()
+                         && previous.getScale() == current.getScale() && previous.getOrigin() == current.getOrigin()))
+        return current.getTransform();
+    
+    // Rotate along the shortest arc, so that going from 350 to 10 degrees does not turn the other way around
+    float rotation = current.getRotation() - previous.getRotation();
+    
+    if (rotation > 180.f)
+        rotation -= 360.f;
+    else if (rotation < -180.f)
+        rotation += 360.f;
+    
+    sf::Transformable interpolated;
+    interpolated.setPosition(previous.getPosition() + (current.getPosition() - previous.getPosition()) * alpha);
+    interpolated.setRotation(previous.getRotation() + rotation * alpha);
+    interpolated.setScale(previous.getScale() + (current.getScale() - previous.getScale()) * alpha);
+    interpolated.setOrigin(previous.getOrigin() + (current.getOrigin() - previous.getOrigin()) * alpha);
+    
+    return interpolated.getTransform();
 }
 
 void SceneGraphNode::handleEvent(const Event &event)
@@ -187,19 +269,134 @@ void SceneGraphNode::handleEventChildren(const Event &event)
         child->handleEvent(event);
 }
 
+void SceneGraphNode::setPosition(float x, float y)
+{
+    mTransformable.setPosition(x, y);
+    markWorldTransformDirty();
+}
+
+void SceneGraphNode::setPosition(const sf::Vector2f& position)
+{
+    mTransformable.setPosition(position);
+    markWorldTransformDirty();
+}
+
+void SceneGraphNode::move(float offsetX, float offsetY)
+{
+    mTransformable.move(offsetX, offsetY);
+    markWorldTransformDirty();
+}
+
+void SceneGraphNode::move(const sf::Vector2f& offset)
+{
+    mTransformable.move(offset);
+    markWorldTransformDirty();
+}
+
+void SceneGraphNode::setRotation(float angle)
+{
+    mTransformable.setRotation(angle);
+    markWorldTransformDirty();
+}
+
+void SceneGraphNode::rotate(float angle)
+{
+    mTransformable.rotate(angle);
+    markWorldTransformDirty();
+}
+
+void SceneGraphNode::setScale(float factorX, float factorY)
+{
+    mTransformable.setScale(factorX, factorY);
+    markWorldTransformDirty();
+}
+
+void SceneGraphNode::setScale(const sf::Vector2f& factors)
+{
+    mTransformable.setScale(factors);
+    markWorldTransformDirty();
+}
+
+void SceneGraphNode::scale(float factorX, float factorY)
+{
+    mTransformable.scale(factorX, factorY);
+    markWorldTransformDirty();
+}
+
+void SceneGraphNode::scale(const sf::Vector2f& factor)
+{
+    mTransformable.scale(factor);
+    markWorldTransformDirty();
+}
+
+void SceneGraphNode::setOrigin(float x, float y)
+{
+    mTransformable.setOrigin(x, y);
+    markWorldTransformDirty();
+}
+
+void SceneGraphNode::setOrigin(const sf::Vector2f& origin)
+{
+    mTransformable.setOrigin(origin);
+    markWorldTransformDirty();
+}
+
+void SceneGraphNode::setTransformable(const sf::Transformable& transformable)
+{
+    mTransformable = transformable;
+    markWorldTransformDirty();
+}
+
+// Called at the start of each simulation step, so that the nodes can be drawn between the last two steps
+void SceneGraphNode::savePreviousTransforms()
+{
+    mPreviousTransformable = mTransformable;
+    
+    for (Ptr& child : mChildren)
+        child->savePreviousTransforms();
+}
+
+// The node is drawn at its current transform until the next step, with no interpolation from the previous one
+void SceneGraphNode::resetInterpolation()
+{
+    mPreviousTransformable = mTransformable;
+}
+
+const sf::Transformable& SceneGraphNode::getTransformable() const
+{
+    return mTransformable;
+}
+
+void SceneGraphNode::markWorldTransformDirty()
+{
+    // A dirty node always has all of its descendants dirty, so there is no need to go down again
+    if (mWorldTransformDirty)
+        return;
+    
+    mWorldTransformDirty = true;
+    
+    for (Ptr& child : mChildren)
+        child->markWorldTransformDirty();
+}
+
 sf::Vector2f SceneGraphNode::getWorldPosition() const
 {
     return getWorldTransform() * sf::Vector2f();
 }
 
-sf::Transform SceneGraphNode::getWorldTransform() const
+const sf::Transform& SceneGraphNode::getWorldTransform() const
 {
-    sf::Transform worldTransform = sf::Transform::Identity;
-
-    for (const SceneGraphNode* node = this; node != nullptr; node = node->mParent)
-        worldTransform = node->mTransformable.getTransform() * worldTransform;
+    // Recompute the matrix only if this node or any of its ancestors has changed since the last call
+    if (mWorldTransformDirty) {
+        if (mParent)
+            mWorldTransform = mParent->getWorldTransform() * mTransformable.getTransform();
+        else
+            mWorldTransform = mTransformable.getTransform();
+        
+        mWorldTransformDirty = false;
+    }
     
-    return worldTransform;
+    return mWorldTransform;
 }
 
 SceneGraphNode& SceneGraphNode::getParent()
@@ -0,0 +1,277 @@
+#include <X-GSD/SceneLoader.hpp>
+
+#include <SFML/Audio/InputSoundFile.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <chrono>
+#include <cassert>
+
+using namespace xgsd;
+
+namespace {
+    
+    // Sorts the resources of the scene by type. Their names and paths were checked when compiled
+    void readResources(SceneLoader::LoadedScene& scene)
+    {
+        const SceneFile& file = scene.file;
+        
+        if (file.getResourceCount() == 0)
+            DBGMSGC("No resources to load on this scene");
+        
+        for (std::size_t i = 0; i < file.getResourceCount(); ++i) {
+            const SceneFile::ResourceRecord& resource = file.getResource(i);
+            SceneLoader::File resourceFile{ file.getString(resource.name), file.getString(resource.path), ContentHash(), std::vector<char>() };
+            
+            switch (resource.type) {
+                case SceneFile::TextureResource:
+                    scene.textureFiles.push_back(std::move(resourceFile));
+                    break;
+                case SceneFile::AtlasTextureResource:
+                    scene.atlasFiles.push_back(std::move(resourceFile));
+                    break;
+                case SceneFile::FontResource:
+                    scene.fontFiles.push_back(std::move(resourceFile));
+                    break;
+                default:
+                    scene.soundFiles.push_back(std::move(resourceFile));
+                    break;
+            }
+        }
+    }
+    
+    /* Moves the files whose resource is cached (by path, or else by content) to the cached resources, and reads
+     the content of the rest. Placeholders are only looked up by path, as they do not depend on the content.
+     Textures packed in an atlas are only reused by the files to be packed too (see ResourceCache). */
+    template <typename Resource>
+    void findCached(std::vector<SceneLoader::File>& files, bool placeholder, bool acceptPacked, std::vector<std::pair<std::string, std::shared_ptr<Resource>>>& cached, std::atomic<std::size_t>& loadedSteps)
+    {
+        typedef ResourceCache<Resource> Cache;
+        
+        std::vector<SceneLoader::File> remaining;
+        
+        for (auto& file : files) {
+            bool packed = false;
+            typename Cache::Handle resource = Cache::find(file.path, placeholder, acceptPacked);
+            
+            if (!resource) {
+                if (!Cache::readFile(resourcePath() + file.path, file.content))
+                    throw std::runtime_error("ResourceManager::load - Failed to load " + resourcePath() + file.path);
+                
+                file.hash = Cache::hashContent(file.content);
+                
+                if (!placeholder && (resource = Cache::findContent(file.hash, acceptPacked, &packed)))
+                    Cache::add(file.path, false, packed, file.hash, resource);
+            }
+            
+            // Cached files skip decoding, so they take both steps
+            if (resource) {
+                cached.push_back(std::make_pair(file.name, resource));
+                ++loadedSteps;
+            }
+            else
+                remaining.push_back(std::move(file));
+            
+            ++loadedSteps;
+        }
+        
+        files.swap(remaining);
+    }
+    
+    bool decodeImage(sf::Image& image, SceneLoader::File& file)
+    {
+        return image.loadFromMemory(file.content.data(), file.content.size());
+    }
+    
+    // Fonts are only opened, their glyphs are rendered to textures when used. Not from memory, as it would have to be kept
+    bool decodeFont(std::unique_ptr<sf::Font>& font, SceneLoader::File& file)
+    {
+        font.reset(new sf::Font());
+        return font->loadFromFile(resourcePath() + file.path);
+    }
+    
+    bool decodeSound(SceneLoader::SoundData& sound, SceneLoader::File& file)
+    {
+        sf::InputSoundFile soundFile;
+        
+        if (!soundFile.openFromMemory(file.content.data(), file.content.size()))
+            return false;
+        
+        sound.samples.resize((std::size_t)soundFile.getSampleCount());
+        sound.channelCount = soundFile.getChannelCount();
+        sound.sampleRate = soundFile.getSampleRate();
+        
+        return soundFile.read(sound.samples.data(), sound.samples.size()) == sound.samples.size();
+    }
+    
+} // anonymous namespace
+
+SceneLoader::SceneLoader()
+: mThreadPool()
+, mLoadedSteps(0)
+, mTotalSteps(0)
+, mResult()
+{
+    // Load resources here (RAII)
+}
+
+/* Starts loading the scene on another thread. If a scene was already being loaded, it is waited for and
+ discarded. The atlas page size is ignored in placeholder mode (see TextureManager::getAtlasPageSize). */
+void SceneLoader::start(const std::string& path, bool placeholderMode, unsigned int atlasPageSize)
+{
+    if (mResult.valid())
+        mResult.wait();
+    
+    mLoadedSteps = 0;
+    mTotalSteps = 0;
+    mResult = std::async(std::launch::async, &SceneLoader::load, this, path, placeholderMode, atlasPageSize);
+}
+
+// Waits until the scene has been loaded, and returns it. Rethrows any error found while loading
+std::unique_ptr<SceneLoader::LoadedScene> SceneLoader::finish()
+{
+    assert(mResult.valid() && "No scene is being loaded");
+    return mResult.get();
+}
+
+// If a scene has been started and not finished yet (it may be loaded already, waiting for finish)
+bool SceneLoader::isLoading() const
+{
+    return mResult.valid();
+}
+
+bool SceneLoader::isFinished() const
+{
+    return mResult.valid() && mResult.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+// From 0 to 1
+float SceneLoader::getProgress() const
+{
+    std::size_t total = mTotalSteps;
+    return total > 0 ? (float)mLoadedSteps / total : 0.f;
+}
+
+/* Scene files ending with ".json" are parsed and compiled, any other is loaded as a compiled scene file (see
+ tools/SceneCompiler.cpp). */
+std::unique_ptr<SceneLoader::LoadedScene> SceneLoader::load(const std::string& path, bool placeholderMode, unsigned int atlasPageSize)
+{
+    std::unique_ptr<LoadedScene> scene(new LoadedScene());
+    scene->path = path;
+    scene->placeholderMode = placeholderMode;
+    
+    const std::string jsonExtension = ".json";
+    
+    if (path.size() >= jsonExtension.size() && path.compare(path.size() - jsonExtension.size(), jsonExtension.size(), jsonExtension) == 0) {
+        DBGMSGC("Scene JSON file to parse: " << resourcePath() << path);
+        
+        // Compiled while parsed, without building a document (see SceneFile::compile)
+        std::ifstream jsonFile(resourcePath() + path, std::ifstream::binary);
+        std::vector<char> text((std::istreambuf_iterator<char>(jsonFile)), std::istreambuf_iterator<char>());
+        
+        scene->file.loadFromMemory(SceneFile::compile(text.data(), text.data() + text.size(), resourcePath() + path));
+    }
+    else {
+        DBGMSGC("Compiled scene file to load: " << resourcePath() << path);
+        scene->file.loadFromFile(resourcePath() + path);
+    }
+    
+    readResources(*scene);
+    
+    // Reading the scene, reading and decoding every file, and packing the atlas
+    mTotalSteps = 2 + 2 * (scene->textureFiles.size() + scene->atlasFiles.size() + scene->fontFiles.size() + scene->soundFiles.size());
+    ++mLoadedSteps;
+    
+    findCachedFiles(*scene);
+    decodeFiles(*scene);
+    
+    if (!placeholderMode)
+        scene->atlasLayout = TextureManager::packAtlas(scene->atlasImages, atlasPageSize);
+    
+    ++mLoadedSteps;
+    
+    return scene;
+}
+
+// Reads the files one after another (or finds them in the cache). Fonts and sounds are left to their managers in placeholder mode
+void SceneLoader::findCachedFiles(LoadedScene& scene)
+{
+    findCached(scene.textureFiles, scene.placeholderMode, false, scene.cachedTextures, mLoadedSteps);
+    findCached(scene.atlasFiles, scene.placeholderMode, true, scene.cachedTextures, mLoadedSteps);
+    
+    if (!scene.placeholderMode) {
+        findCached(scene.fontFiles, false, false, scene.cachedFonts, mLoadedSteps);
+        findCached(scene.soundFiles, false, false, scene.cachedSounds, mLoadedSteps);
+    }
+    else
+        mLoadedSteps += scene.fontFiles.size() + scene.soundFiles.size();
+}
+
+/* Decodes the files read on the threads of the pool, one file per task. The pool is only made the first time
+ there are several files to decode, so that games which never load one in the background start no workers. */
+void SceneLoader::decodeFiles(LoadedScene& scene)
+{
+    std::size_t textureCount = scene.textureFiles.size();
+    std::size_t imageCount = textureCount + scene.atlasFiles.size();
+    std::size_t fontCount = scene.fontFiles.size();
+    std::size_t count = imageCount + fontCount + scene.soundFiles.size();
+    
+    std::vector<char> failed(count, false);
+    scene.textures.resize(textureCount);
+    scene.atlasImages.resize(scene.atlasFiles.size());
+    
+    if (!scene.placeholderMode) {
+        scene.fonts.resize(fontCount);
+        scene.sounds.resize(scene.soundFiles.size());
+    }
+    
+    // The file of each task, in the same order
+    auto getFile = [&scene, textureCount, imageCount, fontCount] (std::size_t i) -> File& {
+        if (i < textureCount)
+            return scene.textureFiles[i];
+        else if (i < imageCount)
+            return scene.atlasFiles[i - textureCount];
+        else if (i < imageCount + fontCount)
+            return scene.fontFiles[i - imageCount];
+        else
+            return scene.soundFiles[i - imageCount - fontCount];
+    };
+    
+    auto decode = [&] (std::size_t begin, std::size_t end, std::size_t) {
+        for (std::size_t i = begin; i < end; ++i) {
+            File& file = getFile(i);
+            bool decoded = true;
+            
+            if (i < textureCount)
+                decoded = decodeImage(scene.textures[i], file);
+            else if (i < imageCount)
+                decoded = decodeImage(scene.atlasImages[i - textureCount], file);
+            else if (scene.placeholderMode)
+                decoded = true; // Left to the placeholder mode of the resource managers
+            else if (i < imageCount + fontCount)
+                decoded = decodeFont(scene.fonts[i - imageCount], file);
+            else
+                decoded = decodeSound(scene.sounds[i - imageCount - fontCount], file);
+            
+            std::vector<char>().swap(file.content);
+            
+            failed[i] = !decoded;
+            ++mLoadedSteps;
+        }
+    };
+    
+    if (count > 1 && !mThreadPool)
+        mThreadPool.reset(new ThreadPool(0));
+    
+    if (count > 1)
+        mThreadPool->parallelFor(count, 1, decode);
+    else
+        decode(0, count, 0);
+    
+    // Report the first file which failed, as the resource managers would
+    for (std::size_t i = 0; i < count; ++i) {
+        if (failed[i])
+            throw std::runtime_error("ResourceManager::load - Failed to load " + resourcePath() + getFile(i).path);
+    }
+}
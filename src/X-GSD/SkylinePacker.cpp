@@ -0,0 +1,110 @@
+#include <X-GSD/SkylinePacker.hpp>
+
+#include <algorithm>
+#include <limits>
+
+using namespace xgsd;
+
+SkylinePacker::SkylinePacker(sf::Vector2u size)
+: mSize(size)
+, mUsedSize()
+, mSkyline(1, Segment{ 0, 0, size.x })
+{
+    // Load resources here (RAII)
+}
+
+// Finds a place for a rectangle of the given size and reserves it. Returns false if it does not fit anywhere
+bool SkylinePacker::insert(sf::Vector2u size, sf::Vector2u& position)
+{
+    if (size.x == 0 || size.y == 0)
+        return false;
+    
+    std::size_t bestIndex = mSkyline.size();
+    unsigned int bestTop = std::numeric_limits<unsigned int>::max();
+    unsigned int bestY = 0;
+    
+    for (std::size_t index = 0; index < mSkyline.size(); ++index) {
+        unsigned int y;
+        
+        if (fits(index, size, y) && y + size.y < bestTop) {
+            bestIndex = index;
+            bestTop = y + size.y;
+            bestY = y;
+        }
+    }
+    
+    if (bestIndex == mSkyline.size())
+        return false;
+    
+    position = sf::Vector2u(mSkyline[bestIndex].x, bestY);
+    addSegment(bestIndex, Segment{ position.x, bestTop, size.x });
+    
+    mUsedSize.x = std::max(mUsedSize.x, position.x + size.x);
+    mUsedSize.y = std::max(mUsedSize.y, bestTop);
+    
+    return true;
+}
+
+sf::Vector2u SkylinePacker::getUsedSize() const
+{
+    return mUsedSize;
+}
+
+// Checks if a rectangle fits with its left edge at the start of the segment. If so, y is where its top would be
+bool SkylinePacker::fits(std::size_t index, sf::Vector2u size, unsigned int& y) const
+{
+    if (mSkyline[index].x + size.x > mSize.x)
+        return false;
+    
+    // The rectangle rests on the highest of the segments below it
+    unsigned int remainingWidth = size.x;
+    y = 0;
+    
+    for (std::size_t i = index; remainingWidth > 0; ++i) {
+        y = std::max(y, mSkyline[i].y);
+        
+        if (y + size.y > mSize.y)
+            return false;
+        
+        remainingWidth -= std::min(remainingWidth, mSkyline[i].width);
+    }
+    
+    return true;
+}
+
+// Inserts the segment at the top of a new rectangle, removing or cutting the ones it covers
+void SkylinePacker::addSegment(std::size_t index, const Segment& segment)
+{
+    mSkyline.insert(mSkyline.begin() + index, segment);
+    
+    unsigned int end = segment.x + segment.width;
+    
+    for (std::size_t i = index + 1; i < mSkyline.size();) {
+        Segment& next = mSkyline[i];
+        
+        if (next.x >= end)
+            break;
+        
+        unsigned int covered = end - next.x;
+        
+        if (covered >= next.width) {
+            mSkyline.erase(mSkyline.begin() + i);
+        }
+        else {
+            next.x += covered;
+            next.width -= covered;
+            break;
+        }
+    }
+    
+    // Merge the neighbour segments at the same height
+    for (std::size_t i = 0; i + 1 < mSkyline.size();) {
+        if (mSkyline[i].y == mSkyline[i + 1].y) {
+            mSkyline[i].width += mSkyline[i + 1].width;
+            mSkyline.erase(mSkyline.begin() + i + 1);
+        }
+        else {
+            ++i;
+        }
+    }
+}
@@ -0,0 +1,122 @@
+#include <X-GSD/SpriteBatch.hpp>
+
+#include <cmath>
+
+using namespace xgsd;
+
+SpriteBatch::SpriteBatch()
+: mBatches()
+, mActiveBatches(0)
+, mDrawCalls(0)
+, mSprites(0)
+, mEnabled(true)
+{
+    // Load resources here (RAII)
+}
+
+// Adds the sprite as it would be drawn with target.draw(sprite, states). States with a shader are not supported
+void SpriteBatch::add(const sf::Sprite& sprite, const sf::RenderStates& states)
+{
+    assert(!states.shader);
+    
+    const sf::Texture* texture = sprite.getTexture();
+    
+    if (!texture)
+        return;
+    
+    // Same vertices as sf::Sprite: its local bounds, mapped to the texture rect (which may be flipped)
+    sf::Transform transform = states.transform * sprite.getTransform();
+    sf::IntRect textureRect = sprite.getTextureRect();
+    sf::Color color = sprite.getColor();
+    
+    float width = std::abs((float)textureRect.width);
+    float height = std::abs((float)textureRect.height);
+    float left = (float)textureRect.left;
+    float top = (float)textureRect.top;
+    float right = left + textureRect.width;
+    float bottom = top + textureRect.height;
+    
+    sf::Vertex topLeft(transform.transformPoint(0.f, 0.f), color, sf::Vector2f(left, top));
+    sf::Vertex bottomLeft(transform.transformPoint(0.f, height), color, sf::Vector2f(left, bottom));
+    sf::Vertex topRight(transform.transformPoint(width, 0.f), color, sf::Vector2f(right, top));
+    sf::Vertex bottomRight(transform.transformPoint(width, height), color, sf::Vector2f(right, bottom));
+    
+    std::vector<sf::Vertex>& vertices = getBatch(texture, states.blendMode).vertices;
+    vertices.push_back(topLeft);
+    vertices.push_back(bottomLeft);
+    vertices.push_back(topRight);
+    vertices.push_back(topRight);
+    vertices.push_back(bottomLeft);
+    vertices.push_back(bottomRight);
+}
+
+// Draws every batch with one draw call, and empties them
+void SpriteBatch::flush(sf::RenderTarget& target)
+{
+    for (std::size_t i = 0; i < mActiveBatches; ++i) {
+        Batch& batch = mBatches[i];
+        
+        // The vertices are already in world coordinates
+        sf::RenderStates states(batch.blendMode);
+        states.texture = batch.texture;
+        
+        target.draw(batch.vertices.data(), batch.vertices.size(), sf::Triangles, states);
+        mSprites += batch.vertices.size() / 6;
+        ++mDrawCalls;
+        batch.vertices.clear();
+    }
+    
+    mActiveBatches = 0;
+}
+
+bool SpriteBatch::isEmpty() const
+{
+    return mActiveBatches == 0;
+}
+
+// If disabled, sprites are drawn one by one (see RenderCommandList::replay)
+void SpriteBatch::setEnabled(bool option)
+{
+    mEnabled = option;
+}
+
+bool SpriteBatch::isEnabled() const
+{
+    return mEnabled;
+}
+
+void SpriteBatch::resetStatistics()
+{
+    mDrawCalls = 0;
+    mSprites = 0;
+}
+
+std::size_t SpriteBatch::getDrawCallCount() const
+{
+    return mDrawCalls;
+}
+
+std::size_t SpriteBatch::getSpriteCount() const
+{
+    return mSprites;
+}
+
+// The last active batch if it has the same texture and blend mode, otherwise a new one, so that the drawing order is kept
+SpriteBatch::Batch& SpriteBatch::getBatch(const sf::Texture* texture, const sf::BlendMode& blendMode)
+{
+    if (mActiveBatches > 0) {
+        Batch& last = mBatches[mActiveBatches - 1];
+        
+        if (last.texture == texture && last.blendMode == blendMode)
+            return last;
+    }
+    
+    if (mActiveBatches == mBatches.size())
+        mBatches.push_back(Batch());
+    
+    Batch& batch = mBatches[mActiveBatches++];
+    batch.texture = texture;
+    batch.blendMode = blendMode;
+    
+    return batch;
+}
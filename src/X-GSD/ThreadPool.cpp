@@ -0,0 +1,143 @@
+#include <X-GSD/ThreadPool.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+using namespace xgsd;
+
+ThreadPool::ThreadPool(std::size_t threadCount)
+: mWorkers()
+, mTask(nullptr)
+, mCount(0)
+, mChunkSize(1)
+, mNextIndex(0)
+, mBusyWorkers(0)
+, mGeneration(0)
+, mStopping(false)
+{
+    // Load resources here (RAII)
+    setThreadCount(threadCount);
+}
+
+// Total number of threads, including the calling one. 0 uses one thread per hardware core
+void ThreadPool::setThreadCount(std::size_t threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    
+    if (threadCount == getThreadCount())
+        return;
+    
+    stopWorkers();
+    startWorkers(threadCount - 1);
+}
+
+std::size_t ThreadPool::getThreadCount() const
+{
+    return mWorkers.size() + 1;
+}
+
+void ThreadPool::parallelFor(std::size_t count, std::size_t chunkSize, const Task& task)
+{
+    assert(chunkSize > 0);
+    
+    // Not worth waking up the workers
+    if (mWorkers.empty() || count <= chunkSize) {
+        if (count > 0)
+            task(0, count, 0);
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTask = &task;
+        mCount = count;
+        mChunkSize = chunkSize;
+        mNextIndex = 0;
+        mBusyWorkers = mWorkers.size();
+        ++mGeneration;
+    }
+    mWorkAvailable.notify_all();
+    
+    // The calling thread works too
+    runChunks(0);
+    
+    // Wait for the workers to finish their last chunk
+    std::unique_lock<std::mutex> lock(mMutex);
+    mWorkFinished.wait(lock, [this] { return mBusyWorkers == 0; });
+    mTask = nullptr;
+}
+
+// The workers start from the current generation, read here: if they read it once running, a parallelFor called
+// meanwhile would be taken as already done, and wait for them forever
+void ThreadPool::startWorkers(std::size_t workerCount)
+{
+    std::uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = false;
+        generation = mGeneration;
+    }
+    
+    for (std::size_t i = 0; i < workerCount; ++i)
+        mWorkers.emplace_back(&ThreadPool::workerLoop, this, i + 1, generation);
+}
+
+void ThreadPool::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mWorkAvailable.notify_all();
+    
+    for (auto& worker : mWorkers)
+        worker.join();
+    
+    mWorkers.clear();
+}
+
+void ThreadPool::workerLoop(std::size_t thread, std::uint64_t lastGeneration)
+{
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWorkAvailable.wait(lock, [&] { return mStopping || mGeneration != lastGeneration; });
+            
+            if (mStopping)
+                return;
+            
+            lastGeneration = mGeneration;
+        }
+        
+        runChunks(thread);
+        
+        bool lastWorker;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            lastWorker = --mBusyWorkers == 0;
+        }
+        
+        if (lastWorker)
+            mWorkFinished.notify_one();
+    }
+}
+
+// Take chunks until the whole range has been processed
+void ThreadPool::runChunks(std::size_t thread)
+{
+    while (true) {
+        std::size_t begin = mNextIndex.fetch_add(mChunkSize);
+        
+        if (begin >= mCount)
+            return;
+        
+        (*mTask)(begin, std::min(begin + mChunkSize, mCount), thread);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    // Cleanup
+    stopWorkers();
+}
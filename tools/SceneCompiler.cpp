@@ -0,0 +1,79 @@
+// SceneCompiler.cpp - Compiles JSON scene files to the binary format of SceneFile, which the game loads without
+// parsing (see Scene::loadSceneFromFile). Needs the SFML headers. Build it from the root of the repository:
+//
+//   c++ -std=c++11 -O2 -Iinclude tools/SceneCompiler.cpp src/X-GSD/SceneFile.cpp src/X-GSD/JsonReader.cpp -o SceneCompiler
+//
+// and run it on the scenes. Each one is written next to its JSON file, with the ".xgsc" extension:
+//
+//   ./SceneCompiler resources/scenes/*.json
+
+#include <X-GSD/SceneFile.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+using namespace xgsd;
+
+namespace {
+
+    std::string getOutputPath(const std::string& inputPath)
+    {
+        std::string::size_type dot = inputPath.rfind('.');
+        std::string::size_type slash = inputPath.find_last_of("/\\");
+
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+            return inputPath + ".xgsc";
+
+        return inputPath.substr(0, dot) + ".xgsc";
+    }
+
+    void compileScene(const std::string& inputPath)
+    {
+        std::ifstream input(inputPath, std::ifstream::binary);
+        if (!input)
+            throw std::runtime_error("Failed to open " + inputPath);
+
+        std::vector<char> text((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+        std::vector<char> data = SceneFile::compile(text.data(), text.data() + text.size(), inputPath);
+
+        // Loaded back, so that anything the game would reject is reported now
+        std::size_t size = data.size();
+        SceneFile check;
+        check.loadFromMemory(data);
+
+        std::string outputPath = getOutputPath(inputPath);
+        std::ofstream output(outputPath, std::ofstream::binary | std::ofstream::trunc);
+        if (!output.write(data.data(), data.size()))
+            throw std::runtime_error("Failed to write " + outputPath);
+
+        std::cout << inputPath << " -> " << outputPath << " (" << check.getEntityCount() << " entities, " << size << " bytes)" << std::endl;
+    }
+
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " scene.json..." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    int result = EXIT_SUCCESS;
+
+    for (int i = 1; i < argc; ++i) {
+        try {
+            compileScene(argv[i]);
+        }
+        catch (std::exception& e) {
+            std::cerr << "EXCEPTION: " << e.what() << std::endl;
+            result = EXIT_FAILURE;
+        }
+    }
+
+    return result;
+}